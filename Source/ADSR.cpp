@@ -156,18 +156,12 @@ float ::ADSR::Value(double time, const EventInfo* e) const
 
    //PROFILER(ADSR_Value);
 
-   float stageStartValue;
    double stageStartTime;
    int stage = GetStage(time, stageStartTime, e);
    if (stage == mNumStages) //done
       return mStages[stage - 1].target;
 
-   if (stage == 0)
-      stageStartValue = e->mStartBlendFromValue;
-   else if (mHasSustainStage && stage == mSustainStage + 1 && e->mStopBlendFromValue != std::numeric_limits<float>::max())
-      stageStartValue = e->mStopBlendFromValue;
-   else
-      stageStartValue = mStages[stage - 1].target * e->mMult;
+   float stageStartValue = GetStageStartValue(stage, e);
 
    if (mHasSustainStage && stage == mSustainStage && time > stageStartTime + (mStages[mSustainStage].time * GetStageTimeScale(mSustainStage)))
       return mStages[mSustainStage].target * e->mMult;
@@ -181,6 +175,90 @@ float ::ADSR::Value(double time, const EventInfo* e) const
    return ofLerp(stageStartValue, mStages[stage].target * e->mMult, lerp);
 }
 
+void ::ADSR::FillBuffer(double time, double timeStep, float* values, int numSamples) const
+{
+   //PROFILER(ADSR_FillBuffer);
+
+   int i = 0;
+   while (i < numSamples)
+   {
+      //work out which event and stage we're in, and the times where that could change
+      const EventInfo* e = GetEventConst(time);
+
+      double nextEventTime = std::numeric_limits<double>::max();
+      for (const auto& other : mEvents)
+      {
+         if (other.mStartTime >= time && other.mStartTime < nextEventTime)
+            nextEventTime = other.mStartTime;
+      }
+
+      double stageStartTime;
+      int stage = GetStage(time, stageStartTime, e);
+
+      double stopTime = std::numeric_limits<double>::max();
+      if (mHasSustainStage && e->mStopTime > e->mStartTime && time < e->mStopTime)
+         stopTime = e->mStopTime;
+
+      bool holding = true;
+      float value = 0;
+      if (stage == mNumStages) //done
+         value = mStages[stage - 1].target;
+      else if (mHasSustainStage && stage == mSustainStage && time > stageStartTime + (mStages[mSustainStage].time * GetStageTimeScale(mSustainStage)))
+         value = mStages[mSustainStage].target * e->mMult;
+      else
+         holding = false;
+
+      int segmentStart = i;
+      if (holding)
+      {
+         for (; i < numSamples; ++i)
+         {
+            if (time >= stopTime || time > nextEventTime)
+               break;
+            values[i] = value;
+            time += timeStep;
+         }
+      }
+      else
+      {
+         float stageDuration = mStages[stage].time * GetStageTimeScale(stage);
+         double stageEndTime = stageStartTime + stageDuration;
+         float stageStartValue = GetStageStartValue(stage, e);
+         float stageTarget = mStages[stage].target * e->mMult;
+         float curveExponent = 1; //MathUtils::Curve(), with the exponent worked out once for the segment
+         if (mStages[stage].curve != 0)
+            curveExponent = expf(-2 * mStages[stage].curve * ((stageStartValue < stageTarget) ? 1 : -1));
+
+         for (; i < numSamples; ++i)
+         {
+            if (time > stageEndTime || time >= stopTime || time > nextEventTime)
+               break;
+            float lerp = ofClamp((time - stageStartTime) / stageDuration, 0, 1);
+            if (curveExponent != 1)
+               lerp = powf(lerp, curveExponent);
+            values[i] = ofLerp(stageStartValue, stageTarget, lerp);
+            time += timeStep;
+         }
+      }
+
+      if (i == segmentStart) //shouldn't happen, but make sure we always make progress
+      {
+         values[i] = Value(time, e);
+         time += timeStep;
+         ++i;
+      }
+   }
+}
+
+float ::ADSR::GetStageStartValue(int stage, const EventInfo* e) const
+{
+   if (stage == 0)
+      return e->mStartBlendFromValue;
+   if (mHasSustainStage && stage == mSustainStage + 1 && e->mStopBlendFromValue != std::numeric_limits<float>::max())
+      return e->mStopBlendFromValue;
+   return mStages[stage - 1].target * e->mMult;
+}
+
 float ::ADSR::GetStageTimeScale(int stage) const
 {
    if (stage >= mNumStages - 1)
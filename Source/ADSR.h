@@ -84,6 +84,8 @@ public:
    void Stop(double time, bool warn = true);
    float Value(double time) const;
    float Value(double time, const EventInfo* event) const;
+   //same as calling Value() at time, time + timeStep, time + timeStep * 2, etc, but only works out the stage where it changes
+   void FillBuffer(double time, double timeStep, float* values, int numSamples) const;
    void Set(float a, float d, float s, float r, float h = -1);
    void Set(const ADSR& other);
    void Clear()
@@ -124,6 +126,7 @@ private:
    EventInfo* GetEvent(double time);
    const EventInfo* GetEventConst(double time) const;
    float GetStageTimeScale(int stage) const;
+   float GetStageStartValue(int stage, const EventInfo* e) const;
 
    std::array<EventInfo, 5> mEvents;
    int mNextEventPointer{ 0 };
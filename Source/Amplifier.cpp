@@ -56,13 +56,19 @@ void Amplifier::Process(double time)
    if (target)
    {
       ChannelBuffer* out = target->GetBuffer();
+      const float* gains = mGainSlider->ComputeBlock(); //nullptr if the gain is steady this buffer
       for (int ch = 0; ch < GetBuffer()->NumActiveChannels(); ++ch)
       {
          auto getBufferChannelCh = GetBuffer()->GetChannel(ch);
-         for (int i = 0; i < bufferSize; ++i)
+         if (gains != nullptr)
          {
-            ComputeSliders(i);
-            gWorkBuffer[i] = getBufferChannelCh[i] * mGain;
+            for (int i = 0; i < bufferSize; ++i)
+               gWorkBuffer[i] = getBufferChannelCh[i] * gains[i];
+         }
+         else
+         {
+            for (int i = 0; i < bufferSize; ++i)
+               gWorkBuffer[i] = getBufferChannelCh[i] * mGain;
          }
          Add(out->GetChannel(ch), gWorkBuffer, GetBuffer()->BufferSize());
          GetVizBuffer()->WriteChunk(gWorkBuffer, GetBuffer()->BufferSize(), ch);
@@ -46,6 +46,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
 
    //IFloatSliderListener
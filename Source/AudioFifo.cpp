@@ -0,0 +1,90 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  AudioFifo.cpp
+//  Bespoke
+//
+//
+
+#include "AudioFifo.h"
+
+#include <algorithm>
+
+void AudioFifo::SetUp(int numChannels, int capacity)
+{
+   mChannels.assign(numChannels, std::vector<float>(capacity, 0));
+   mCapacity = capacity;
+   Clear();
+}
+
+void AudioFifo::Clear()
+{
+   mReadPos = 0;
+   mNumReady = 0;
+}
+
+int AudioFifo::Write(const float* const* data, int numChannels, int numSamples)
+{
+   numSamples = std::min(numSamples, mCapacity - mNumReady);
+   int writePos = (mReadPos + mNumReady) % std::max(mCapacity, 1);
+   int firstPart = std::min(numSamples, mCapacity - writePos);
+   for (int ch = 0; ch < (int)mChannels.size(); ++ch)
+   {
+      float* dest = mChannels[ch].data();
+      if (ch < numChannels)
+      {
+         std::copy(data[ch], data[ch] + firstPart, dest + writePos);
+         std::copy(data[ch] + firstPart, data[ch] + numSamples, dest);
+      }
+      else
+      {
+         std::fill(dest + writePos, dest + writePos + firstPart, 0.0f);
+         std::fill(dest, dest + numSamples - firstPart, 0.0f);
+      }
+   }
+   mNumReady += numSamples;
+   return numSamples;
+}
+
+int AudioFifo::WriteSilence(int numSamples)
+{
+   return Write(nullptr, 0, numSamples);
+}
+
+int AudioFifo::Read(float* const* data, int numChannels, int numSamples)
+{
+   int numRead = std::min(numSamples, mNumReady);
+   int firstPart = std::min(numRead, mCapacity - mReadPos);
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      if (ch < (int)mChannels.size())
+      {
+         const float* source = mChannels[ch].data();
+         std::copy(source + mReadPos, source + mReadPos + firstPart, data[ch]);
+         std::copy(source, source + numRead - firstPart, data[ch] + firstPart);
+         std::fill(data[ch] + numRead, data[ch] + numSamples, 0.0f);
+      }
+      else
+      {
+         std::fill(data[ch], data[ch] + numSamples, 0.0f);
+      }
+   }
+   mReadPos = (mReadPos + numRead) % std::max(mCapacity, 1);
+   mNumReady -= numRead;
+   return numRead;
+}
@@ -0,0 +1,49 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  AudioFifo.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <vector>
+
+//multichannel first-in-first-out sample queue, for handing audio between buffers of different sizes.
+//not thread safe: the writer and the reader are expected to be the same thread.
+class AudioFifo
+{
+public:
+   void SetUp(int numChannels, int capacity);
+   void Clear();
+
+   int GetNumReady() const { return mNumReady; }
+   int GetCapacity() const { return mCapacity; }
+
+   //these return how many samples were actually written/read. Read() fills anything it couldn't read with silence.
+   int Write(const float* const* data, int numChannels, int numSamples);
+   int WriteSilence(int numSamples);
+   int Read(float* const* data, int numChannels, int numSamples);
+
+private:
+   std::vector<std::vector<float> > mChannels;
+   int mCapacity{ 0 };
+   int mReadPos{ 0 };
+   int mNumReady{ 0 };
+};
@@ -0,0 +1,416 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  AudioGraphExecutor.cpp
+//  Bespoke
+//
+//
+
+#include "AudioGraphExecutor.h"
+#include "IAudioSource.h"
+#include "IAudioReceiver.h"
+#include "INoteSource.h"
+#include "IPulseReceiver.h"
+#include "IModulator.h"
+#include "IDrawableModule.h"
+#include "PatchCableSource.h"
+#include "Slider.h"
+#include "SynthGlobals.h"
+
+#include "juce_audio_basics/juce_audio_basics.h"
+
+#include <map>
+#include <set>
+
+#if BESPOKE_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+   thread_local bool sIsWorkerThread = false;
+
+   const int kSpinsBeforeYield = 64;
+
+   void SetAudioThreadPriority(std::thread& thread)
+   {
+      //best effort, this can fail if we don't have permission to use realtime scheduling
+#if BESPOKE_WINDOWS
+      SetThreadPriority((HANDLE)thread.native_handle(), THREAD_PRIORITY_TIME_CRITICAL);
+#else
+      sched_param param;
+      param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+      pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param);
+#endif
+   }
+
+   //sources at the other end of start's note, pulse, modulation and control cables, following them through any
+   //modules that aren't audio sources
+   void GetCableReachedSources(IDrawableModule* start, const std::map<IDrawableModule*, int>& sourceIndices, std::vector<int>& reached)
+   {
+      std::vector<IDrawableModule*> toVisit{ start };
+      std::set<IDrawableModule*> visited{ start };
+      while (!toVisit.empty())
+      {
+         IDrawableModule* module = toVisit.back();
+         toVisit.pop_back();
+
+         for (auto* child : module->GetChildren())
+         {
+            if (visited.insert(child).second)
+               toVisit.push_back(child);
+         }
+
+         for (auto* cableSource : module->GetPatchCableSources())
+         {
+            if (cableSource->GetConnectionType() == kConnectionType_Audio)
+               continue;
+            for (auto* cable : cableSource->GetPatchCables())
+            {
+               IClickable* target = cable->GetTarget();
+               if (target == nullptr)
+                  continue;
+               IDrawableModule* targetModule = target->GetModuleParent();
+               if (targetModule == nullptr || !visited.insert(targetModule).second)
+                  continue;
+               auto iter = sourceIndices.find(targetModule);
+               if (iter != sourceIndices.end())
+                  reached.push_back(iter->second);
+               toVisit.push_back(targetModule);
+            }
+         }
+      }
+   }
+}
+
+AudioGraphExecutor::Plan::Plan(int numBranches)
+: mBranches(numBranches)
+, mPendingPredecessors(new std::atomic<int>[numBranches])
+, mReadyQueue(new std::atomic<int>[numBranches])
+{
+}
+
+AudioGraphExecutor::AudioGraphExecutor()
+{
+}
+
+AudioGraphExecutor::~AudioGraphExecutor()
+{
+   StopWorkers();
+}
+
+//static
+bool AudioGraphExecutor::IsWorkerThread()
+{
+   return sIsWorkerThread;
+}
+
+void AudioGraphExecutor::SetNumThreads(int numThreads)
+{
+   StopWorkers();
+
+   mExit = false;
+   for (int i = 0; i < numThreads - 1; ++i)
+   {
+      mWorkers.push_back(std::thread(&AudioGraphExecutor::WorkerLoop, this));
+      SetAudioThreadPriority(mWorkers.back());
+   }
+}
+
+void AudioGraphExecutor::StopWorkers()
+{
+   {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mExit = true;
+   }
+   mWakeCondition.notify_all();
+   for (auto& worker : mWorkers)
+      worker.join();
+   mWorkers.clear();
+}
+
+//static
+std::unique_ptr<AudioGraphExecutor::Plan> AudioGraphExecutor::BuildPlan(const std::vector<IAudioSource*>& orderedSources)
+{
+   const int numSources = (int)orderedSources.size();
+
+   std::map<IAudioReceiver*, int> receiverIndices;
+   std::map<IDrawableModule*, int> moduleIndices;
+   for (int i = 0; i < numSources; ++i)
+   {
+      IAudioReceiver* receiver = dynamic_cast<IAudioReceiver*>(orderedSources[i]);
+      if (receiver != nullptr)
+         receiverIndices[receiver] = i;
+      IDrawableModule* module = dynamic_cast<IDrawableModule*>(orderedSources[i]);
+      if (module != nullptr)
+         moduleIndices[module] = i;
+   }
+
+   //every edge points from the source that comes first in the serial order to the one that comes later,
+   //so this is always acyclic, even if the patch has a feedback loop
+   std::vector<std::vector<int> > successors(numSources);
+   auto addEdge = [&successors](int a, int b)
+   {
+      if (a == b)
+         return;
+      if (a > b)
+         std::swap(a, b);
+      successors[a].push_back(b);
+   };
+
+   std::map<IAudioReceiver*, int> lastWriterToReceiver;
+   std::map<IModulator*, int> lastModulatedBy;
+   int lastSerialSource = -1;
+   std::vector<int> reached;
+   for (int i = 0; i < numSources; ++i)
+   {
+      IAudioSource* source = orderedSources[i];
+      for (int k = 0; k < source->GetNumTargets(); ++k)
+      {
+         IAudioReceiver* target = source->GetTarget(k);
+         if (target == nullptr)
+            continue;
+
+         auto receiverIter = receiverIndices.find(target);
+         if (receiverIter != receiverIndices.end())
+            addEdge(i, receiverIter->second);
+
+         auto writerIter = lastWriterToReceiver.find(target);
+         if (writerIter != lastWriterToReceiver.end())
+            addEdge(writerIter->second, i);
+         lastWriterToReceiver[target] = i;
+      }
+
+      //sources that send notes or pulses from the audio thread can reach arbitrary modules
+      bool serial = !source->CanProcessInParallel() ||
+                    dynamic_cast<INoteSource*>(source) != nullptr ||
+                    dynamic_cast<IPulseSource*>(source) != nullptr;
+      if (serial)
+      {
+         if (lastSerialSource != -1)
+            addEdge(lastSerialSource, i);
+         lastSerialSource = i;
+      }
+
+      IDrawableModule* module = dynamic_cast<IDrawableModule*>(source);
+      if (module == nullptr)
+         continue;
+
+      //notes, pulses and modulation don't go through buffers, but whatever is on the other end of those cables
+      //gets touched while this source processes
+      reached.clear();
+      GetCableReachedSources(module, moduleIndices, reached);
+      for (int target : reached)
+         addEdge(i, target);
+
+      //a modulator gets evaluated by every module it modulates, so those can't run at the same time either
+      for (auto* control : module->GetUIControls())
+      {
+         FloatSlider* slider = dynamic_cast<FloatSlider*>(control);
+         if (slider == nullptr || slider->GetModulator() == nullptr)
+            continue;
+         auto modulatorIter = lastModulatedBy.find(slider->GetModulator());
+         if (modulatorIter != lastModulatedBy.end())
+            addEdge(modulatorIter->second, i);
+         lastModulatedBy[slider->GetModulator()] = i;
+      }
+   }
+
+   std::vector<int> numPredecessors(numSources, 0);
+   for (auto& nodeSuccessors : successors)
+   {
+      std::sort(nodeSuccessors.begin(), nodeSuccessors.end());
+      nodeSuccessors.erase(std::unique(nodeSuccessors.begin(), nodeSuccessors.end()), nodeSuccessors.end());
+      for (int successor : nodeSuccessors)
+         ++numPredecessors[successor];
+   }
+
+   //collapse chains of sources that can only run one after another into a single branch
+   std::vector<int> branchIndices(numSources, -1);
+   std::vector<std::vector<int> > branchNodes;
+   for (int i = 0; i < numSources; ++i)
+   {
+      if (branchIndices[i] != -1)
+         continue;
+
+      std::vector<int> chain;
+      int node = i;
+      while (true)
+      {
+         chain.push_back(node);
+         branchIndices[node] = (int)branchNodes.size();
+         if (successors[node].size() != 1)
+            break;
+         int next = successors[node][0];
+         if (numPredecessors[next] != 1)
+            break;
+         node = next;
+      }
+      branchNodes.push_back(chain);
+   }
+
+   auto plan = std::make_unique<Plan>((int)branchNodes.size());
+   for (int b = 0; b < (int)branchNodes.size(); ++b)
+   {
+      Branch& branch = plan->mBranches[b];
+      for (int node : branchNodes[b])
+         branch.mSources.push_back(orderedSources[node]);
+      for (int successor : successors[branchNodes[b].back()])
+         branch.mSuccessors.push_back(branchIndices[successor]);
+      branch.mNumPredecessors = numPredecessors[branchNodes[b].front()];
+      if (branch.mNumPredecessors == 0)
+         plan->mRootBranches.push_back(b);
+   }
+
+   return plan;
+}
+
+void AudioGraphExecutor::Process(const Plan* plan, double time)
+{
+   mPlan = plan;
+   const int numBranches = (int)plan->mBranches.size();
+   for (int i = 0; i < numBranches; ++i)
+   {
+      plan->mPendingPredecessors[i].store(plan->mBranches[i].mNumPredecessors, std::memory_order_relaxed);
+      plan->mReadyQueue[i].store(-1, std::memory_order_relaxed);
+   }
+   plan->mReadyWriteIndex.store(0, std::memory_order_relaxed);
+   plan->mReadyReadIndex.store(0, std::memory_order_relaxed);
+   plan->mCompletedBranches.store(0, std::memory_order_relaxed);
+   for (int root : plan->mRootBranches)
+      PushReadyBranch(root);
+
+   mTime = time;
+   mRunning.store(true);
+   {
+      //only held for the bump, so a worker can't check the generation and then go to sleep past it
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mGeneration.fetch_add(1);
+   }
+   mWakeCondition.notify_all();
+
+   RunBranches();
+
+   //wait for any stragglers to leave the plan before it gets reset for the next buffer
+   mRunning.store(false);
+   while (mActiveWorkers.load() > 0)
+      std::this_thread::yield();
+   mPlan = nullptr;
+}
+
+void AudioGraphExecutor::WorkerLoop()
+{
+   sIsWorkerThread = true;
+   juce::FloatVectorOperations::disableDenormalisedNumberSupport();
+
+   int seenGeneration = mGeneration.load();
+   while (true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mWakeMutex);
+         mWakeCondition.wait(lock, [this, seenGeneration]
+                             { return mExit || mGeneration.load() != seenGeneration; });
+      }
+
+      if (mExit)
+         break;
+
+      seenGeneration = mGeneration.load();
+
+      mActiveWorkers.fetch_add(1);
+      if (mRunning.load())
+         RunBranches();
+      mActiveWorkers.fetch_sub(1);
+   }
+}
+
+void AudioGraphExecutor::RunBranches()
+{
+   const Plan* plan = mPlan;
+   const int numBranches = (int)plan->mBranches.size();
+   int spins = 0;
+   while (plan->mCompletedBranches.load(std::memory_order_acquire) < numBranches)
+   {
+      int branchIndex;
+      if (PopReadyBranch(branchIndex))
+      {
+         RunBranch(branchIndex);
+         spins = 0;
+      }
+      else if (++spins > kSpinsBeforeYield)
+      {
+         std::this_thread::yield();
+      }
+   }
+}
+
+void AudioGraphExecutor::RunBranch(int branchIndex)
+{
+   const Plan* plan = mPlan;
+   while (branchIndex != -1)
+   {
+      const Branch& branch = plan->mBranches[branchIndex];
+      for (auto* source : branch.mSources)
+         source->ProcessAndMeasure(mTime);
+
+      //keep going on this thread with the first successor we unblock, and hand the rest to the pool
+      int continueWith = -1;
+      for (int successor : branch.mSuccessors)
+      {
+         if (plan->mPendingPredecessors[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+         {
+            if (continueWith == -1)
+               continueWith = successor;
+            else
+               PushReadyBranch(successor);
+         }
+      }
+
+      plan->mCompletedBranches.fetch_add(1, std::memory_order_release);
+      branchIndex = continueWith;
+   }
+}
+
+void AudioGraphExecutor::PushReadyBranch(int branchIndex)
+{
+   //each branch becomes ready exactly once per buffer, so the queue can never overflow
+   const Plan* plan = mPlan;
+   int slot = plan->mReadyWriteIndex.fetch_add(1, std::memory_order_acq_rel);
+   plan->mReadyQueue[slot].store(branchIndex, std::memory_order_release);
+}
+
+bool AudioGraphExecutor::PopReadyBranch(int& branchIndex)
+{
+   const Plan* plan = mPlan;
+   int read = plan->mReadyReadIndex.load(std::memory_order_acquire);
+   while (read < plan->mReadyWriteIndex.load(std::memory_order_acquire))
+   {
+      int ready = plan->mReadyQueue[read].load(std::memory_order_acquire);
+      if (ready == -1) //slot has been claimed, but the branch isn't published yet
+         return false;
+      if (plan->mReadyReadIndex.compare_exchange_weak(read, read + 1, std::memory_order_acq_rel))
+      {
+         branchIndex = ready;
+         return true;
+      }
+   }
+   return false;
+}
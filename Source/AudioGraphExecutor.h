@@ -0,0 +1,94 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  AudioGraphExecutor.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class IAudioSource;
+
+//splits the ordered source list from ModularSynth::ArrangeAudioSourceDependencies() into branches,
+//and runs the branches that don't depend on each other on a pool of audio worker threads.
+//any two sources that touch the same buffer or state (a source and its target, two sources feeding the
+//same receiver, the ends of a note, pulse or modulation cable, two modules sharing a modulator, or sources
+//that can't process in parallel) keep the relative order they have in the serial source list, so the
+//output is identical to processing the list serially.
+class AudioGraphExecutor
+{
+public:
+   AudioGraphExecutor();
+   ~AudioGraphExecutor();
+
+   void SetNumThreads(int numThreads); //total thread count, including the audio device thread
+   int GetNumThreads() const { return (int)mWorkers.size() + 1; }
+   bool IsEnabled() const { return !mWorkers.empty(); }
+
+   struct Branch
+   {
+      std::vector<IAudioSource*> mSources;
+      std::vector<int> mSuccessors;
+      int mNumPredecessors{ 0 };
+   };
+
+   //immutable once built, apart from the bookkeeping that gets reset at the start of every Process()
+   struct Plan
+   {
+      Plan(int numBranches);
+
+      std::vector<Branch> mBranches;
+      std::vector<int> mRootBranches;
+      std::unique_ptr<std::atomic<int>[]> mPendingPredecessors;
+      std::unique_ptr<std::atomic<int>[]> mReadyQueue;
+      mutable std::atomic<int> mReadyWriteIndex{ 0 };
+      mutable std::atomic<int> mReadyReadIndex{ 0 };
+      mutable std::atomic<int> mCompletedBranches{ 0 };
+   };
+
+   static std::unique_ptr<Plan> BuildPlan(const std::vector<IAudioSource*>& orderedSources);
+   void Process(const Plan* plan, double time);
+
+   static bool IsWorkerThread();
+
+private:
+   void StopWorkers();
+   void WorkerLoop();
+   void RunBranches();
+   void RunBranch(int branchIndex);
+   bool PopReadyBranch(int& branchIndex);
+   void PushReadyBranch(int branchIndex);
+
+   const Plan* mPlan{ nullptr }; //only valid during Process()
+   std::vector<std::thread> mWorkers;
+   std::mutex mWakeMutex;
+   std::condition_variable mWakeCondition;
+   std::atomic<bool> mExit{ false };
+   std::atomic<bool> mRunning{ false };
+   std::atomic<int> mActiveWorkers{ 0 };
+   std::atomic<int> mGeneration{ 0 };
+   double mTime{ 0 };
+};
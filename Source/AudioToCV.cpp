@@ -110,6 +110,14 @@ float AudioToCV::Value(int samplesIn)
    return ofMap(mModulationBuffer[samplesIn] / 2 + .5f, 0, 1, GetMin(), GetMax(), K(clamp));
 }
 
+void AudioToCV::FillBuffer(float* values, int numSamples)
+{
+   float min = GetMin();
+   float max = GetMax();
+   for (int i = 0; i < numSamples; ++i)
+      values[i] = min + ofClamp(mModulationBuffer[i] / 2 + .5f, 0, 1) * (max - min);
+}
+
 void AudioToCV::SaveLayout(ofxJSONElement& moduleInfo)
 {
 }
@@ -53,6 +53,7 @@ public:
 
    //IModulator
    float Value(int samplesIn = 0) override;
+   void FillBuffer(float* values, int numSamples) override;
    bool Active() const override { return mEnabled; }
 
    //IFloatSliderListener
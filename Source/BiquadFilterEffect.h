@@ -57,6 +57,7 @@ public:
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
    float GetEffectAmount() override;
    std::string GetType() override { return "biquad"; }
+   float GetTailLengthMs() override { return 500; } //enough for a resonant low filter to ring out
 
    bool MouseMoved(float x, float y) override;
 
@@ -46,6 +46,7 @@ public:
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
    float GetEffectAmount() override;
    std::string GetType() override { return "bitcrush"; }
+   float GetTailLengthMs() override { return mDownsample * gInvSampleRateMs; } //the last held sample
 
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
    void IntSliderUpdated(IntSlider* slider, int oldVal, double time) override;
@@ -0,0 +1,101 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  BlockEventList.cpp
+//  Bespoke
+//
+//
+
+#include "BlockEventList.h"
+
+namespace
+{
+   bool SortsBefore(const BlockEvent& a, const BlockEvent& b)
+   {
+      if (a.time != b.time)
+         return a.time < b.time;
+      return a.IsNoteOff() && !b.IsNoteOff();
+   }
+}
+
+BlockEventList::BlockEventList()
+{
+   for (uint32_t i = 0; i < kCapacity; ++i)
+      mInbox[i].mSequence.store(i, std::memory_order_relaxed);
+}
+
+bool BlockEventList::Insert(const BlockEvent& event)
+{
+   uint32_t pos = mInboxWritePos.load(std::memory_order_relaxed);
+   while (true)
+   {
+      InboxSlot& slot = mInbox[pos & (kCapacity - 1)];
+      int32_t diff = (int32_t)(slot.mSequence.load(std::memory_order_acquire) - pos);
+      if (diff == 0)
+      {
+         if (mInboxWritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+         {
+            slot.mEvent = event;
+            slot.mSequence.store(pos + 1, std::memory_order_release);
+            return true;
+         }
+      }
+      else if (diff < 0)
+      {
+         return false; //the consumer hasn't caught up with the inbox
+      }
+      else
+      {
+         pos = mInboxWritePos.load(std::memory_order_relaxed);
+      }
+   }
+}
+
+void BlockEventList::TakeInbox()
+{
+   while (mNumEvents < kCapacity)
+   {
+      InboxSlot& slot = mInbox[mInboxReadPos & (kCapacity - 1)];
+      if (slot.mSequence.load(std::memory_order_acquire) != mInboxReadPos + 1)
+         break; //empty, or the next producer hasn't finished writing
+      InsertSorted(slot.mEvent);
+      slot.mSequence.store(mInboxReadPos + kCapacity, std::memory_order_release);
+      ++mInboxReadPos;
+   }
+}
+
+void BlockEventList::InsertSorted(const BlockEvent& event)
+{
+   //after everything that sorts at or before it, so events at the same time keep the order they arrived in
+   int low = 0;
+   int high = mNumEvents;
+   while (low < high)
+   {
+      int mid = (low + high) / 2;
+      if (SortsBefore(event, At(mid)))
+         high = mid;
+      else
+         low = mid + 1;
+   }
+
+   //events are usually queued in time order, so this rarely has to shift anything
+   for (int i = mNumEvents; i > low; --i)
+      At(i) = At(i - 1);
+   At(low) = event;
+   ++mNumEvents;
+}
@@ -0,0 +1,101 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  BlockEventList.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "ModulationChain.h"
+
+struct BlockEvent
+{
+   enum class Type
+   {
+      kNote,
+      kPulse
+   };
+
+   Type type{ Type::kNote };
+   double time{ 0 };
+   int pitch{ 0 };
+   float velocity{ 0 };
+   int voiceIdx{ -1 };
+   int flags{ 0 }; //pulse flags
+   ModulationParameters modulation;
+
+   bool IsNoteOff() const { return type == Type::kNote && velocity == 0; }
+};
+
+//fixed-capacity list of one receiver's events that arrived ahead of the buffer they land in, kept sorted by time so
+//the receiver can consume them in order, a buffer at a time. events stay keyed on time rather than sample offset,
+//the receiver works out where in the buffer they go like it does for notes that arrive directly.
+//note offs sort ahead of anything else at the same time, so a retriggered pitch doesn't get cut off by its own release.
+//any number of threads can Insert() (audio worker threads, midi input), but only one thread consumes. inserts land in a
+//lock-free inbox, and get moved into the sorted ring by the consumer.
+class BlockEventList
+{
+public:
+   static const int kCapacity = 256; //power of two, for wrapping indices with a mask
+
+   BlockEventList();
+
+   bool Insert(const BlockEvent& event); //any thread. returns false if the list is full
+
+   //consumer only. removes events at or before endTime and passes them to onEvent in time order.
+   //onEvent is free to insert more events.
+   template <typename F>
+   void ConsumeUntil(double endTime, F&& onEvent)
+   {
+      TakeInbox();
+      while (mNumEvents > 0 && At(0).time <= endTime)
+      {
+         BlockEvent event = At(0);
+         mHead = (mHead + 1) & (kCapacity - 1);
+         --mNumEvents;
+         onEvent(event);
+         TakeInbox();
+      }
+   }
+
+private:
+   struct InboxSlot
+   {
+      std::atomic<uint32_t> mSequence{ 0 };
+      BlockEvent mEvent;
+   };
+
+   void TakeInbox();
+   void InsertSorted(const BlockEvent& event);
+   BlockEvent& At(int index) { return mEvents[(mHead + index) & (kCapacity - 1)]; }
+
+   BlockEvent mEvents[kCapacity];
+   int mHead{ 0 };
+   int mNumEvents{ 0 };
+
+   //bounded multi-producer queue: a slot is free to write when its sequence equals the write position, and ready to
+   //read when it's one past it
+   InboxSlot mInbox[kCapacity];
+   std::atomic<uint32_t> mInboxWritePos{ 0 };
+   uint32_t mInboxReadPos{ 0 };
+};
@@ -27,6 +27,7 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 #include "UIControlMacros.h"
+#include "Resampler.h"
 
 BufferShuffler::BufferShuffler()
 : IAudioProcessor(gBufferSize)
@@ -544,9 +545,8 @@ void BufferShuffler::LoadState(FileStreamIn& in, int rev)
       for (int ch = 0; ch < savedChannelCount; ++ch)
       {
          float* destBuffer = mInputBuffer.GetChannel(ch);
-         float* srcBuffer = readBuffer.GetChannel(ch);
-         for (int i = 0; i < adjustedLength; ++i)
-            destBuffer[i] = GetInterpolatedSample(i / sampleRateRatio, srcBuffer, savedLength);
+         const float* srcBuffer = readBuffer.GetChannel(ch);
+         Resampler::Read(&srcBuffer, 1, savedLength, 0, 1 / sampleRateRatio, &destBuffer, 1, adjustedLength, Resampler::Quality::Sinc32);
       }
    }
 }
@@ -45,6 +45,7 @@ ChannelBuffer::ChannelBuffer(float* data, int bufferSize)
    mBuffers = new float*[1];
    mBuffers[0] = data;
    mBufferSize = bufferSize;
+   mKnownSilent = false;
 }
 
 ChannelBuffer::~ChannelBuffer()
@@ -69,12 +70,24 @@ void ChannelBuffer::Setup(int bufferSize)
 }
 
 float* ChannelBuffer::GetChannel(int channel)
+{
+   mKnownSilent = false;
+   return ChannelAt(channel);
+}
+
+const float* ChannelBuffer::ReadChannel(int channel) const
+{
+   return ChannelAt(channel);
+}
+
+float* ChannelBuffer::ChannelAt(int channel) const
 {
    if (channel >= mActiveChannels)
       ofLog() << "error: requesting a higher channel index than we have active";
    float* ret = mBuffers[MIN(channel, mActiveChannels - 1)];
    if (ret == nullptr)
    {
+      //a freshly allocated channel is silent, so this doesn't touch mKnownSilent
       assert(mOwnsBuffers);
       ret = new float[BufferSize()];
       ::Clear(ret, BufferSize());
@@ -90,6 +103,26 @@ void ChannelBuffer::Clear() const
       if (mBuffers[i] != nullptr)
          ::Clear(mBuffers[i], BufferSize());
    }
+   mKnownSilent = true;
+}
+
+bool ChannelBuffer::IsSilent() const
+{
+   if (mKnownSilent)
+      return true;
+
+   for (int ch = 0; ch < mActiveChannels; ++ch)
+   {
+      const float* data = mBuffers[ch];
+      if (data == nullptr)
+         continue;
+      for (int i = 0; i < mBufferSize; ++i)
+      {
+         if (fabsf(data[i]) > kSilenceThreshold)
+            return false;
+      }
+   }
+   return true;
 }
 
 void ChannelBuffer::SetMaxAllowedChannels(int channels)
@@ -138,6 +171,7 @@ void ChannelBuffer::CopyFrom(ChannelBuffer* src, int length /*= -1*/, int startO
          mBuffers[i] = nullptr;
       }
    }
+   mKnownSilent = src->mKnownSilent && length == mBufferSize;
 }
 
 void ChannelBuffer::SetChannelPointer(float* data, int channel, bool deleteOldData)
@@ -145,6 +179,7 @@ void ChannelBuffer::SetChannelPointer(float* data, int channel, bool deleteOldDa
    if (deleteOldData)
       delete[] mBuffers[channel];
    mBuffers[channel] = data;
+   mKnownSilent = false;
 }
 
 void ChannelBuffer::Resize(int bufferSize)
@@ -37,9 +37,14 @@ public:
    ~ChannelBuffer();
 
    float* GetChannel(int channel);
+   const float* ReadChannel(int channel) const; //GetChannel() for callers that only read, so the buffer can still know it's silent
 
    void Clear() const;
 
+   //true if every active channel is below kSilenceThreshold. free when nothing has asked for a channel since the last
+   //Clear(), otherwise it scans. meant for receivers, after whatever feeds them has run for this buffer
+   bool IsSilent() const;
+
    void SetMaxAllowedChannels(int channels);
    void SetNumActiveChannels(int channels) { mActiveChannels = MIN(mNumChannels, channels); }
    int NumActiveChannels() const { return mActiveChannels; }
@@ -67,9 +72,11 @@ public:
    void Load(FileStreamIn& in, int& readLength, LoadMode loadMode);
 
    static const int kMaxNumChannels = 2;
+   static constexpr float kSilenceThreshold = 1e-7f;
 
 private:
    void Setup(int bufferSize);
+   float* ChannelAt(int channel) const;
 
    int mActiveChannels{ 1 };
    int mNumChannels{ 1 };
@@ -77,4 +84,5 @@ private:
    float** mBuffers;
    int mRecentActiveChannels{ 1 };
    bool mOwnsBuffers{ true };
+   mutable bool mKnownSilent{ true }; //cleared by anything that hands out a channel to write to
 };
@@ -0,0 +1,207 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  ConvolutionReverbEffect.cpp
+//  Bespoke
+//
+//
+
+#include "ConvolutionReverbEffect.h"
+#include "SynthGlobals.h"
+#include "ModularSynth.h"
+#include "Sample.h"
+#include "FileStream.h"
+#include "Profiler.h"
+#include "SnapshotPublisher.h"
+
+#include "juce_gui_basics/juce_gui_basics.h"
+#include "juce_audio_formats/juce_audio_formats.h"
+
+ConvolutionReverbEffect::ConvolutionReverbEffect()
+{
+}
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect()
+{
+   delete mConvolver.load();
+}
+
+void ConvolutionReverbEffect::CreateUIControls()
+{
+   IDrawableModule::CreateUIControls();
+   mLoadButton = new ClickButton(this, "load", 5, 4);
+   mWetSlider = new FloatSlider(this, "wet", 5, 22, 110, 15, &mWet, 0, 1);
+   mDrySlider = new FloatSlider(this, "dry", 5, 38, 110, 15, &mDry, 0, 1);
+}
+
+void ConvolutionReverbEffect::ProcessAudio(double time, ChannelBuffer* buffer)
+{
+   PROFILER(ConvolutionReverbEffect);
+
+   if (!mEnabled)
+      return;
+
+   Convolver* convolver = mConvolver.load(std::memory_order_acquire);
+   if (convolver == nullptr)
+      return;
+
+   ComputeSliders(0);
+
+   int bufferSize = buffer->BufferSize();
+   int numChannels = buffer->NumActiveChannels();
+
+   float* wet[ChannelBuffer::kMaxNumChannels];
+   const float* dry[ChannelBuffer::kMaxNumChannels];
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      dry[ch] = buffer->ReadChannel(ch);
+      wet[ch] = gWorkBuffer + ch * bufferSize;
+   }
+
+   convolver->Process(dry, wet, numChannels, bufferSize);
+
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      float* channel = buffer->GetChannel(ch);
+      for (int i = 0; i < bufferSize; ++i)
+         channel[i] = channel[i] * mDry + wet[ch][i] * mWet;
+   }
+}
+
+void ConvolutionReverbEffect::LoadImpulseResponse(std::string path)
+{
+   Sample sample;
+   if (!sample.Read(path.c_str()))
+      return;
+
+   //at the synth's sample rate, and scaled to unit energy so that different responses come out at about the same level
+   int numChannels = std::min(sample.NumChannels(), ChannelBuffer::kMaxNumChannels);
+   float ratio = sample.GetSampleRateRatio();
+   int length = int(sample.LengthInSamples() / ratio);
+   std::vector<std::vector<float> > response(numChannels, std::vector<float>(length, 0));
+   float loudestEnergy = 0;
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      const float* source = sample.Data()->GetChannel(ch);
+      float energy = 0;
+      for (int i = 0; i < length; ++i)
+      {
+         float pos = i * ratio;
+         int idx = int(pos);
+         float next = idx + 1 < sample.LengthInSamples() ? source[idx + 1] : 0;
+         response[ch][i] = ofLerp(source[idx], next, pos - idx);
+         energy += response[ch][i] * response[ch][i];
+      }
+      loudestEnergy = std::max(loudestEnergy, energy);
+   }
+   if (loudestEnergy > 0)
+   {
+      float gain = 1 / sqrtf(loudestEnergy);
+      for (auto& channel : response)
+         Mult(channel.data(), gain, length);
+   }
+
+   //building it runs the partition ffts and starts its helper thread, so it's all done here before the audio thread sees it.
+   //the old one goes once the audio thread is past any buffer that could still be using it
+   uint64_t swappedAt = AudioThreadEpoch::GetCompletedBuffers();
+   Convolver* old = mConvolver.exchange(new Convolver(response, ChannelBuffer::kMaxNumChannels), std::memory_order_acq_rel);
+   AudioThreadEpoch::WaitUntilMovedPast(swappedAt);
+   delete old;
+
+   mImpulseResponsePath = path;
+   mImpulseResponseName = sample.Name();
+}
+
+void ConvolutionReverbEffect::ButtonClicked(ClickButton* button, double time)
+{
+   if (button == mLoadButton)
+   {
+      auto filePattern = TheSynth->GetAudioFormatManager().getWildcardForAllFormats();
+      if (juce::File::areFileNamesCaseSensitive())
+         filePattern += ";" + filePattern.toUpperCase();
+      juce::FileChooser chooser("Load impulse response", juce::File(ofToDataPath("samples")),
+                                filePattern, true, false, TheSynth->GetFileChooserParent());
+      if (chooser.browseForFileToOpen())
+         LoadImpulseResponse(chooser.getResult().getFullPathName().toStdString());
+   }
+}
+
+void ConvolutionReverbEffect::DrawModule()
+{
+   if (!mEnabled)
+      return;
+
+   mLoadButton->Draw();
+   mWetSlider->Draw();
+   mDrySlider->Draw();
+
+   if (mImpulseResponseName.empty())
+      DrawTextNormal("no impulse response", 45, 15, 10);
+   else
+      DrawTextNormal(mImpulseResponseName, 45, 15, 10);
+}
+
+void ConvolutionReverbEffect::GetModuleDimensions(float& width, float& height)
+{
+   if (mEnabled)
+   {
+      width = 120;
+      height = 56;
+   }
+   else
+   {
+      width = 120;
+      height = 0;
+   }
+}
+
+float ConvolutionReverbEffect::GetEffectAmount()
+{
+   if (!mEnabled)
+      return 0;
+   return mWet;
+}
+
+float ConvolutionReverbEffect::GetTailLengthMs()
+{
+   Convolver* convolver = mConvolver.load(std::memory_order_acquire);
+   if (convolver == nullptr)
+      return 0;
+   return convolver->GetLength() * gInvSampleRateMs;
+}
+
+void ConvolutionReverbEffect::SaveState(FileStreamOut& out)
+{
+   out << GetModuleSaveStateRev();
+
+   IDrawableModule::SaveState(out);
+
+   out << mImpulseResponsePath;
+}
+
+void ConvolutionReverbEffect::LoadState(FileStreamIn& in, int rev)
+{
+   IDrawableModule::LoadState(in, rev);
+
+   LoadStateValidate(rev <= GetModuleSaveStateRev());
+
+   std::string path;
+   in >> path;
+   if (!path.empty())
+      LoadImpulseResponse(path);
+}
@@ -0,0 +1,75 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  ConvolutionReverbEffect.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include "IAudioEffect.h"
+#include "Slider.h"
+#include "ClickButton.h"
+#include "Convolver.h"
+
+#include <atomic>
+
+//reverb from a recorded impulse response, loaded through Sample. see Convolver for how it keeps up with long responses
+class ConvolutionReverbEffect : public IAudioEffect, public IFloatSliderListener, public IButtonListener
+{
+public:
+   ConvolutionReverbEffect();
+   ~ConvolutionReverbEffect();
+
+   static IAudioEffect* Create() { return new ConvolutionReverbEffect(); }
+
+   void CreateUIControls() override;
+
+   //IAudioEffect
+   void ProcessAudio(double time, ChannelBuffer* buffer) override;
+   void SetEnabled(bool enabled) override { mEnabled = enabled; }
+   float GetEffectAmount() override;
+   std::string GetType() override { return "convolution"; }
+   float GetTailLengthMs() override;
+
+   void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override {}
+   void ButtonClicked(ClickButton* button, double time) override;
+
+   void SaveState(FileStreamOut& out) override;
+   void LoadState(FileStreamIn& in, int rev) override;
+   int GetModuleSaveStateRev() const override { return 0; }
+
+   bool IsEnabled() const override { return mEnabled; }
+
+private:
+   //IDrawableModule
+   void DrawModule() override;
+   void GetModuleDimensions(float& width, float& height) override;
+
+   void LoadImpulseResponse(std::string path);
+
+   std::atomic<Convolver*> mConvolver{ nullptr }; //swapped in whole by LoadImpulseResponse(), so the audio thread never waits on a load
+   std::string mImpulseResponsePath;
+   std::string mImpulseResponseName;
+   float mWet{ .5f };
+   float mDry{ 1 };
+   FloatSlider* mWetSlider{ nullptr };
+   FloatSlider* mDrySlider{ nullptr };
+   ClickButton* mLoadButton{ nullptr };
+};
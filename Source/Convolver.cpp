@@ -0,0 +1,302 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Convolver.cpp
+//  Bespoke
+//
+//
+
+#include "Convolver.h"
+#include "SimdVec.h"
+
+#include <algorithm>
+
+using namespace Simd;
+
+void Convolver::Stage::SetUp(const float* impulseResponse, int length, int blockSize)
+{
+   mBlockSize = blockSize;
+   mNumBins = blockSize + 1;
+   mNumPartitions = (std::max(length, 0) + blockSize - 1) / blockSize;
+   mFFT = std::make_unique<::FFT>(blockSize * 2);
+   mPartitionsRe.assign(mNumPartitions * mNumBins, 0);
+   mPartitionsIm.assign(mNumPartitions * mNumBins, 0);
+   mSpectrumRe.assign(mNumBins, 0);
+   mSpectrumIm.assign(mNumBins, 0);
+   mTimeDomain.assign(blockSize * 2, 0);
+
+   for (int i = 0; i < mNumPartitions; ++i)
+   {
+      //zero padded to twice the block size, so the overlap-save output is linear rather than circular
+      int start = i * blockSize;
+      int partitionLength = std::min(blockSize, length - start);
+      std::fill(mTimeDomain.begin(), mTimeDomain.end(), 0.0f);
+      std::copy(impulseResponse + start, impulseResponse + start + partitionLength, mTimeDomain.begin());
+      mFFT->Forward(mTimeDomain.data(), mPartitionsRe.data() + i * mNumBins, mPartitionsIm.data() + i * mNumBins);
+   }
+
+   Clear();
+}
+
+void Convolver::Stage::Clear()
+{
+   mHistoryRe.assign(mNumPartitions * mNumBins, 0);
+   mHistoryIm.assign(mNumPartitions * mNumBins, 0);
+   mHistoryPos = 0;
+}
+
+void Convolver::Stage::Process(const float* input, float* output)
+{
+   if (mNumPartitions == 0)
+   {
+      std::fill(output, output + mBlockSize, 0.0f);
+      return;
+   }
+
+   mHistoryPos = (mHistoryPos + 1) % mNumPartitions;
+   float* newestRe = mHistoryRe.data() + mHistoryPos * mNumBins;
+   float* newestIm = mHistoryIm.data() + mHistoryPos * mNumBins;
+   mFFT->Forward(input, newestRe, newestIm);
+
+   std::fill(mSpectrumRe.begin(), mSpectrumRe.end(), 0.0f);
+   std::fill(mSpectrumIm.begin(), mSpectrumIm.end(), 0.0f);
+   float* sumRe = mSpectrumRe.data();
+   float* sumIm = mSpectrumIm.data();
+   const int vectorBins = mBlockSize; //the last bin is left over for the scalar loop
+   for (int i = 0; i < mNumPartitions; ++i)
+   {
+      //partition i meets the input from i blocks ago
+      int historyIdx = mHistoryPos - i;
+      if (historyIdx < 0)
+         historyIdx += mNumPartitions;
+      const float* xRe = mHistoryRe.data() + historyIdx * mNumBins;
+      const float* xIm = mHistoryIm.data() + historyIdx * mNumBins;
+      const float* hRe = mPartitionsRe.data() + i * mNumBins;
+      const float* hIm = mPartitionsIm.data() + i * mNumBins;
+
+      for (int j = 0; j < vectorBins; j += kNumLanes)
+      {
+         Vec ar = VecLoad(xRe + j);
+         Vec ai = VecLoad(xIm + j);
+         Vec br = VecLoad(hRe + j);
+         Vec bi = VecLoad(hIm + j);
+         VecStore(sumRe + j, VecAdd(VecLoad(sumRe + j), VecSub(VecMul(ar, br), VecMul(ai, bi))));
+         VecStore(sumIm + j, VecAdd(VecLoad(sumIm + j), VecAdd(VecMul(ar, bi), VecMul(ai, br))));
+      }
+      for (int j = vectorBins; j < mNumBins; ++j)
+      {
+         sumRe[j] += xRe[j] * hRe[j] - xIm[j] * hIm[j];
+         sumIm[j] += xRe[j] * hIm[j] + xIm[j] * hRe[j];
+      }
+   }
+
+   mFFT->Inverse(sumRe, sumIm, mTimeDomain.data());
+   float scale = 1.0f / (mBlockSize * 2);
+   for (int i = 0; i < mBlockSize; ++i)
+      output[i] = mTimeDomain[mBlockSize + i] * scale;
+}
+
+Convolver::Convolver(const std::vector<std::vector<float> >& impulseResponse, int numChannels)
+: mChannels(numChannels)
+{
+   for (const auto& response : impulseResponse)
+      mLength = std::max(mLength, (int)response.size());
+   mHasTail = mLength > kTailBlockSize * 2;
+
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      Channel& channel = mChannels[ch];
+      std::vector<float> response(mLength, 0);
+      if (!impulseResponse.empty())
+      {
+         const auto& source = impulseResponse[std::min(ch, (int)impulseResponse.size() - 1)];
+         std::copy(source.begin(), source.end(), response.begin());
+      }
+      response.resize(std::max(mLength, kTailBlockSize * 2), 0);
+
+      channel.mDirectTaps.assign(response.rend() - kHeadBlockSize, response.rend());
+      channel.mHead.SetUp(response.data() + kHeadBlockSize, std::min(mLength, kTailBlockSize * 2) - kHeadBlockSize, kHeadBlockSize);
+      channel.mTail.SetUp(response.data() + kTailBlockSize * 2, mLength - kTailBlockSize * 2, kTailBlockSize);
+      ResetChannel(channel);
+   }
+
+   //started here rather than when the first tail block is due, so the audio thread never has to create it
+   if (mHasTail)
+      mHelper = std::thread(&Convolver::HelperLoop, this);
+}
+
+Convolver::~Convolver()
+{
+   if (mHelper.joinable())
+   {
+      WaitForHelper();
+      {
+         std::lock_guard<std::mutex> lock(mHelperMutex);
+         mExit = true;
+      }
+      mHelperCondition.notify_all();
+      mHelper.join();
+   }
+}
+
+void Convolver::ResetChannel(Channel& channel)
+{
+   channel.mHead.Clear();
+   channel.mHeadInput.assign(kHeadBlockSize * 2, 0);
+   channel.mHeadOutput.assign(kHeadBlockSize, 0);
+   channel.mTail.Clear();
+   channel.mTailInput.assign(kTailBlockSize * 2, 0);
+   channel.mTailOutput.assign(kTailBlockSize, 0);
+   channel.mTailJobInput.assign(kTailBlockSize * 2, 0);
+   channel.mTailJobOutput.assign(kTailBlockSize, 0);
+}
+
+void Convolver::Process(const float* const* inputs, float* const* outputs, int numChannels, int numSamples)
+{
+   numChannels = std::min(numChannels, (int)mChannels.size());
+
+   //a channel that's just come back has stale history
+   if (numChannels > mNumActiveChannels)
+   {
+      if (mJobInFlight && mJobNumChannels > mNumActiveChannels)
+         WaitForHelper(); //the tail job is still using it
+      for (int ch = mNumActiveChannels; ch < numChannels; ++ch)
+         ResetChannel(mChannels[ch]);
+   }
+   mNumActiveChannels = numChannels;
+
+   int pos = 0;
+   while (pos < numSamples)
+   {
+      int length = std::min(numSamples - pos, kHeadBlockSize - mHeadPos);
+      for (int ch = 0; ch < numChannels; ++ch)
+      {
+         Channel& channel = mChannels[ch];
+         float* headInput = channel.mHeadInput.data() + kHeadBlockSize;
+         std::copy(inputs[ch] + pos, inputs[ch] + pos + length, headInput + mHeadPos);
+         std::copy(inputs[ch] + pos, inputs[ch] + pos + length, channel.mTailInput.begin() + kTailBlockSize + mTailPos);
+
+         const float* taps = channel.mDirectTaps.data();
+         for (int i = 0; i < length; ++i)
+         {
+            const float* window = headInput + mHeadPos + i + 1 - kHeadBlockSize;
+            Vec sum = VecSet(0);
+            for (int j = 0; j < kHeadBlockSize; j += kNumLanes)
+               sum = VecAdd(sum, VecMul(VecLoad(taps + j), VecLoad(window + j)));
+            float lanes[kNumLanes];
+            VecStore(lanes, sum);
+            float direct = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            outputs[ch][pos + i] = direct + channel.mHeadOutput[mHeadPos + i] + channel.mTailOutput[mTailPos + i];
+         }
+      }
+
+      mHeadPos += length;
+      mTailPos += length;
+      pos += length;
+
+      if (mHeadPos == kHeadBlockSize)
+      {
+         for (int ch = 0; ch < numChannels; ++ch)
+         {
+            Channel& channel = mChannels[ch];
+            channel.mHead.Process(channel.mHeadInput.data(), channel.mHeadOutput.data());
+            std::copy(channel.mHeadInput.begin() + kHeadBlockSize, channel.mHeadInput.end(), channel.mHeadInput.begin());
+         }
+         mHeadPos = 0;
+      }
+
+      if (mTailPos == kTailBlockSize)
+      {
+         FinishTailBlock(numChannels);
+         mTailPos = 0;
+      }
+   }
+}
+
+//a full tail block of input has arrived: pick up the block the helper was working on, which is what plays next, and hand it
+//this one. the tail starts 2 * kTailBlockSize into the response, so the result isn't due until the block after next
+void Convolver::FinishTailBlock(int numChannels)
+{
+   if (!mHasTail)
+      return;
+
+   int finishedChannels = 0;
+   if (mJobInFlight)
+   {
+      WaitForHelper();
+      mJobInFlight = false;
+      finishedChannels = std::min(mJobNumChannels, numChannels);
+      for (int ch = 0; ch < finishedChannels; ++ch)
+         mChannels[ch].mTailOutput = mChannels[ch].mTailJobOutput;
+   }
+   for (int ch = finishedChannels; ch < numChannels; ++ch)
+      std::fill(mChannels[ch].mTailOutput.begin(), mChannels[ch].mTailOutput.end(), 0.0f);
+
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      Channel& channel = mChannels[ch];
+      channel.mTailJobInput = channel.mTailInput;
+      std::copy(channel.mTailInput.begin() + kTailBlockSize, channel.mTailInput.end(), channel.mTailInput.begin());
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mHelperMutex);
+      mJobNumChannels = numChannels;
+      mJobPending = true;
+   }
+   mHelperCondition.notify_all();
+   mJobInFlight = true;
+}
+
+void Convolver::RunTailJob()
+{
+   for (int ch = 0; ch < mJobNumChannels; ++ch)
+   {
+      Channel& channel = mChannels[ch];
+      channel.mTail.Process(channel.mTailJobInput.data(), channel.mTailJobOutput.data());
+   }
+}
+
+void Convolver::WaitForHelper()
+{
+   std::unique_lock<std::mutex> lock(mHelperMutex);
+   mHelperCondition.wait(lock, [this]
+                         { return !mJobPending; });
+}
+
+void Convolver::HelperLoop()
+{
+   while (true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mHelperMutex);
+         mHelperCondition.wait(lock, [this]
+                               { return mJobPending || mExit; });
+         if (mExit)
+            return;
+      }
+
+      RunTailJob();
+
+      {
+         std::lock_guard<std::mutex> lock(mHelperMutex);
+         mJobPending = false;
+      }
+      mHelperCondition.notify_all();
+   }
+}
@@ -0,0 +1,114 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Convolver.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include "FFT.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//zero latency convolution with a long impulse response, split into three stages so the cost per sample stays about the
+//same however long the response gets:
+//- the first kHeadBlockSize taps run as a plain fir
+//- the rest of the first 2 * kTailBlockSize taps run as uniformly partitioned fft blocks of kHeadBlockSize, on the audio thread
+//- everything after that runs as partitions of kTailBlockSize on a helper thread, which gets a whole block to finish each one
+//building one is not realtime safe, so make a new one off the audio thread and swap it in
+class Convolver
+{
+public:
+   static const int kHeadBlockSize = 64;
+   static const int kTailBlockSize = 1024;
+
+   //one response per channel. if there are fewer responses than channels, the last one is reused
+   Convolver(const std::vector<std::vector<float> >& impulseResponse, int numChannels);
+   ~Convolver();
+
+   int GetLength() const { return mLength; }
+
+   //inputs and outputs hold numChannels channels of numSamples each, and may be the same buffers
+   void Process(const float* const* inputs, float* const* outputs, int numChannels, int numSamples);
+
+private:
+   //one uniformly partitioned overlap-save convolution
+   struct Stage
+   {
+      void SetUp(const float* impulseResponse, int length, int blockSize);
+      void Clear();
+      //input holds the last two blocks of input, output gets this stage's contribution to the next block
+      void Process(const float* input, float* output);
+
+      int mBlockSize{ 0 };
+      int mNumBins{ 0 };
+      int mNumPartitions{ 0 };
+      std::unique_ptr<::FFT> mFFT;
+      std::vector<float> mPartitionsRe; //mNumPartitions spectra of mNumBins each
+      std::vector<float> mPartitionsIm;
+      std::vector<float> mHistoryRe; //the last mNumPartitions input spectra, as a ring
+      std::vector<float> mHistoryIm;
+      int mHistoryPos{ 0 };
+      std::vector<float> mSpectrumRe;
+      std::vector<float> mSpectrumIm;
+      std::vector<float> mTimeDomain;
+   };
+
+   struct Channel
+   {
+      std::vector<float> mDirectTaps; //reversed, so each output sample is one straight dot product
+      Stage mHead;
+      std::vector<float> mHeadInput; //previous and current head block
+      std::vector<float> mHeadOutput;
+
+      Stage mTail;
+      std::vector<float> mTailInput; //previous and current tail block
+      std::vector<float> mTailOutput; //the block being played out
+
+      //only touched by whoever is running the tail block
+      std::vector<float> mTailJobInput;
+      std::vector<float> mTailJobOutput;
+   };
+
+   void ResetChannel(Channel& channel);
+   void FinishTailBlock(int numChannels);
+   void RunTailJob();
+   void WaitForHelper();
+   void HelperLoop();
+
+   int mLength{ 0 };
+   bool mHasTail{ false };
+   std::vector<Channel> mChannels;
+   int mNumActiveChannels{ 0 };
+   int mHeadPos{ 0 };
+   int mTailPos{ 0 };
+
+   std::thread mHelper;
+   std::mutex mHelperMutex;
+   std::condition_variable mHelperCondition;
+   int mJobNumChannels{ 0 };
+   bool mJobPending{ false };
+   bool mJobInFlight{ false };
+   bool mExit{ false };
+};
@@ -45,6 +45,7 @@ public:
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
    float GetEffectAmount() override;
    std::string GetType() override { return "dcremover"; }
+   float GetTailLengthMs() override { return 100; }
 
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
 
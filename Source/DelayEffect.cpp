@@ -154,6 +154,19 @@ float DelayEffect::GetEffectAmount()
    return mFeedback;
 }
 
+float DelayEffect::GetTailLengthMs()
+{
+   if (!mEcho)
+      return mDelay;
+   float feedback = fabsf(mFeedback);
+   if (feedback >= .999f)
+      return -1; //repeats forever
+   if (feedback < .00001f)
+      return mDelay;
+   //keep going until the repeats have fallen by 100dB
+   return mDelay * (1 + logf(.00001f) / logf(feedback));
+}
+
 void DelayEffect::SetDelay(float delay)
 {
    mDelay = delay;
@@ -60,6 +60,7 @@ public:
    void SetEnabled(bool enabled) override;
    float GetEffectAmount() override;
    std::string GetType() override { return "delay"; }
+   float GetTailLengthMs() override;
 
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
    void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override;
@@ -66,6 +66,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
    int GetNumTargets() override { return mUseIndividualOuts ? (int)mHits.size() + 1 : 1; }
 
@@ -49,6 +49,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
 
    bool IsResizable() const override { return true; }
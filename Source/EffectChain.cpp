@@ -95,6 +95,7 @@ void EffectChain::AddEffect(std::string type, std::string desiredName, bool onTh
 
    mEffectMutex.lock();
    mEffects.push_back(effect);
+   mLastAudibleInputTime[mEffects.size() - 1] = gTime;
    mEffectMutex.unlock();
    AddChild(effect);
 
@@ -134,6 +135,18 @@ void EffectChain::Process(double time)
 
       for (int i = 0; i < mEffects.size(); ++i)
       {
+         //once an effect's input has been silent for longer than its tail it has nothing left to add, so let it sleep until something comes in
+         if (GetBuffer()->IsSilent())
+         {
+            float tailMs = mEffects[i]->GetTailLengthMs();
+            if (tailMs >= 0 && time - mLastAudibleInputTime[i] > tailMs)
+               continue;
+         }
+         else
+         {
+            mLastAudibleInputTime[i] = time;
+         }
+
          mDryBuffer.CopyFrom(GetBuffer());
 
          mEffects[i]->ProcessAudio(time, GetBuffer());
@@ -158,19 +171,46 @@ void EffectChain::Process(double time)
       mEffectMutex.unlock();
    }
 
+   //don't touch the target's buffer if we've got nothing for it, so it can still tell that it's silent
+   bool silent = GetBuffer()->IsSilent();
    for (int ch = 0; ch < GetBuffer()->NumActiveChannels(); ++ch)
    {
-      float* buffer = GetBuffer()->GetChannel(ch);
-      float volSq = mVolume * mVolume;
-      for (int i = 0; i < bufferSize; ++i)
-         buffer[i] *= volSq;
-      Add(target->GetBuffer()->GetChannel(ch), buffer, bufferSize);
-      GetVizBuffer()->WriteChunk(buffer, bufferSize, ch);
+      if (!silent)
+      {
+         float* buffer = GetBuffer()->GetChannel(ch);
+         float volSq = mVolume * mVolume;
+         for (int i = 0; i < bufferSize; ++i)
+            buffer[i] *= volSq;
+         Add(target->GetBuffer()->GetChannel(ch), buffer, bufferSize);
+      }
+      GetVizBuffer()->WriteChunk(GetBuffer()->ReadChannel(ch), bufferSize, ch);
    }
 
    GetBuffer()->Reset();
 }
 
+float EffectChain::GetTailLengthMs()
+{
+   if (!mEnabled)
+      return 0;
+
+   //the whole chain can sleep once every effect in it has
+   float tailMs = 0;
+   mEffectMutex.lock();
+   for (auto* effect : mEffects)
+   {
+      float effectTailMs = effect->GetTailLengthMs();
+      if (effectTailMs < 0)
+      {
+         tailMs = -1;
+         break;
+      }
+      tailMs = MAX(tailMs, effectTailMs);
+   }
+   mEffectMutex.unlock();
+   return tailMs;
+}
+
 void EffectChain::Poll()
 {
    if (mWantToDeleteEffectAtIndex != -1)
@@ -418,6 +458,7 @@ void EffectChain::DeleteEffect(int index)
       IAudioEffect* toRemove = mEffects[index];
       RemoveFromVector(toRemove, mEffects);
       RemoveChild(toRemove);
+      mLastAudibleInputTime.fill(gTime); //indices have shifted, so wake everything up and let them fall back asleep
       //delete toRemove;   TODO(Ryan) can't do this in case stuff is referring to its UI controls
       mEffectMutex.unlock();
    }
@@ -439,6 +480,7 @@ void EffectChain::MoveEffect(int fromIndex, int direction)
       IAudioEffect* swap = mEffects[newIndex];
       mEffects[newIndex] = mEffects[fromIndex];
       mEffects[fromIndex] = swap;
+      std::swap(mLastAudibleInputTime[newIndex], mLastAudibleInputTime[fromIndex]);
       mEffectMutex.unlock();
 
       float level = mDryWetLevels[newIndex];
@@ -59,6 +59,8 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
+   float GetTailLengthMs() override;
 
    void KeyPressed(int key, bool isRepeat) override;
    void KeyReleased(int key) override;
@@ -105,6 +107,7 @@ private:
    ChannelBuffer mDryBuffer;
    std::vector<EffectControls> mEffectControls;
    std::array<float, MAX_EFFECTS_IN_CHAIN> mDryWetLevels{};
+   std::array<double, MAX_EFFECTS_IN_CHAIN> mLastAudibleInputTime{};
 
    double mSwapTime{ -1 };
    int mSwapFromIdx{ -1 };
@@ -46,6 +46,7 @@
 #include "FormantFilterEffect.h"
 #include "ButterworthFilterEffect.h"
 #include "GainStageEffect.h"
+#include "ConvolutionReverbEffect.h"
 
 EffectFactory::EffectFactory()
 {
@@ -70,6 +71,7 @@ EffectFactory::EffectFactory()
    //Register("formant", &(FormantFilterEffect::Create));
    Register("butterworth", &(ButterworthFilterEffect::Create));
    Register("gainstage", &(GainStageEffect::Create));
+   Register("convolution", &(ConvolutionReverbEffect::Create));
 }
 
 void EffectFactory::Register(std::string type, CreateEffectFn creator)
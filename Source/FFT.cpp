@@ -24,528 +24,368 @@
 //
 
 #include "FFT.h"
+#include "SimdVec.h"
+
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 
-// Constructor for FFT routine
-FFT::FFT(int nfft)
+using namespace Simd;
+
+//the real transform runs as a complex one of half the size, on the even samples as the real part and the odd samples as the
+//imaginary part. that goes through radix-4 stockham passes (plus a radix-2 one for odd powers of two), which need no bit
+//reversal and whose butterflies sit next to each other in memory once the stride gets past the first pass
+struct FFTPlan
 {
-   mNfft = nfft;
-   mNumfreqs = nfft / 2 + 1;
+   explicit FFTPlan(int nfft);
 
-   mFft_data = (float*)calloc(nfft, sizeof(float));
-}
+   void Transform(float* re, float* im, float* workRe, float* workIm) const;
 
-// Destructor for FFT routine
-FFT::~FFT()
-{
-   free(mFft_data);
-}
+   int mNfft{ 0 };
+   int mNumPoints{ 0 }; // complex points, nfft/2
+   std::vector<float> mPassTwiddles; // for each radix-4 pass of length n: w^p, w^2p and w^3p for p < n/4, as six arrays of re/im
+   std::vector<float> mSplitCos; // cos and sin of 2*pi*k/nfft for k <= nfft/2, to untangle the real spectrum
+   std::vector<float> mSplitSin;
+};
 
-// Perform forward FFT of real data
-// Accepts:
-//   input - pointer to an array of (real) input values, size nfft
-//   output_re - pointer to an array of the real part of the output,
-//     size nfft/2 + 1
-//   output_im - pointer to an array of the imaginary part of the output,
-//     size nfft/2 + 1
-void FFT::Forward(float* input, float* output_re, float* output_im)
+namespace
 {
-   int hnfft = mNfft / 2;
-
-   for (int ti = 0; ti < mNfft; ti++)
+   const FFTPlan* GetPlan(int nfft)
    {
-      mFft_data[ti] = input[ti];
+      static std::mutex sPlanMutex;
+      static std::map<int, std::unique_ptr<FFTPlan> > sPlans;
+
+      std::lock_guard<std::mutex> lock(sPlanMutex);
+      std::unique_ptr<FFTPlan>& plan = sPlans[nfft];
+      if (plan == nullptr)
+         plan = std::make_unique<FFTPlan>(nfft);
+      return plan.get();
    }
 
-   mayer_realfft(mNfft, mFft_data);
+   inline void ComplexMult(float wr, float wi, float& r, float& i)
+   {
+      float tmp = wr * r - wi * i;
+      i = wr * i + wi * r;
+      r = tmp;
+   }
 
-   output_im[0] = 0;
-   for (int ti = 0; ti < hnfft; ti++)
+   inline void ComplexMult(Vec wr, Vec wi, Vec& r, Vec& i)
    {
-      output_re[ti] = mFft_data[ti];
-      output_im[ti] = mFft_data[mNfft - 1 - ti];
+      Vec tmp = VecSub(VecMul(wr, r), VecMul(wi, i));
+      i = VecAdd(VecMul(wr, i), VecMul(wi, r));
+      r = tmp;
    }
-   output_re[hnfft] = mFft_data[hnfft];
-   output_im[hnfft] = 0;
 }
 
-// Perform inverse FFT, returning real data
-// Accepts:
-//   input_re - pointer to an array of the real part of the output,
-//     size nfft/2 + 1
-//   input_im - pointer to an array of the imaginary part of the output,
-//     size nfft/2 + 1
-//   output - pointer to an array of (real) input values, size nfft
-void FFT::Inverse(float* input_re, float* input_im, float* output)
+FFTPlan::FFTPlan(int nfft)
+: mNfft(nfft)
+, mNumPoints(nfft / 2)
 {
-   int hnfft;
-
-   hnfft = mNfft / 2;
+   assert(nfft >= 2 && (nfft & (nfft - 1)) == 0);
 
-   for (int ti = 0; ti < hnfft; ti++)
+   for (int n = mNumPoints; n >= 4; n /= 4)
    {
-      mFft_data[ti] = input_re[ti];
-      mFft_data[mNfft - 1 - ti] = input_im[ti];
+      int quarter = n / 4;
+      size_t offset = mPassTwiddles.size();
+      mPassTwiddles.resize(offset + 6 * quarter);
+      float* twiddles = mPassTwiddles.data() + offset;
+      for (int p = 0; p < quarter; ++p)
+      {
+         for (int power = 1; power <= 3; ++power)
+         {
+            double angle = -2 * M_PI * power * p / n;
+            twiddles[(power - 1) * 2 * quarter + p] = cos(angle);
+            twiddles[(power - 1) * 2 * quarter + quarter + p] = sin(angle);
+         }
+      }
    }
-   mFft_data[hnfft] = input_re[hnfft];
-
-   mayer_realifft(mNfft, mFft_data);
 
-   for (int ti = 0; ti < mNfft; ti++)
+   mSplitCos.resize(mNumPoints + 1);
+   mSplitSin.resize(mNumPoints + 1);
+   for (int k = 0; k <= mNumPoints; ++k)
    {
-      output[ti] = mFft_data[ti];
+      mSplitCos[k] = cos(2 * M_PI * k / nfft);
+      mSplitSin[k] = sin(2 * M_PI * k / nfft);
    }
 }
 
-
-/* This is the FFT routine taken from PureData, a great piece of
- software by Miller S. Puckette.
- http://crca.ucsd.edu/~msp/software.html */
-
-/*
- ** FFT and FHT routines
- **  Copyright 1988, 1993; Ron Mayer
- **
- **  mayer_fht(fz,n);
- **      Does a hartley transform of "n" points in the array "fz".
- **  mayer_fft(n,real,imag)
- **      Does a fourier transform of "n" points of the "real" and
- **      "imag" arrays.
- **  mayer_ifft(n,real,imag)
- **      Does an inverse fourier transform of "n" points of the "real"
- **      and "imag" arrays.
- **  mayer_realfft(n,real)
- **      Does a real-valued fourier transform of "n" points of the
- **      "real" array.  The real part of the transform ends
- **      up in the first half of the array and the imaginary part of the
- **      transform ends up in the second half of the array.
- **  mayer_realifft(n,real)
- **      The inverse of the realfft() routine above.
- **
- **
- ** NOTE: This routine uses at least 2 patented algorithms, and may be
- **       under the restrictions of a bunch of different organizations.
- **       Although I wrote it completely myself, it is kind of a derivative
- **       of a routine I once authored and released under the GPL, so it
- **       may fall under the free software foundation's restrictions;
- **       it was worked on as a Stanford Univ project, so they claim
- **       some rights to it; it was further optimized at work here, so
- **       I think this company claims parts of it.  The patents are
- **       held by R. Bracewell (the FHT algorithm) and O. Buneman (the
- **       trig generator), both at Stanford Univ.
- **       If it were up to me, I'd say go do whatever you want with it;
- **       but it would be polite to give credit to the following people
- **       if you use this anywhere:
- **           Euler     - probable inventor of the fourier transform.
- **           Gauss     - probable inventor of the FFT.
- **           Hartley   - probable inventor of the hartley transform.
- **           Buneman   - for a really cool trig generator
- **           Mayer(me) - for authoring this particular version and
- **                       including all the optimizations in one package.
- **       Thanks,
- **       Ron Mayer; mayer@acuson.com
- **
- */
-
-/* This is a slightly modified version of Mayer's contribution; write
- * msp@ucsd.edu for the original code.  Kudos to Mayer for a fine piece
- * of work.  -msp
- */
-
-#define REAL float
-#define GOOD_TRIG
-
-#ifdef GOOD_TRIG
-#else
-#define FAST_TRIG
-#endif
-
-#if defined(GOOD_TRIG)
-#define FHT_SWAP(a, b, t) \
-   {                      \
-      (t) = (a);          \
-      (a) = (b);          \
-      (b) = (t);          \
-   }
-#define TRIG_VARS \
-   int t_lam = 0;
-#define TRIG_INIT(k, c, s)      \
-   {                            \
-      int i;                    \
-      for (i = 2; i <= k; i++)  \
-      {                         \
-         coswrk[i] = costab[i]; \
-         sinwrk[i] = sintab[i]; \
-      }                         \
-      t_lam = 0;                \
-      c = 1;                    \
-      s = 0;                    \
-   }
-#define TRIG_NEXT(k, c, s)                                    \
-   {                                                          \
-      int i, j;                                               \
-      (t_lam)++;                                              \
-      for (i = 0; !((1 << i) & t_lam); i++)                   \
-         ;                                                    \
-      i = k - i;                                              \
-      s = sinwrk[i];                                          \
-      c = coswrk[i];                                          \
-      if (i > 1)                                              \
-      {                                                       \
-         for (j = k - i + 2; (1 << j) & t_lam; j++)           \
-            ;                                                 \
-         j = k - j;                                           \
-         sinwrk[i] = halsec[i] * (sinwrk[i - 1] + sinwrk[j]); \
-         coswrk[i] = halsec[i] * (coswrk[i - 1] + coswrk[j]); \
-      }                                                       \
-   }
-#define TRIG_RESET(k, c, s)
-#endif
-
-#if defined(FAST_TRIG)
-#define TRIG_VARS \
-   REAL t_c, t_s;
-#define TRIG_INIT(k, c, s) \
-   {                       \
-      t_c = costab[k];     \
-      t_s = sintab[k];     \
-      c = 1;               \
-      s = 0;               \
-   }
-#define TRIG_NEXT(k, c, s)   \
-   {                         \
-      REAL t = c;            \
-      c = t * t_c - s * t_s; \
-      s = t * t_s + s * t_c; \
-   }
-#define TRIG_RESET(k, c, s)
-#endif
-
-static REAL halsec[20] = {
-   0,
-   0,
-   .54119610014619698439972320536638942006107206337801,
-   .50979557910415916894193980398784391368261849190893,
-   .50241928618815570551167011928012092247859337193963,
-   .50060299823519630134550410676638239611758632599591,
-   .50015063602065098821477101271097658495974913010340,
-   .50003765191554772296778139077905492847503165398345,
-   .50000941253588775676512870469186533538523133757983,
-   .50000235310628608051401267171204408939326297376426,
-   .50000058827484117879868526730916804925780637276181,
-   .50000014706860214875463798283871198206179118093251,
-   .50000003676714377807315864400643020315103490883972,
-   .50000000919178552207366560348853455333939112569380,
-   .50000000229794635411562887767906868558991922348920,
-   .50000000057448658687873302235147272458812263401372
-};
-static REAL costab[20] = {
-   .00000000000000000000000000000000000000000000000000,
-   .70710678118654752440084436210484903928483593768847,
-   .92387953251128675612818318939678828682241662586364,
-   .98078528040323044912618223613423903697393373089333,
-   .99518472667219688624483695310947992157547486872985,
-   .99879545620517239271477160475910069444320361470461,
-   .99969881869620422011576564966617219685006108125772,
-   .99992470183914454092164649119638322435060646880221,
-   .99998117528260114265699043772856771617391725094433,
-   .99999529380957617151158012570011989955298763362218,
-   .99999882345170190992902571017152601904826792288976,
-   .99999970586288221916022821773876567711626389934930,
-   .99999992646571785114473148070738785694820115568892,
-   .99999998161642929380834691540290971450507605124278,
-   .99999999540410731289097193313960614895889430318945,
-   .99999999885102682756267330779455410840053741619428
-};
-static REAL sintab[20] = {
-   1.0000000000000000000000000000000000000000000000000,
-   .70710678118654752440084436210484903928483593768846,
-   .38268343236508977172845998403039886676134456248561,
-   .19509032201612826784828486847702224092769161775195,
-   .09801714032956060199419556388864184586113667316749,
-   .04906767432741801425495497694268265831474536302574,
-   .02454122852291228803173452945928292506546611923944,
-   .01227153828571992607940826195100321214037231959176,
-   .00613588464915447535964023459037258091705788631738,
-   .00306795676296597627014536549091984251894461021344,
-   .00153398018628476561230369715026407907995486457522,
-   .00076699031874270452693856835794857664314091945205,
-   .00038349518757139558907246168118138126339502603495,
-   .00019174759731070330743990956198900093346887403385,
-   .00009587379909597734587051721097647635118706561284,
-   .00004793689960306688454900399049465887274686668768
-};
-static REAL coswrk[20] = {
-   .00000000000000000000000000000000000000000000000000,
-   .70710678118654752440084436210484903928483593768847,
-   .92387953251128675612818318939678828682241662586364,
-   .98078528040323044912618223613423903697393373089333,
-   .99518472667219688624483695310947992157547486872985,
-   .99879545620517239271477160475910069444320361470461,
-   .99969881869620422011576564966617219685006108125772,
-   .99992470183914454092164649119638322435060646880221,
-   .99998117528260114265699043772856771617391725094433,
-   .99999529380957617151158012570011989955298763362218,
-   .99999882345170190992902571017152601904826792288976,
-   .99999970586288221916022821773876567711626389934930,
-   .99999992646571785114473148070738785694820115568892,
-   .99999998161642929380834691540290971450507605124278,
-   .99999999540410731289097193313960614895889430318945,
-   .99999999885102682756267330779455410840053741619428
-};
-static REAL sinwrk[20] = {
-   1.0000000000000000000000000000000000000000000000000,
-   .70710678118654752440084436210484903928483593768846,
-   .38268343236508977172845998403039886676134456248561,
-   .19509032201612826784828486847702224092769161775195,
-   .09801714032956060199419556388864184586113667316749,
-   .04906767432741801425495497694268265831474536302574,
-   .02454122852291228803173452945928292506546611923944,
-   .01227153828571992607940826195100321214037231959176,
-   .00613588464915447535964023459037258091705788631738,
-   .00306795676296597627014536549091984251894461021344,
-   .00153398018628476561230369715026407907995486457522,
-   .00076699031874270452693856835794857664314091945205,
-   .00038349518757139558907246168118138126339502603495,
-   .00019174759731070330743990956198900093346887403385,
-   .00009587379909597734587051721097647635118706561284,
-   .00004793689960306688454900399049465887274686668768
-};
-
-
-#define SQRT2_2 0.70710678118654752440084436210484
-#define SQRT2 2 * 0.70710678118654752440084436210484
-
-void mayer_fht(REAL* fz, int n)
+//forward complex transform of mNumPoints, in place in re/im. work needs the same amount of room again
+void FFTPlan::Transform(float* re, float* im, float* workRe, float* workIm) const
 {
-   /*  REAL a,b;
-    REAL c1,s1,s2,c2,s3,c3,s4,c4;
-    REAL f0,g0,f1,g1,f2,g2,f3,g3; */
-   int k, k1, k2, k3, k4, kx;
-   REAL *fi, *fn, *gi;
-   TRIG_VARS;
-
-   for (k1 = 1, k2 = 0; k1 < n; k1++)
+   float* xr = re;
+   float* xi = im;
+   float* yr = workRe;
+   float* yi = workIm;
+   const float* twiddles = mPassTwiddles.data();
+   int stride = 1;
+
+   for (int n = mNumPoints; n >= 4; n /= 4)
    {
-      REAL aa;
-      for (k = n >> 1; (!((k2 ^= k) & k)); k >>= 1)
-         ;
-      if (k1 > k2)
+      const int quarter = n / 4;
+      const float* w1r = twiddles;
+      const float* w1i = w1r + quarter;
+      const float* w2r = w1i + quarter;
+      const float* w2i = w2r + quarter;
+      const float* w3r = w2i + quarter;
+      const float* w3i = w3r + quarter;
+      twiddles += 6 * quarter;
+
+      if (stride >= kNumLanes)
       {
-         aa = fz[k1];
-         fz[k1] = fz[k2];
-         fz[k2] = aa;
+         //butterflies that share a twiddle are contiguous
+         for (int p = 0; p < quarter; ++p)
+         {
+            Vec vw1r = VecSet(w1r[p]), vw1i = VecSet(w1i[p]);
+            Vec vw2r = VecSet(w2r[p]), vw2i = VecSet(w2i[p]);
+            Vec vw3r = VecSet(w3r[p]), vw3i = VecSet(w3i[p]);
+            const int in = stride * p;
+            const int out = stride * 4 * p;
+            for (int q = 0; q < stride; q += kNumLanes)
+            {
+               Vec ar = VecLoad(xr + in + q), ai = VecLoad(xi + in + q);
+               Vec br = VecLoad(xr + in + stride * quarter + q), bi = VecLoad(xi + in + stride * quarter + q);
+               Vec cr = VecLoad(xr + in + stride * 2 * quarter + q), ci = VecLoad(xi + in + stride * 2 * quarter + q);
+               Vec dr = VecLoad(xr + in + stride * 3 * quarter + q), di = VecLoad(xi + in + stride * 3 * quarter + q);
+
+               Vec apcR = VecAdd(ar, cr), apcI = VecAdd(ai, ci);
+               Vec amcR = VecSub(ar, cr), amcI = VecSub(ai, ci);
+               Vec bpdR = VecAdd(br, dr), bpdI = VecAdd(bi, di);
+               Vec bmdR = VecSub(br, dr), bmdI = VecSub(bi, di);
+
+               Vec y1r = VecAdd(amcR, bmdI), y1i = VecSub(amcI, bmdR);
+               Vec y2r = VecSub(apcR, bpdR), y2i = VecSub(apcI, bpdI);
+               Vec y3r = VecSub(amcR, bmdI), y3i = VecAdd(amcI, bmdR);
+               ComplexMult(vw1r, vw1i, y1r, y1i);
+               ComplexMult(vw2r, vw2i, y2r, y2i);
+               ComplexMult(vw3r, vw3i, y3r, y3i);
+
+               VecStore(yr + out + q, VecAdd(apcR, bpdR));
+               VecStore(yi + out + q, VecAdd(apcI, bpdI));
+               VecStore(yr + out + stride + q, y1r);
+               VecStore(yi + out + stride + q, y1i);
+               VecStore(yr + out + stride * 2 + q, y2r);
+               VecStore(yi + out + stride * 2 + q, y2i);
+               VecStore(yr + out + stride * 3 + q, y3r);
+               VecStore(yi + out + stride * 3 + q, y3i);
+            }
+         }
       }
-   }
-   for (k = 0; (1 << k) < n; k++)
-      ;
-   k &= 1;
-   if (k == 0)
-   {
-      for (fi = fz, fn = fz + n; fi < fn; fi += 4)
+      else if (quarter >= kNumLanes)
       {
-         REAL f0, f1, f2, f3;
-         f1 = fi[0] - fi[1];
-         f0 = fi[0] + fi[1];
-         f3 = fi[2] - fi[3];
-         f2 = fi[2] + fi[3];
-         fi[2] = (f0 - f2);
-         fi[0] = (f0 + f2);
-         fi[3] = (f1 - f3);
-         fi[1] = (f1 + f3);
+         //first pass: run neighbouring butterflies side by side, then transpose so each one's four outputs land together
+         for (int p = 0; p < quarter; p += kNumLanes)
+         {
+            Vec ar = VecLoad(xr + p), ai = VecLoad(xi + p);
+            Vec br = VecLoad(xr + quarter + p), bi = VecLoad(xi + quarter + p);
+            Vec cr = VecLoad(xr + 2 * quarter + p), ci = VecLoad(xi + 2 * quarter + p);
+            Vec dr = VecLoad(xr + 3 * quarter + p), di = VecLoad(xi + 3 * quarter + p);
+
+            Vec apcR = VecAdd(ar, cr), apcI = VecAdd(ai, ci);
+            Vec amcR = VecSub(ar, cr), amcI = VecSub(ai, ci);
+            Vec bpdR = VecAdd(br, dr), bpdI = VecAdd(bi, di);
+            Vec bmdR = VecSub(br, dr), bmdI = VecSub(bi, di);
+
+            Vec y0r = VecAdd(apcR, bpdR), y0i = VecAdd(apcI, bpdI);
+            Vec y1r = VecAdd(amcR, bmdI), y1i = VecSub(amcI, bmdR);
+            Vec y2r = VecSub(apcR, bpdR), y2i = VecSub(apcI, bpdI);
+            Vec y3r = VecSub(amcR, bmdI), y3i = VecAdd(amcI, bmdR);
+            ComplexMult(VecLoad(w1r + p), VecLoad(w1i + p), y1r, y1i);
+            ComplexMult(VecLoad(w2r + p), VecLoad(w2i + p), y2r, y2i);
+            ComplexMult(VecLoad(w3r + p), VecLoad(w3i + p), y3r, y3i);
+
+            VecTranspose(y0r, y1r, y2r, y3r);
+            VecTranspose(y0i, y1i, y2i, y3i);
+            VecStore(yr + 4 * p, y0r);
+            VecStore(yi + 4 * p, y0i);
+            VecStore(yr + 4 * p + 4, y1r);
+            VecStore(yi + 4 * p + 4, y1i);
+            VecStore(yr + 4 * p + 8, y2r);
+            VecStore(yi + 4 * p + 8, y2i);
+            VecStore(yr + 4 * p + 12, y3r);
+            VecStore(yi + 4 * p + 12, y3i);
+         }
       }
-   }
-   else
-   {
-      for (fi = fz, fn = fz + n, gi = fi + 1; fi < fn; fi += 8, gi += 8)
+      else
       {
-         REAL bs1, bc1, bs2, bc2, bs3, bc3, bs4, bc4,
-         bg0, bf0, bf1, bg1, bf2, bg2, bf3, bg3;
-         bc1 = fi[0] - gi[0];
-         bs1 = fi[0] + gi[0];
-         bc2 = fi[2] - gi[2];
-         bs2 = fi[2] + gi[2];
-         bc3 = fi[4] - gi[4];
-         bs3 = fi[4] + gi[4];
-         bc4 = fi[6] - gi[6];
-         bs4 = fi[6] + gi[6];
-         bf1 = (bs1 - bs2);
-         bf0 = (bs1 + bs2);
-         bg1 = (bc1 - bc2);
-         bg0 = (bc1 + bc2);
-         bf3 = (bs3 - bs4);
-         bf2 = (bs3 + bs4);
-         bg3 = SQRT2 * bc4;
-         bg2 = SQRT2 * bc3;
-         fi[4] = bf0 - bf2;
-         fi[0] = bf0 + bf2;
-         fi[6] = bf1 - bf3;
-         fi[2] = bf1 + bf3;
-         gi[4] = bg0 - bg2;
-         gi[0] = bg0 + bg2;
-         gi[6] = bg1 - bg3;
-         gi[2] = bg1 + bg3;
+         for (int p = 0; p < quarter; ++p)
+         {
+            for (int q = 0; q < stride; ++q)
+            {
+               const int in = q + stride * p;
+               const int out = q + stride * 4 * p;
+               float ar = xr[in], ai = xi[in];
+               float br = xr[in + stride * quarter], bi = xi[in + stride * quarter];
+               float cr = xr[in + stride * 2 * quarter], ci = xi[in + stride * 2 * quarter];
+               float dr = xr[in + stride * 3 * quarter], di = xi[in + stride * 3 * quarter];
+
+               float apcR = ar + cr, apcI = ai + ci;
+               float amcR = ar - cr, amcI = ai - ci;
+               float bpdR = br + dr, bpdI = bi + di;
+               float bmdR = br - dr, bmdI = bi - di;
+
+               float y1r = amcR + bmdI, y1i = amcI - bmdR;
+               float y2r = apcR - bpdR, y2i = apcI - bpdI;
+               float y3r = amcR - bmdI, y3i = amcI + bmdR;
+               ComplexMult(w1r[p], w1i[p], y1r, y1i);
+               ComplexMult(w2r[p], w2i[p], y2r, y2i);
+               ComplexMult(w3r[p], w3i[p], y3r, y3i);
+
+               yr[out] = apcR + bpdR;
+               yi[out] = apcI + bpdI;
+               yr[out + stride] = y1r;
+               yi[out + stride] = y1i;
+               yr[out + stride * 2] = y2r;
+               yi[out + stride * 2] = y2i;
+               yr[out + stride * 3] = y3r;
+               yi[out + stride * 3] = y3i;
+            }
+         }
       }
+
+      std::swap(xr, yr);
+      std::swap(xi, yi);
+      stride *= 4;
    }
-   if (n < 16)
-      return;
 
-   do
+   if (stride < mNumPoints) //odd power of two, finish with a radix-2 pass
    {
-      REAL s1, c1;
-      int ii;
-      k += 2;
-      k1 = 1 << k;
-      k2 = k1 << 1;
-      k4 = k2 << 1;
-      k3 = k2 + k1;
-      kx = k1 >> 1;
-      fi = fz;
-      gi = fi + kx;
-      fn = fz + n;
-      do
+      int q = 0;
+      for (; q + kNumLanes <= stride; q += kNumLanes)
       {
-         REAL g0, f0, f1, g1, f2, g2, f3, g3;
-         f1 = fi[0] - fi[k1];
-         f0 = fi[0] + fi[k1];
-         f3 = fi[k2] - fi[k3];
-         f2 = fi[k2] + fi[k3];
-         fi[k2] = f0 - f2;
-         fi[0] = f0 + f2;
-         fi[k3] = f1 - f3;
-         fi[k1] = f1 + f3;
-         g1 = gi[0] - gi[k1];
-         g0 = gi[0] + gi[k1];
-         g3 = SQRT2 * gi[k3];
-         g2 = SQRT2 * gi[k2];
-         gi[k2] = g0 - g2;
-         gi[0] = g0 + g2;
-         gi[k3] = g1 - g3;
-         gi[k1] = g1 + g3;
-         gi += k4;
-         fi += k4;
-      } while (fi < fn);
-      TRIG_INIT(k, c1, s1);
-      for (ii = 1; ii < kx; ii++)
+         Vec ar = VecLoad(xr + q), ai = VecLoad(xi + q);
+         Vec br = VecLoad(xr + stride + q), bi = VecLoad(xi + stride + q);
+         VecStore(yr + q, VecAdd(ar, br));
+         VecStore(yi + q, VecAdd(ai, bi));
+         VecStore(yr + stride + q, VecSub(ar, br));
+         VecStore(yi + stride + q, VecSub(ai, bi));
+      }
+      for (; q < stride; ++q)
       {
-         REAL c2, s2;
-         TRIG_NEXT(k, c1, s1);
-         c2 = c1 * c1 - s1 * s1;
-         s2 = 2 * (c1 * s1);
-         fn = fz + n;
-         fi = fz + ii;
-         gi = fz + k1 - ii;
-         do
-         {
-            REAL a, b, g0, f0, f1, g1, f2, g2, f3, g3;
-            b = s2 * fi[k1] - c2 * gi[k1];
-            a = c2 * fi[k1] + s2 * gi[k1];
-            f1 = fi[0] - a;
-            f0 = fi[0] + a;
-            g1 = gi[0] - b;
-            g0 = gi[0] + b;
-            b = s2 * fi[k3] - c2 * gi[k3];
-            a = c2 * fi[k3] + s2 * gi[k3];
-            f3 = fi[k2] - a;
-            f2 = fi[k2] + a;
-            g3 = gi[k2] - b;
-            g2 = gi[k2] + b;
-            b = s1 * f2 - c1 * g3;
-            a = c1 * f2 + s1 * g3;
-            fi[k2] = f0 - a;
-            fi[0] = f0 + a;
-            gi[k3] = g1 - b;
-            gi[k1] = g1 + b;
-            b = c1 * g2 - s1 * f3;
-            a = s1 * g2 + c1 * f3;
-            gi[k2] = g0 - a;
-            gi[0] = g0 + a;
-            fi[k3] = f1 - b;
-            fi[k1] = f1 + b;
-            gi += k4;
-            fi += k4;
-         } while (fi < fn);
+         float ar = xr[q], ai = xi[q];
+         float br = xr[stride + q], bi = xi[stride + q];
+         yr[q] = ar + br;
+         yi[q] = ai + bi;
+         yr[stride + q] = ar - br;
+         yi[stride + q] = ai - bi;
       }
-      TRIG_RESET(k, c1, s1);
-   } while (k4 < n);
-}
+      std::swap(xr, yr);
+      std::swap(xi, yi);
+   }
 
-void mayer_fft(int n, REAL* real, REAL* imag)
-{
-   REAL a, b, c, d;
-   REAL q, r, s, t;
-   int i, j, k;
-   for (i = 1, j = n - 1, k = n / 2; i < k; i++, j--)
+   if (xr != re)
    {
-      a = real[i];
-      b = real[j];
-      q = a + b;
-      r = a - b;
-      c = imag[i];
-      d = imag[j];
-      s = c + d;
-      t = c - d;
-      real[i] = (q + t) * .5;
-      real[j] = (q - t) * .5;
-      imag[i] = (s - r) * .5;
-      imag[j] = (s + r) * .5;
+      std::memcpy(re, xr, mNumPoints * sizeof(float));
+      std::memcpy(im, xi, mNumPoints * sizeof(float));
    }
-   mayer_fht(real, n);
-   mayer_fht(imag, n);
 }
 
-void mayer_ifft(int n, REAL* real, REAL* imag)
+FFT::FFT(int nfft)
 {
-   REAL a, b, c, d;
-   REAL q, r, s, t;
-   int i, j, k;
-   mayer_fht(real, n);
-   mayer_fht(imag, n);
-   for (i = 1, j = n - 1, k = n / 2; i < k; i++, j--)
-   {
-      a = real[i];
-      b = real[j];
-      q = a + b;
-      r = a - b;
-      c = imag[i];
-      d = imag[j];
-      s = c + d;
-      t = c - d;
-      imag[i] = (s + r) * 0.5;
-      imag[j] = (s - r) * 0.5;
-      real[i] = (q - t) * 0.5;
-      real[j] = (q + t) * 0.5;
-   }
+   mNfft = nfft;
+   mNumfreqs = nfft / 2 + 1;
+
+   mPlan = GetPlan(nfft);
+   mWorkspace.resize(nfft * 2);
 }
 
-void mayer_realfft(int n, REAL* real)
+// Perform forward FFT of real data
+// Accepts:
+//   input - pointer to an array of (real) input values, size nfft
+//   output_re - pointer to an array of the real part of the output,
+//     size nfft/2 + 1
+//   output_im - pointer to an array of the imaginary part of the output,
+//     size nfft/2 + 1
+void FFT::Forward(const float* input, float* output_re, float* output_im)
 {
-   REAL a, b;
-   int i, j, k;
+   const int hnfft = mNfft / 2;
+   float* zr = mWorkspace.data();
+   float* zi = zr + hnfft;
+
+   for (int i = 0; i < hnfft; ++i)
+   {
+      zr[i] = input[2 * i];
+      zi[i] = input[2 * i + 1];
+   }
+
+   mPlan->Transform(zr, zi, zi + hnfft, zi + 2 * hnfft);
 
-   mayer_fht(real, n);
-   for (i = 1, j = n - 1, k = n / 2; i < k; i++, j--)
+   //bin k comes from the half size bins k and hnfft-k: half their conjugate sum is the even samples' spectrum,
+   //half their conjugate difference (rotated by -i) is the odd samples', which gets twiddled by e^(-2*pi*i*k/nfft)
+   const float* cosK = mPlan->mSplitCos.data();
+   const float* sinK = mPlan->mSplitSin.data();
+   const Vec half = VecSet(.5f);
+   int k = 1;
+   for (; k + kNumLanes <= hnfft; k += kNumLanes)
    {
-      a = real[i];
-      b = real[j];
-      real[j] = (a - b) * 0.5;
-      real[i] = (a + b) * 0.5;
+      Vec zkr = VecLoad(zr + k), zki = VecLoad(zi + k);
+      Vec zmr = VecReverse(VecLoad(zr + hnfft - k - (kNumLanes - 1)));
+      Vec zmi = VecReverse(VecLoad(zi + hnfft - k - (kNumLanes - 1)));
+      Vec c = VecLoad(cosK + k), s = VecLoad(sinK + k);
+      Vec er = VecMul(half, VecAdd(zkr, zmr)), ei = VecMul(half, VecSub(zki, zmi));
+      Vec dr = VecMul(half, VecSub(zkr, zmr)), di = VecMul(half, VecAdd(zki, zmi));
+      VecStore(output_re + k, VecAdd(er, VecSub(VecMul(c, di), VecMul(s, dr))));
+      VecStore(output_im + k, VecSub(ei, VecAdd(VecMul(c, dr), VecMul(s, di))));
    }
+   for (; k < hnfft; ++k)
+   {
+      float er = .5f * (zr[k] + zr[hnfft - k]), ei = .5f * (zi[k] - zi[hnfft - k]);
+      float dr = .5f * (zr[k] - zr[hnfft - k]), di = .5f * (zi[k] + zi[hnfft - k]);
+      output_re[k] = er + cosK[k] * di - sinK[k] * dr;
+      output_im[k] = ei - cosK[k] * dr - sinK[k] * di;
+   }
+
+   output_re[0] = zr[0] + zi[0];
+   output_im[0] = 0;
+   output_re[hnfft] = zr[0] - zi[0];
+   output_im[hnfft] = 0;
 }
 
-void mayer_realifft(int n, REAL* real)
+// Perform inverse FFT, returning real data
+// Accepts:
+//   input_re - pointer to an array of the real part of the output,
+//     size nfft/2 + 1
+//   input_im - pointer to an array of the imaginary part of the output,
+//     size nfft/2 + 1
+//   output - pointer to an array of (real) input values, size nfft
+void FFT::Inverse(const float* input_re, const float* input_im, float* output)
 {
-   REAL a, b;
-   int i, j, k;
+   const int hnfft = mNfft / 2;
+   float* zr = mWorkspace.data();
+   float* zi = zr + hnfft;
+
+   //the reverse of the untangling in Forward(), conjugated so the forward transform can do the inverse
+   const float* cosK = mPlan->mSplitCos.data();
+   const float* sinK = mPlan->mSplitSin.data();
+   int k = 1;
+   for (; k + kNumLanes <= hnfft; k += kNumLanes)
+   {
+      Vec xkr = VecLoad(input_re + k), xki = VecLoad(input_im + k);
+      Vec xmr = VecReverse(VecLoad(input_re + hnfft - k - (kNumLanes - 1)));
+      Vec xmi = VecReverse(VecLoad(input_im + hnfft - k - (kNumLanes - 1)));
+      Vec c = VecLoad(cosK + k), s = VecLoad(sinK + k);
+      Vec er = VecAdd(xkr, xmr), ei = VecSub(xki, xmi);
+      Vec dr = VecSub(xkr, xmr), di = VecAdd(xki, xmi);
+      VecStore(zr + k, VecSub(er, VecAdd(VecMul(s, dr), VecMul(c, di))));
+      VecStore(zi + k, VecSub(VecSub(VecMul(s, di), VecMul(c, dr)), ei));
+   }
+   for (; k < hnfft; ++k)
+   {
+      float er = input_re[k] + input_re[hnfft - k], ei = input_im[k] - input_im[hnfft - k];
+      float dr = input_re[k] - input_re[hnfft - k], di = input_im[k] + input_im[hnfft - k];
+      zr[k] = er - sinK[k] * dr - cosK[k] * di;
+      zi[k] = -(ei + cosK[k] * dr - sinK[k] * di);
+   }
+   zr[0] = input_re[0] + input_re[hnfft];
+   zi[0] = input_re[hnfft] - input_re[0];
+
+   mPlan->Transform(zr, zi, zi + hnfft, zi + 2 * hnfft);
 
-   for (i = 1, j = n - 1, k = n / 2; i < k; i++, j--)
+   for (int i = 0; i < hnfft; ++i)
    {
-      a = real[i];
-      b = real[j];
-      real[j] = (a - b);
-      real[i] = (a + b);
+      output[2 * i] = zr[i];
+      output[2 * i + 1] = -zi[i];
    }
-   mayer_fht(real, n);
 }
 
 void FFTData::Clear()
@@ -27,21 +27,25 @@
 #define __modularSynth__FFT__
 
 #include <iostream>
+#include <vector>
 #include "SynthGlobals.h"
 
-// Variables for FFT routine
+struct FFTPlan;
+
+//real fft of a power of two size. Forward() gives nfft/2 + 1 bins, Inverse() takes them back and leaves the result
+//scaled up by nfft. the tables for each size are built once and shared, so an instance only owns its scratch space
 class FFT
 {
 public:
    FFT(int nfft);
-   ~FFT();
-   void Forward(float* input, float* output_re, float* output_im);
-   void Inverse(float* input_re, float* input_im, float* output);
+   void Forward(const float* input, float* output_re, float* output_im);
+   void Inverse(const float* input_re, const float* input_im, float* output);
 
 private:
    int mNfft{ 0 }; // size of FFT
    int mNumfreqs{ 0 }; // number of frequencies represented (nfft/2 + 1)
-   float* mFft_data{ nullptr }; // array for writing/reading to/from FFT function
+   const FFTPlan* mPlan{ nullptr };
+   std::vector<float> mWorkspace; // two half size complex buffers, split into real and imaginary parts
 };
 
 struct FFTData
@@ -72,16 +76,4 @@ struct FFTData
    float* mTimeDomain{ nullptr };
 };
 
-
-#ifndef MAYER_H
-#define MAYER_H
-
-#define REAL float
-
-void mayer_realfft(int n, REAL* real);
-void mayer_realifft(int n, REAL* real);
-
-#endif
-
-
 #endif /* defined(__modularSynth__FFT__) */
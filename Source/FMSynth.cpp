@@ -129,6 +129,7 @@ void FMSynth::Process(double time)
 
    mNoteInputBuffer.Process(time);
 
+   ComputeSliderBlocks();
    ComputeSliders(0);
 
    int bufferSize = target->GetBuffer()->BufferSize();
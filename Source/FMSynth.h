@@ -51,6 +51,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override;
 
    //INoteReceiver
@@ -40,6 +40,11 @@ FMVoice::~FMVoice()
 {
 }
 
+void FMVoice::SetMaxBufferSize(int bufferSize)
+{
+   mEnvelopeBuffer.assign(bufferSize * 5, 0);
+}
+
 bool FMVoice::IsDone(double time)
 {
    return mOsc.GetADSR()->IsDone(time);
@@ -52,19 +57,21 @@ bool FMVoice::Process(double time, ChannelBuffer* out, int oversampling)
    if (IsDone(time))
       return false;
 
-   int bufferSize = out->BufferSize();
+   int bufferSize = out->BufferSize(); //already at the oversampled rate
    int channels = out->NumActiveChannels();
-   double sampleIncrementMs = gInvSampleRateMs;
-   ChannelBuffer* destBuffer = out;
-
-   if (oversampling != 1)
-   {
-      gMidiVoiceWorkChannelBuffer.SetNumActiveChannels(channels);
-      destBuffer = &gMidiVoiceWorkChannelBuffer;
-      gMidiVoiceWorkChannelBuffer.Clear();
-      bufferSize *= oversampling;
-      sampleIncrementMs /= oversampling;
-   }
+   double sampleIncrementMs = gInvSampleRateMs / oversampling;
+
+   assert((int)mEnvelopeBuffer.size() >= bufferSize * 5);
+   float* oscEnv = mEnvelopeBuffer.data();
+   float* harmEnv = oscEnv + bufferSize;
+   float* harmEnv2 = harmEnv + bufferSize;
+   float* modIdxEnv = harmEnv2 + bufferSize;
+   float* modIdxEnv2 = modIdxEnv + bufferSize;
+   mOsc.GetADSR()->FillBuffer(time, sampleIncrementMs, oscEnv, bufferSize);
+   mHarm.GetADSR()->FillBuffer(time, sampleIncrementMs, harmEnv, bufferSize);
+   mHarm2.GetADSR()->FillBuffer(time, sampleIncrementMs, harmEnv2, bufferSize);
+   mModIdx.FillBuffer(time, sampleIncrementMs, modIdxEnv, bufferSize);
+   mModIdx2.FillBuffer(time, sampleIncrementMs, modIdxEnv2, bufferSize);
 
    for (int pos = 0; pos < bufferSize; ++pos)
    {
@@ -72,8 +79,8 @@ bool FMVoice::Process(double time, ChannelBuffer* out, int oversampling)
          mOwner->ComputeSliders(pos / oversampling);
 
       float oscFreq = TheScale->PitchToFreq(GetPitch(pos / oversampling));
-      float harmFreq = oscFreq * mHarm.GetADSR()->Value(time) * mVoiceParams->mHarmRatio;
-      float harmFreq2 = harmFreq * mHarm2.GetADSR()->Value(time) * mVoiceParams->mHarmRatio2;
+      float harmFreq = oscFreq * harmEnv[pos] * mVoiceParams->mHarmRatio;
+      float harmFreq2 = harmFreq * harmEnv2[pos] * mVoiceParams->mHarmRatio2;
 
       float harmPhaseInc2 = GetPhaseInc(harmFreq2) / oversampling;
 
@@ -83,7 +90,7 @@ bool FMVoice::Process(double time, ChannelBuffer* out, int oversampling)
          mHarmPhase2 -= FTWO_PI;
       }
 
-      float modHarmFreq = harmFreq + mHarm2.Audio(time, mHarmPhase2 + mVoiceParams->mPhaseOffset2) * harmFreq2 * mModIdx2.Value(time) * mVoiceParams->mModIdx2;
+      float modHarmFreq = harmFreq + mHarm2.mOsc.Value(mHarmPhase2 + mVoiceParams->mPhaseOffset2) * harmEnv2[pos] * harmFreq2 * modIdxEnv2[pos] * mVoiceParams->mModIdx2;
 
       float harmPhaseInc = GetPhaseInc(modHarmFreq) / oversampling;
 
@@ -93,7 +100,7 @@ bool FMVoice::Process(double time, ChannelBuffer* out, int oversampling)
          mHarmPhase -= FTWO_PI;
       }
 
-      float modOscFreq = oscFreq + mHarm.Audio(time, mHarmPhase + mVoiceParams->mPhaseOffset1) * harmFreq * mModIdx.Value(time) * mVoiceParams->mModIdx;
+      float modOscFreq = oscFreq + mHarm.mOsc.Value(mHarmPhase + mVoiceParams->mPhaseOffset1) * harmEnv[pos] * harmFreq * modIdxEnv[pos] * mVoiceParams->mModIdx;
       float oscPhaseInc = GetPhaseInc(modOscFreq) / oversampling;
 
       mOscPhase += oscPhaseInc;
@@ -102,36 +109,16 @@ bool FMVoice::Process(double time, ChannelBuffer* out, int oversampling)
          mOscPhase -= FTWO_PI;
       }
 
-      float sample = mOsc.Audio(time, mOscPhase + mVoiceParams->mPhaseOffset0) * mVoiceParams->mVol / 20.0f;
+      float sample = mOsc.mOsc.Value(mOscPhase + mVoiceParams->mPhaseOffset0) * oscEnv[pos] * mVoiceParams->mVol / 20.0f;
       if (channels == 1)
       {
-         destBuffer->GetChannel(0)[pos] += sample;
+         out->GetChannel(0)[pos] += sample;
       }
       else
       {
-         destBuffer->GetChannel(0)[pos] += sample * GetLeftPanGain(GetPan());
-         destBuffer->GetChannel(1)[pos] += sample * GetRightPanGain(GetPan());
+         out->GetChannel(0)[pos] += sample * GetLeftPanGain(GetPan());
+         out->GetChannel(1)[pos] += sample * GetRightPanGain(GetPan());
       }
-
-      time += sampleIncrementMs;
-   }
-
-   if (oversampling != 1)
-   {
-      //assume power-of-two
-      while (oversampling > 1)
-      {
-         for (int i = 0; i < bufferSize; ++i)
-         {
-            for (int ch = 0; ch < channels; ++ch)
-               destBuffer->GetChannel(ch)[i] = (destBuffer->GetChannel(ch)[i * 2] + destBuffer->GetChannel(ch)[i * 2 + 1]) / 2;
-         }
-         oversampling /= 2;
-         bufferSize /= 2;
-      }
-
-      for (int ch = 0; ch < channels; ++ch)
-         Add(out->GetChannel(ch), destBuffer->GetChannel(ch), bufferSize);
    }
 
    return true;
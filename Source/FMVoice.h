@@ -65,6 +65,7 @@ public:
    void ClearVoice() override;
    bool Process(double time, ChannelBuffer* out, int oversampling) override;
    void SetVoiceParams(IVoiceParams* params) override;
+   void SetMaxBufferSize(int bufferSize) override;
    bool IsDone(double time) override;
 
 private:
@@ -78,6 +79,7 @@ private:
    ::ADSR mModIdx2;
    FMVoiceParams* mVoiceParams{ nullptr };
    IDrawableModule* mOwner;
+   std::vector<float> mEnvelopeBuffer; //the five envelopes for the current block
 };
 
 #endif /* defined(__modularSynth__FMVoice__) */
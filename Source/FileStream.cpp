@@ -30,10 +30,16 @@
 bool FileStreamIn::s32BitMode = false;
 
 FileStreamOut::FileStreamOut(const std::string& file)
-: mStream(std::make_unique<juce::FileOutputStream>(juce::File{ file }))
 {
-   mStream->setPosition(0);
-   mStream->truncate();
+   auto fileStream = std::make_unique<juce::FileOutputStream>(juce::File{ file });
+   fileStream->setPosition(0);
+   fileStream->truncate();
+   mStream = std::move(fileStream);
+}
+
+FileStreamOut::FileStreamOut(juce::MemoryBlock& block)
+: mStream(std::make_unique<juce::MemoryOutputStream>(block, true))
+{
 }
 
 FileStreamOut::~FileStreamOut()
@@ -34,13 +34,15 @@
 namespace juce
 {
    class FileInputStream;
-   class FileOutputStream;
+   class MemoryBlock;
+   class OutputStream;
 }
 
 class FileStreamOut
 {
 public:
    explicit FileStreamOut(const std::string& file);
+   explicit FileStreamOut(juce::MemoryBlock& block); //appends to block
    FileStreamOut(const char*) = delete; // Hint: UTF-8 encoded std::string required
    ~FileStreamOut();
    FileStreamOut& operator<<(const int& var);
@@ -55,7 +57,7 @@ public:
    juce::int64 GetSize() const;
 
 private:
-   std::unique_ptr<juce::FileOutputStream> mStream;
+   std::unique_ptr<juce::OutputStream> mStream;
 };
 
 class FileStreamIn
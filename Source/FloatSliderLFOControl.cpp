@@ -303,9 +303,21 @@ float FloatSliderLFOControl::Value(int samplesIn /*= 0*/)
    return GetLFOValue(samplesIn);
 }
 
+void FloatSliderLFOControl::FillBuffer(float* values, int numSamples)
+{
+   ComputeSliders(0); //our own controls update at block rate here
+   mLFO.FillBuffer(values, numSamples);
+   for (int i = 0; i < numSamples; ++i)
+      values[i] = ShapeLFOValue(values[i]);
+}
+
 float FloatSliderLFOControl::GetLFOValue(int samplesIn /*= 0*/, float forcePhase /*= -1*/)
 {
-   float val = mLFO.Value(samplesIn, forcePhase);
+   return ShapeLFOValue(mLFO.Value(samplesIn, forcePhase));
+}
+
+float FloatSliderLFOControl::ShapeLFOValue(float val)
+{
    if (mLFOSettings.mSpread > 0)
       val = val * (1 - mLFOSettings.mSpread) + (-cosf(val * FPI) + 1) * .5f * mLFOSettings.mSpread;
    return ofClamp(Interp(val, GetMin(), GetMax()), GetTargetMin(), GetTargetMax());
@@ -111,6 +111,15 @@ float FreeverbEffect::GetEffectAmount()
    return mWet;
 }
 
+float FreeverbEffect::GetTailLengthMs()
+{
+   if (mFreeverb.getmode() >= freezemode)
+      return -1;
+   //long enough for the longest comb to fall by 100dB
+   float feedback = mRoomSize * scaleroom + offsetroom;
+   return logf(.00001f) / logf(feedback) * combtuningR8 * gInvSampleRateMs;
+}
+
 void FreeverbEffect::CheckboxUpdated(Checkbox* checkbox, double time)
 {
 }
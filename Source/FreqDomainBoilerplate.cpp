@@ -28,21 +28,13 @@
 
 namespace
 {
-   const int fftWindowSize = 1024;
-   const int fftFreqDomainSize = fftWindowSize / 2 + 1;
+   //where the output level sat with 256 sample buffers, back when it overlap-added a 1024 point frame every buffer
+   const float kOutputLevel = 1024 * 1.5f * .0001f;
 }
 
 FreqDomainBoilerplate::FreqDomainBoilerplate()
 : IAudioProcessor(gBufferSize)
-, mFFT(fftWindowSize)
-, mRollingInputBuffer(fftWindowSize)
-, mRollingOutputBuffer(fftWindowSize)
-, mFFTData(fftWindowSize, fftFreqDomainSize)
 {
-   // Generate a window with a single raised cosine from N/4 to 3N/4
-   mWindower = new float[fftWindowSize];
-   for (int i = 0; i < fftWindowSize; ++i)
-      mWindower[i] = -.5 * cos(FTWO_PI * i / fftWindowSize) + .5;
 }
 
 void FreqDomainBoilerplate::CreateUIControls()
@@ -55,11 +47,19 @@ void FreqDomainBoilerplate::CreateUIControls()
    mValue2Slider = new FloatSlider(this, "value 2", 5, 101, 100, 15, &mValue2, 0, 1);
    mValue3Slider = new FloatSlider(this, "value 3", 5, 119, 100, 15, &mValue3, 0, 1);
    mPhaseOffsetSlider = new FloatSlider(this, "phase off", 5, 137, 100, 15, &mPhaseOffset, 0, FTWO_PI);
+   mWindowSizeSelector = new DropdownList(this, "window", 5, 155, &mWindowSize);
+   mOverlapSelector = new DropdownList(this, "overlap", 70, 155, &mOverlap);
+   mHelperThreadCheckbox = new Checkbox(this, "thread", 120, 155, &mUseHelperThread);
+
+   for (int size = 256; size <= 4096; size *= 2)
+      mWindowSizeSelector->AddLabel(ofToString(size), size);
+   mOverlapSelector->AddLabel("2", 2);
+   mOverlapSelector->AddLabel("4", 4);
+   mOverlapSelector->AddLabel("8", 8);
 }
 
 FreqDomainBoilerplate::~FreqDomainBoilerplate()
 {
-   delete[] mWindower;
 }
 
 void FreqDomainBoilerplate::Process(double time)
@@ -78,22 +78,32 @@ void FreqDomainBoilerplate::Process(double time)
    float volSq = mVolume * mVolume;
 
    int bufferSize = GetBuffer()->BufferSize();
+   float* input = GetBuffer()->GetChannel(0);
+   float* wet = gWorkBuffer;
 
-   mRollingInputBuffer.WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
+   Mult(input, inputPreampSq, bufferSize);
 
-   //copy rolling input buffer into working buffer and window it
-   mRollingInputBuffer.ReadChunk(mFFTData.mTimeDomain, fftWindowSize, 0, 0);
-   Mult(mFFTData.mTimeDomain, mWindower, fftWindowSize);
-   Mult(mFFTData.mTimeDomain, inputPreampSq, fftWindowSize);
+   const float* inputs[] = { input };
+   mSTFT.Process(inputs, wet, bufferSize);
 
-   mFFT.Forward(mFFTData.mTimeDomain,
-                mFFTData.mRealValues,
-                mFFTData.mImaginaryValues);
+   for (int i = 0; i < bufferSize; ++i)
+      input[i] = input[i] * (1 - mDryWet) + wet[i] * kOutputLevel * volSq * mDryWet;
+
+   Add(target->GetBuffer()->GetChannel(0), input, bufferSize);
+
+   GetVizBuffer()->WriteChunk(input, bufferSize, 0);
+
+   GetBuffer()->Reset();
+}
 
-   for (int i = 0; i < fftFreqDomainSize; ++i)
+//runs once a hop, possibly on the stft's helper thread
+void FreqDomainBoilerplate::ProcessSpectralFrame(FFTData* const* frames, int numInputs)
+{
+   FFTData* frame = frames[0];
+   for (int i = 0; i < frame->mFreqDomainSize; ++i)
    {
-      float real = mFFTData.mRealValues[i];
-      float imag = mFFTData.mImaginaryValues[i];
+      float real = frame->mRealValues[i];
+      float imag = frame->mImaginaryValues[i];
 
       //cartesian to polar
       float amp = 2. * sqrtf(real * real + imag * imag);
@@ -105,31 +115,9 @@ void FreqDomainBoilerplate::Process(double time)
       real = amp * cos(phase);
       imag = amp * sin(phase);
 
-      mFFTData.mRealValues[i] = real;
-      mFFTData.mImaginaryValues[i] = imag;
+      frame->mRealValues[i] = real;
+      frame->mImaginaryValues[i] = imag;
    }
-
-   mFFT.Inverse(mFFTData.mRealValues,
-                mFFTData.mImaginaryValues,
-                mFFTData.mTimeDomain);
-
-   for (int i = 0; i < bufferSize; ++i)
-      mRollingOutputBuffer.Write(0, 0);
-
-   //copy rolling input buffer into working buffer and window it
-   for (int i = 0; i < fftWindowSize; ++i)
-      mRollingOutputBuffer.Accum(fftWindowSize - i - 1, mFFTData.mTimeDomain[i] * mWindower[i] * .0001f, 0);
-
-   Mult(GetBuffer()->GetChannel(0), (1 - mDryWet) * inputPreampSq, GetBuffer()->BufferSize());
-
-   for (int i = 0; i < bufferSize; ++i)
-      GetBuffer()->GetChannel(0)[i] += mRollingOutputBuffer.GetSample(fftWindowSize - i - 1, 0) * volSq * mDryWet;
-
-   Add(target->GetBuffer()->GetChannel(0), GetBuffer()->GetChannel(0), bufferSize);
-
-   GetVizBuffer()->WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
-
-   GetBuffer()->Reset();
 }
 
 void FreqDomainBoilerplate::DrawModule()
@@ -146,8 +134,19 @@ void FreqDomainBoilerplate::DrawModule()
    mValue2Slider->Draw();
    mValue3Slider->Draw();
    mPhaseOffsetSlider->Draw();
+   mWindowSizeSelector->Draw();
+   mOverlapSelector->Draw();
+   mHelperThreadCheckbox->Draw();
+}
+
+void FreqDomainBoilerplate::DropdownUpdated(DropdownList* list, int oldVal, double time)
+{
+   if (list == mWindowSizeSelector || list == mOverlapSelector)
+      mSTFT.SetUp(mWindowSize, mOverlap);
 }
 
 void FreqDomainBoilerplate::CheckboxUpdated(Checkbox* checkbox, double time)
 {
+   if (checkbox == mHelperThreadCheckbox)
+      mSTFT.SetUseHelperThread(mUseHelperThread);
 }
@@ -30,13 +30,13 @@
 #include "IAudioProcessor.h"
 #include "IDrawableModule.h"
 #include "Checkbox.h"
-#include "FFT.h"
-#include "RollingBuffer.h"
+#include "STFT.h"
 #include "Slider.h"
+#include "DropdownList.h"
 #include "GateEffect.h"
 #include "BiquadFilterEffect.h"
 
-class FreqDomainBoilerplate : public IAudioProcessor, public IDrawableModule, public IFloatSliderListener
+class FreqDomainBoilerplate : public IAudioProcessor, public IDrawableModule, public IFloatSliderListener, public IDropdownListener, public ISpectralFrameProcessor
 {
 public:
    FreqDomainBoilerplate();
@@ -60,6 +60,11 @@ public:
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
    //IFloatSliderListener
    void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override {}
+   //IDropdownListener
+   void DropdownUpdated(DropdownList* list, int oldVal, double time) override;
+
+   //ISpectralFrameProcessor
+   void ProcessSpectralFrame(FFTData* const* frames, int numInputs) override;
 
    bool IsEnabled() const override { return mEnabled; }
 
@@ -69,17 +74,9 @@ private:
    void GetModuleDimensions(float& w, float& h) override
    {
       w = 235;
-      h = 170;
+      h = 175;
    }
 
-   FFTData mFFTData;
-
-   float* mWindower{ nullptr };
-
-   ::FFT mFFT;
-   RollingBuffer mRollingInputBuffer;
-   RollingBuffer mRollingOutputBuffer;
-
    float mInputPreamp{ 1 };
    float mValue1{ 1 };
    float mVolume{ 1 };
@@ -94,6 +91,14 @@ private:
    FloatSlider* mValue3Slider{ nullptr };
    float mPhaseOffset{ 0 };
    FloatSlider* mPhaseOffsetSlider{ nullptr };
+   int mWindowSize{ 1024 };
+   DropdownList* mWindowSizeSelector{ nullptr };
+   int mOverlap{ 4 };
+   DropdownList* mOverlapSelector{ nullptr };
+   bool mUseHelperThread{ false };
+   Checkbox* mHelperThreadCheckbox{ nullptr };
+
+   STFT mSTFT{ this, 1, mWindowSize, mOverlap }; //last, so it's gone before anything a helper thread frame might be using
 };
 
 
@@ -46,13 +46,20 @@ void GainStageEffect::ProcessAudio(double time, ChannelBuffer* buffer)
    if (!mEnabled)
       return;
 
-   float bufferSize = buffer->BufferSize();
+   int bufferSize = buffer->BufferSize();
 
-   for (int i = 0; i < bufferSize; ++i)
+   const float* gains = mGainSlider->ComputeBlock(); //nullptr if the gain is steady this buffer
+   for (int ch = 0; ch < buffer->NumActiveChannels(); ++ch)
    {
-      ComputeSliders(i);
-      for (int ch = 0; ch < buffer->NumActiveChannels(); ++ch)
-         buffer->GetChannel(ch)[i] *= mGain;
+      float* channel = buffer->GetChannel(ch);
+      if (gains != nullptr)
+      {
+         Mult(channel, gains, bufferSize);
+      }
+      else
+      {
+         Mult(channel, mGain, bufferSize);
+      }
    }
 }
 
@@ -36,6 +36,9 @@ public:
    virtual void ProcessAudio(double time, ChannelBuffer* buffer) = 0;
    void SetEnabled(bool enabled) override = 0;
    virtual float GetEffectAmount() { return 0; }
+   //how long the effect keeps making sound once its input goes silent. EffectChain stops calling ProcessAudio() after that
+   //and starts again as soon as there's input. -1 means it can't say, and it never sleeps
+   virtual float GetTailLengthMs() { return -1; }
    virtual std::string GetType() = 0;
    bool CanMinimize() override { return false; }
    bool IsSaveable() override { return false; }
@@ -37,3 +37,25 @@ void IAudioProcessor::SyncBuffers(int overrideNumOutputChannels)
 
    SyncOutputBuffer(numOutputChannels);
 }
+
+bool IAudioProcessor::SkipSilentBuffer(double time)
+{
+   float tailMs = GetTailLengthMs();
+   if (tailMs < 0)
+      return false;
+
+   if (!GetBuffer()->IsSilent())
+   {
+      mLastAudibleInputTime = time;
+      return false;
+   }
+
+   if (time - mLastAudibleInputTime <= tailMs)
+      return false;
+
+   //our tail has run out and nothing new came in, so all Process() would do is pass silence along
+   GetBuffer()->Reset();
+   for (int ch = 0; ch < GetVizBuffer()->NumChannels(); ++ch)
+      GetVizBuffer()->WriteChunk(gZeroBuffer, GetBuffer()->BufferSize(), ch);
+   return true;
+}
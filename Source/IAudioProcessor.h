@@ -39,4 +39,8 @@ public:
 
 protected:
    void SyncBuffers(int overrideNumOutputChannels = -1);
+   bool SkipSilentBuffer(double time) override;
+
+private:
+   double mLastAudibleInputTime{ 0 };
 };
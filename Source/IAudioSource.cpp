@@ -45,3 +45,11 @@ void IAudioSource::SyncOutputBuffer(int numChannels)
    }
    GetVizBuffer()->SetNumChannels(numChannels);
 }
+
+void IAudioSource::ProcessMeasured(double time)
+{
+   mCpuStats.BeginBuffer();
+   int64_t start = ModuleCpuStats::Now();
+   Process(time);
+   mCpuStats.RecordBuffer(ModuleCpuStats::Now() - start);
+}
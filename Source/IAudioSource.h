@@ -29,6 +29,7 @@
 #include "RollingBuffer.h"
 #include "SynthGlobals.h"
 #include "IPatchable.h"
+#include "ModuleCpuStats.h"
 
 class IAudioReceiver;
 
@@ -42,15 +43,31 @@ public:
    {}
    virtual ~IAudioSource() {}
    virtual void Process(double time) = 0;
+   void ProcessAndMeasure(double time) //what the audio graph calls, so every module gets timed when cpu stats are on
+   {
+      if (SkipSilentBuffer(time))
+         return;
+      if (ModuleCpuStats::IsEnabled())
+         ProcessMeasured(time);
+      else
+         Process(time);
+   }
    IAudioReceiver* GetTarget(int index = 0);
    virtual int GetNumTargets() { return 1; }
+   virtual bool CanProcessInParallel() { return false; } //true only if Process() writes to nothing besides our own state and our targets' buffers
    RollingBuffer* GetVizBuffer() { return &mVizBuffer; }
+   ModuleCpuStats& GetCpuStats() { return mCpuStats; }
+   virtual float GetTailLengthMs() { return -1; } //how long we keep making sound after our input goes silent, or -1 if we might never stop
 
 protected:
    void SyncOutputBuffer(int numChannels);
+   virtual bool SkipSilentBuffer(double time) { return false; } //true if this buffer needs no Process() call at all
 
 private:
+   void ProcessMeasured(double time);
+
    RollingBuffer mVizBuffer;
+   ModuleCpuStats mCpuStats;
 };
 
 #endif
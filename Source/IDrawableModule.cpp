@@ -324,6 +324,9 @@ void IDrawableModule::DrawFrame(float w, float h, bool drawModule, float& titleB
    {
       ofSetColor(color * (1 - GetBeaconAmount()) + ofColor::yellow * GetBeaconAmount(), gModuleDrawAlpha);
       DrawTextBold(GetTitleLabel(), 5 + enableToggleOffset, 10 - titleBarHeight, 16);
+
+      if (ModuleCpuStats::IsEnabled())
+         DrawCpuStatsOverlay(w, titleBarHeight);
    }
 
    bool groupSelected = !TheSynth->GetGroupSelectedModules().empty() && VectorContains(this, TheSynth->GetGroupSelectedModules());
@@ -353,6 +356,32 @@ void IDrawableModule::DrawFrame(float w, float h, bool drawModule, float& titleB
    }
 }
 
+void IDrawableModule::DrawCpuStatsOverlay(float width, float titleBarHeight)
+{
+   IAudioSource* source = dynamic_cast<IAudioSource*>(this);
+   if (source == nullptr)
+      return;
+
+   ModuleCpuStats::Summary summary = source->GetCpuStats().GetSummary();
+   if (summary.mNumBuffers == 0)
+      return;
+
+   //mean / p99 / max, as a percentage of the buffer deadline
+   std::string text = ofToString(summary.mMean, 1) + " / " + ofToString(summary.mP99, 1) + " / " + ofToString(summary.mMax, 1) + "%";
+   const float kTextSize = 11;
+   float textWidth = GetStringWidth(text, kTextSize);
+   float right = width - 12; //leave room for the save data panel triangle
+
+   ofPushStyle();
+   ofFill();
+   ofSetColor(0, 0, 0, 180);
+   ofRect(right - textWidth - 4, -titleBarHeight + 1, textWidth + 6, titleBarHeight - 2, 2);
+   float load = ofClamp(summary.mP99 / 50, 0, 1); //fully red once a single module eats half the deadline
+   ofSetColor(ofLerp(120, 255, load), ofLerp(255, 80, load), 120, gModuleDrawAlpha);
+   DrawTextRightJustify(text, right, 10 - titleBarHeight + 1, kTextSize);
+   ofPopStyle();
+}
+
 void IDrawableModule::Render()
 {
    if (!mShowing)
@@ -899,6 +928,12 @@ void IDrawableModule::ComputeSliders(int samplesIn)
    //mSliderMutex.unlock();
 }
 
+void IDrawableModule::ComputeSliderBlocks()
+{
+   for (int i = 0; i < mFloatSliders.size(); ++i)
+      mFloatSliders[i]->ComputeBlock();
+}
+
 PatchCableOld IDrawableModule::GetPatchCableOld(IClickable* target)
 {
    float wThis, hThis, xThis, yThis, wThat, hThat, xThat, yThat;
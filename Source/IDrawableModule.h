@@ -149,6 +149,7 @@ public:
    virtual bool HasSpecialDelete() const { return false; }
    virtual void DoSpecialDelete() {}
    void ComputeSliders(int samplesIn);
+   void ComputeSliderBlocks(); //runs every modulated slider for the whole buffer up front, so ComputeSliders(samplesIn) for the rest of the buffer reads back cached values
    void SetOwningContainer(ModuleContainer* container) { mOwningContainer = container; }
    ModuleContainer* GetOwningContainer() const { return mOwningContainer; }
    virtual ModuleContainer* GetContainer() { return nullptr; }
@@ -229,6 +230,7 @@ private:
    virtual void DrawModule() = 0;
    virtual void DrawModuleUnclipped() {}
    float GetMinimizedWidth();
+   void DrawCpuStatsOverlay(float width, float titleBarHeight);
    PatchCableOld GetPatchCableOld(IClickable* target);
    virtual void LoadLayout(const ofxJSONElement& moduleInfo) {}
    virtual void SaveLayout(ofxJSONElement& moduleInfo) {}
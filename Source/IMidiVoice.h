@@ -41,9 +41,13 @@ public:
    void SetModulators(ModulationParameters modulators) { mModulators = modulators; }
    virtual void Start(double time, float amount) = 0;
    virtual void Stop(double time) = 0;
-   virtual bool Process(double time, ChannelBuffer* out, int oversampling) = 0;
+   virtual bool Process(double time, ChannelBuffer* out, int oversampling) = 0; //when oversampling, out is already at the oversampled rate
    virtual bool IsDone(double time) = 0;
    virtual void SetVoiceParams(IVoiceParams* params) = 0;
+   virtual void SetMaxBufferSize(int bufferSize) {} //off the audio thread, whenever the biggest out Process() can be handed changes
+   //voices that can render several of their kind at once, a SIMD lane each, override this. voices[0] is this voice and the rest
+   //are the same type, playing with the same params. return false to have them processed one at a time instead
+   virtual bool ProcessBatch(IMidiVoice* const* voices, int numVoices, double time, ChannelBuffer* out, int oversampling) { return false; }
    void SetPan(float pan)
    {
       assert(pan >= -1 && pan <= 1);
@@ -127,6 +127,12 @@ void IModulator::Poll()
    }
 }
 
+void IModulator::FillBuffer(float* values, int numSamples)
+{
+   for (int i = 0; i < numSamples; ++i)
+      values[i] = Value(i);
+}
+
 float IModulator::GetRecentChange() const
 {
    return mLastPollValue - mSmoothedValue;
@@ -38,6 +38,7 @@ public:
    IModulator();
    virtual ~IModulator();
    virtual float Value(int samplesIn = 0) = 0;
+   virtual void FillBuffer(float* values, int numSamples); //Value() for samples [0, numSamples), override when it can be done in bulk
    virtual bool Active() const = 0;
    virtual bool CanAdjustRange() const { return true; }
    virtual bool InitializeWithZeroRange() const { return false; }
@@ -26,59 +26,57 @@
 */
 
 #include "INoteReceiver.h"
+#include "IPulseReceiver.h"
+#include "ModularSynth.h"
 #include "Profiler.h"
 
-NoteInputBuffer::NoteInputBuffer(INoteReceiver* receiver)
+NoteInputBuffer::NoteInputBuffer(INoteReceiver* receiver, IPulseReceiver* pulseReceiver /*= nullptr*/)
 : mReceiver(receiver)
+, mPulseReceiver(pulseReceiver)
 {
-   for (int i = 0; i < kBufferSize; ++i)
-      mBuffer[i].time = -1;
 }
 
 void NoteInputBuffer::Process(double time)
 {
    PROFILER(NoteInputBuffer);
 
-   //process note offs first
-   for (int i = 0; i < kBufferSize; ++i)
-   {
-      if (mBuffer[i].time != -1 && mBuffer[i].velocity == 0 &&
-          IsTimeWithinFrame(mBuffer[i].time))
-      {
-         NoteInputElement& element = mBuffer[i];
-         mReceiver->PlayNote(element.time, element.pitch, element.velocity, element.voiceIdx, element.modulation);
-         mBuffer[i].time = -1;
-      }
-   }
-
-   //now process note ons
-   for (int i = 0; i < kBufferSize; ++i)
-   {
-      if (mBuffer[i].time != -1 && mBuffer[i].velocity != 0 &&
-          IsTimeWithinFrame(mBuffer[i].time))
-      {
-         NoteInputElement& element = mBuffer[i];
-         mReceiver->PlayNote(element.time, element.pitch, element.velocity, element.voiceIdx, element.modulation);
-         mBuffer[i].time = -1;
-      }
-   }
+   //everything that lands in this frame, in time order
+   mEvents.ConsumeUntil(NextBufferTime(false), [this](const BlockEvent& event)
+                        {
+                           if (event.type == BlockEvent::Type::kPulse)
+                              mPulseReceiver->OnPulse(event.time, event.velocity, event.flags);
+                           else
+                              mReceiver->PlayNote(event.time, event.pitch, event.velocity, event.voiceIdx, event.modulation);
+                        });
 }
 
 void NoteInputBuffer::QueueNote(double time, int pitch, float velocity, int voiceIdx, ModulationParameters modulation)
 {
-   for (int i = 0; i < kBufferSize; ++i)
-   {
-      if (mBuffer[i].time == -1)
-      {
-         mBuffer[i].time = time;
-         NoteInputElement& element = mBuffer[i];
-         element.pitch = pitch;
-         element.velocity = velocity;
-         element.voiceIdx = voiceIdx;
-         element.modulation = modulation;
-         break;
-      }
-   }
+   BlockEvent event;
+   event.time = time;
+   event.pitch = pitch;
+   event.velocity = velocity;
+   event.voiceIdx = voiceIdx;
+   event.modulation = modulation;
+   Queue(event);
+}
+
+void NoteInputBuffer::QueuePulse(double time, float velocity, int flags)
+{
+   assert(mPulseReceiver != nullptr);
+
+   BlockEvent event;
+   event.type = BlockEvent::Type::kPulse;
+   event.time = time;
+   event.velocity = velocity;
+   event.flags = flags;
+   Queue(event);
+}
+
+void NoteInputBuffer::Queue(const BlockEvent& event)
+{
+   if (!mEvents.Insert(event))
+      TheSynth->LogEvent("note input buffer is full, dropping events", kLogEventType_Error);
 }
 
 //static
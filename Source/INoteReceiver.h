@@ -28,12 +28,15 @@
 
 #include "OpenFrameworksPort.h"
 #include "ModulationChain.h"
+#include "BlockEventList.h"
 
 namespace juce
 {
    class MidiMessage;
 }
 
+class IPulseReceiver;
+
 class INoteReceiver
 {
 public:
@@ -53,18 +56,22 @@ struct NoteInputElement
    ModulationParameters modulation;
 };
 
+//holds on to notes and pulses that arrive ahead of time (from event lookahead, or from the ui thread) until the buffer they land in
 class NoteInputBuffer
 {
 public:
-   NoteInputBuffer(INoteReceiver* receiver);
+   NoteInputBuffer(INoteReceiver* receiver, IPulseReceiver* pulseReceiver = nullptr);
    void Process(double time);
    void QueueNote(double time, int pitch, float velocity, int voiceIdx, ModulationParameters modulation);
+   void QueuePulse(double time, float velocity, int flags);
    static bool IsTimeWithinFrame(double time);
 
 private:
-   static const int kBufferSize = 50;
-   NoteInputElement mBuffer[kBufferSize];
+   void Queue(const BlockEvent& event);
+
+   BlockEventList mEvents;
    INoteReceiver* mReceiver{ nullptr };
+   IPulseReceiver* mPulseReceiver{ nullptr };
 };
 
 #endif
@@ -88,6 +88,13 @@ void NoteOutput::SendPressure(int pitch, int pressure)
 
 void NoteOutput::SendCC(int control, int value, int voiceIdx)
 {
+   if (!IsAudioThread())
+   {
+      //keep it in order with the notes we've queued from this thread
+      TheSynth->GetNoteOutputQueue()->QueueCC(this, control, value, voiceIdx);
+      return;
+   }
+
    for (auto noteReceiver : mNoteSource->GetPatchCableSource()->GetNoteReceivers())
       noteReceiver->SendCC(control, value, voiceIdx);
 }
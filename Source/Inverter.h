@@ -47,6 +47,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
 
    virtual void LoadLayout(const ofxJSONElement& moduleInfo) override;
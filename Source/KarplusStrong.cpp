@@ -102,6 +102,7 @@ void KarplusStrong::Process(double time)
 
    mNoteInputBuffer.Process(time);
 
+   ComputeSliderBlocks();
    ComputeSliders(0);
 
    int bufferSize = target->GetBuffer()->BufferSize();
@@ -67,21 +67,10 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out, int oversampli
    if (IsDone(time))
       return false;
 
-   int bufferSize = out->BufferSize();
+   int bufferSize = out->BufferSize(); //already at the oversampled rate
    int channels = out->NumActiveChannels();
-   double sampleIncrementMs = gInvSampleRateMs;
-   double sampleRate = gSampleRate;
-   ChannelBuffer* destBuffer = out;
-
-   if (oversampling != 1)
-   {
-      gMidiVoiceWorkChannelBuffer.SetNumActiveChannels(channels);
-      destBuffer = &gMidiVoiceWorkChannelBuffer;
-      gMidiVoiceWorkChannelBuffer.Clear();
-      bufferSize *= oversampling;
-      sampleIncrementMs /= oversampling;
-      sampleRate *= oversampling;
-   }
+   double sampleIncrementMs = gInvSampleRateMs / oversampling;
+   double sampleRate = gSampleRate * oversampling;
 
    float freq;
    float filterRate;
@@ -155,35 +144,17 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out, int oversampli
 
       if (channels == 1)
       {
-         destBuffer->GetChannel(0)[pos] += outputSample;
+         out->GetChannel(0)[pos] += outputSample;
       }
       else
       {
-         destBuffer->GetChannel(0)[pos] += outputSample * GetLeftPanGain(GetPan());
-         destBuffer->GetChannel(1)[pos] += outputSample * GetRightPanGain(GetPan());
+         out->GetChannel(0)[pos] += outputSample * GetLeftPanGain(GetPan());
+         out->GetChannel(1)[pos] += outputSample * GetRightPanGain(GetPan());
       }
 
       time += sampleIncrementMs;
    }
 
-   if (oversampling != 1)
-   {
-      //assume power-of-two
-      while (oversampling > 1)
-      {
-         for (int i = 0; i < bufferSize; ++i)
-         {
-            for (int ch = 0; ch < channels; ++ch)
-               destBuffer->GetChannel(ch)[i] = (destBuffer->GetChannel(ch)[i * 2] + destBuffer->GetChannel(ch)[i * 2 + 1]) / 2;
-         }
-         oversampling /= 2;
-         bufferSize /= 2;
-      }
-
-      for (int ch = 0; ch < channels; ++ch)
-         Add(out->GetChannel(ch), destBuffer->GetChannel(ch), bufferSize);
-   }
-
    return true;
 }
 
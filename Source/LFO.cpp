@@ -27,6 +27,8 @@
 #include "OpenFrameworksPort.h"
 #include "Profiler.h"
 
+#include <algorithm>
+
 //static
 PerlinNoise LFO::sPerlinNoise;
 
@@ -128,6 +130,60 @@ float LFO::Value(int samplesIn /*= 0*/, float forcePhase /*= -1*/) const
    return sample;
 }
 
+void LFO::FillBuffer(float* values, int numSamples, int samplesIn /*= 0*/) const
+{
+   //PROFILER(LFO_FillBuffer);
+
+   if (mPeriod == kInterval_None) //no oscillator
+   {
+      std::fill(values, values + numSamples, mMode == kLFOMode_Envelope ? 1.0f : 0.0f);
+      return;
+   }
+
+   //the phase isn't what drives these, or the transport is going to jump somewhere in the middle of this block
+   bool perSample = mOsc.GetType() == kOsc_Random || mOsc.GetType() == kOsc_Drunk || mOsc.GetType() == kOsc_Perlin;
+   if (mPeriod != kInterval_Free && !TheTransport->IsPastQueuedMeasureJump(gTime + samplesIn * gInvSampleRateMs) && TheTransport->IsPastQueuedMeasureJump(gTime + (samplesIn + numSamples - 1) * gInvSampleRateMs))
+      perSample = true;
+
+   if (perSample)
+   {
+      for (int i = 0; i < numSamples; ++i)
+         values[i] = Value(samplesIn + i);
+      return;
+   }
+
+   //tempo and position only change between blocks, so within one the phase moves linearly
+   double phase;
+   double phaseInc;
+   double wrap;
+   if (mPeriod == kInterval_Free)
+   {
+      phase = CalculatePhase(samplesIn, false);
+      phaseInc = mFreeRate / gSampleRate;
+      wrap = 0; //mFreePhase wraps in OnTransportAdvanced(), not here
+   }
+   else
+   {
+      float period = TheTransport->GetDuration(mPeriod) / TheTransport->GetDuration(kInterval_1n);
+      phase = TheTransport->GetMeasureTime(gTime + samplesIn * gInvSampleRateMs) / period + (1 - mPhaseOffset) + 1;
+      phase -= int(phase) / 2 * 2;
+      phaseInc = gInvSampleRateMs / TheTransport->MsPerBar() / period;
+      wrap = 2;
+   }
+
+   for (int i = 0; i < numSamples; ++i)
+   {
+      float sample = mOsc.Value(TransformPhase(phase) * FTWO_PI);
+      if (mMode == kLFOMode_Envelope) //rescale to 0 1
+         sample = sample * .5f + .5f;
+      values[i] = sample;
+
+      phase += phaseInc;
+      if (wrap != 0 && phase >= wrap)
+         phase -= wrap;
+   }
+}
+
 void LFO::SetPeriod(NoteInterval interval)
 {
    if (interval == kInterval_Free)
@@ -45,6 +45,7 @@ public:
    LFO();
    ~LFO();
    float Value(int samplesIn = 0, float forcePhase = -1) const;
+   void FillBuffer(float* values, int numSamples, int samplesIn = 0) const; //same as calling Value() for each sample, but only syncs to the transport once
    void SetOffset(float offset) { mPhaseOffset = offset; }
    void SetPeriod(NoteInterval interval);
    void SetType(OscillatorType type);
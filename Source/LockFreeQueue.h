@@ -11,6 +11,8 @@
 #ifndef LOCKFREEQUEUE_H_INCLUDED
 #define LOCKFREEQUEUE_H_INCLUDED
 
+#include <atomic>
+
 /**
  * A simple single producer & consumer lock free queue, based on Herb Sutter's code:
  * http://www.drdobbs.com/parallel/writing-lock-free-code-a-corrected-queue/
@@ -26,8 +28,8 @@ public:
    {
       first = new Node(T()); // Dummy seperator.
 
-      last.set(first);
-      divider.set(first);
+      last.store(first);
+      divider.store(first);
    }
 
    ~LockFreeQueue()
@@ -45,11 +47,11 @@ public:
      */
    void produce(const T& t)
    {
-      last.get()->next = new Node(t);
+      last.load()->next = new Node(t);
 
-      last.set(last.get()->next);
+      last.store(last.load()->next);
 
-      while (first != divider.get())
+      while (first != divider.load())
       { // trim unused nodes
          Node* tmp = first;
          first = first->next;
@@ -62,12 +64,12 @@ public:
      */
    bool consume(T& result)
    {
-      Node* div = divider.get();
+      Node* div = divider.load();
 
-      if (div != last.get())
+      if (div != last.load())
       { // if queue is nonempty
          result = div->next->value; // copy requested value
-         divider.set(div->next); // publish that we took it
+         divider.store(div->next); // publish that we took it
          return true;
       }
 
@@ -86,7 +88,7 @@ private:
    };
 
    Node* first{ nullptr };
-   Atomic<Node*> divider, last;
+   std::atomic<Node*> divider, last;
 };
 
 
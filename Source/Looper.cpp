@@ -35,6 +35,7 @@
 #include "Rewriter.h"
 #include "FillSaveDropdown.h"
 #include "LooperGranulator.h"
+#include "Resampler.h"
 
 float Looper::mBeatwheelPosRight = 0;
 float Looper::mBeatwheelDepthRight = 0;
@@ -580,11 +581,8 @@ void Looper::ResampleForSpeed(float speed)
    {
       float* oldBuffer = new float[oldLoopLength];
       BufferCopy(oldBuffer, mBuffer->GetChannel(ch), oldLoopLength);
-      for (int i = 0; i < mLoopLength; ++i)
-      {
-         float offset = i * speed;
-         mBuffer->GetChannel(ch)[i] = GetInterpolatedSample(offset, oldBuffer, oldLoopLength);
-      }
+      float* dest = mBuffer->GetChannel(ch);
+      Resampler::Read(&oldBuffer, 1, oldLoopLength, 0, speed, &dest, 1, mLoopLength, Resampler::Quality::Sinc32);
       delete[] oldBuffer;
    }
 
@@ -1013,11 +1011,11 @@ void Looper::SampleDropped(int x, int y, Sample* sample)
 
    float lengthRatio = float(numSamples) / mLoopLength;
    mBuffer->SetNumActiveChannels(sample->NumChannels());
-   for (int i = 0; i < mLoopLength; ++i)
+   for (int ch = 0; ch < sample->NumChannels(); ++ch)
    {
-      float offset = i * lengthRatio;
-      for (int ch = 0; ch < sample->NumChannels(); ++ch)
-         mBuffer->GetChannel(ch)[i] = GetInterpolatedSample(offset, sample->Data()->GetChannel(ch), numSamples);
+      const float* source = sample->Data()->GetChannel(ch);
+      float* dest = mBuffer->GetChannel(ch);
+      Resampler::Read(&source, 1, numSamples, 0, lengthRatio, &dest, 1, mLoopLength, Resampler::Quality::Sinc32);
    }
 }
 
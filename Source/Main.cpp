@@ -11,6 +11,7 @@
 #include "juce_gui_basics/juce_gui_basics.h"
 #include <memory>
 #include "VSTScanner.h"
+#include "OfflineRenderer.h"
 
 #include "VersionInfo.h"
 
@@ -47,8 +48,6 @@ public:
          return;
       }
 
-      mainWindow = std::make_unique<MainWindow>("bespoke synth");
-
       juce::PropertiesFile::Options options;
       options.applicationName = "Bespoke Synth";
       options.filenameSuffix = "settings";
@@ -56,6 +55,16 @@ public:
 
       appProperties = std::make_unique<juce::ApplicationProperties>();
       appProperties->setStorageParameters(options);
+
+      if (OfflineRenderer::IsRequested(getCommandLineParameterArray()))
+      {
+         OfflineRenderer renderer;
+         setApplicationReturnValue(renderer.Run(getCommandLineParameterArray()));
+         quit();
+         return;
+      }
+
+      mainWindow = std::make_unique<MainWindow>("bespoke synth");
    }
 
    void shutdown() override
@@ -80,7 +89,7 @@ public:
       // the other instance's command-line arguments were.
 
       // This is also called when opening the app with a file.
-      if (commandLine.isNotEmpty() && commandLine.endsWith(".bsk"))
+      if (commandLine.isNotEmpty() && commandLine.endsWith(".bsk") && mainWindow != nullptr)
          SetStartupSaveStateFile(commandLine, mainWindow->getContentComponent());
    }
 
@@ -216,7 +216,15 @@ public:
       if (UserPrefs.devicetype.Get() != kAutoDevice)
          mGlobalManagers.mDeviceManager.setCurrentAudioDeviceType(UserPrefs.devicetype.Get(), true);
 
-      SetGlobalSampleRateAndBufferSize(UserPrefs.samplerate.Get(), UserPrefs.buffersize.Get());
+      //the engine can run in smaller or bigger blocks than the device, see ModularSynth::AudioOut()
+      int deviceBufferSize = UserPrefs.buffersize.Get();
+      int internalBufferSize = UserPrefs.internal_buffersize.Get() > 0 ? UserPrefs.internal_buffersize.Get() : deviceBufferSize;
+      if (internalBufferSize * UserPrefs.oversampling.Get() > kWorkBufferSize)
+      {
+         mSynth.SetFatalError("internal_buffersize of " + ofToString(internalBufferSize) + " is too large, fix this in userprefs.json");
+         internalBufferSize = deviceBufferSize;
+      }
+      SetGlobalSampleRateAndBufferSize(UserPrefs.samplerate.Get(), internalBufferSize);
 
       mSynth.Setup(&mGlobalManagers.mDeviceManager, &mGlobalManagers.mAudioFormatManager, this, &openGLContext);
 
@@ -227,7 +235,7 @@ public:
 
       AudioDeviceManager::AudioDeviceSetup preferredSetupOptions;
       preferredSetupOptions.sampleRate = gSampleRate / UserPrefs.oversampling.Get();
-      preferredSetupOptions.bufferSize = gBufferSize / UserPrefs.oversampling.Get();
+      preferredSetupOptions.bufferSize = deviceBufferSize;
       if (outputDevice != kAutoDevice && outputDevice != kNoneDevice)
          preferredSetupOptions.outputDeviceName = outputDevice;
       if (inputDevice != kAutoDevice && inputDevice != kNoneDevice)
@@ -268,9 +276,9 @@ public:
             mSynth.SetFatalError("error setting input device to '" + inputDevice + "', fix this in userprefs.json (use \"auto\" for default device, or \"none\" for no device)" +
                                  "\n\n\nvalid devices:\n" + GetAudioDevices());
          }
-         else if (loadedSetup.bufferSize != gBufferSize / UserPrefs.oversampling.Get())
+         else if (loadedSetup.bufferSize != deviceBufferSize)
          {
-            mSynth.SetFatalError("error setting buffer size to " + ofToString(gBufferSize / UserPrefs.oversampling.Get()) + " on device '" + loadedSetup.outputDeviceName.toStdString() + "', fix this in userprefs.json" +
+            mSynth.SetFatalError("error setting buffer size to " + ofToString(deviceBufferSize) + " on device '" + loadedSetup.outputDeviceName.toStdString() + "', fix this in userprefs.json" +
                                  "\n\n(a valid buffer size might be: " + ofToString(loadedSetup.bufferSize) + ")");
          }
          else if (loadedSetup.sampleRate != gSampleRate / UserPrefs.oversampling.Get())
@@ -298,7 +306,7 @@ public:
                outputMask >>= 1;
             }
 
-            mSynth.InitIOBuffers(numInputChannels, numOutputChannels);
+            mSynth.InitIOBuffers(numInputChannels, numOutputChannels, loadedSetup.bufferSize);
 
             mGlobalManagers.mDeviceManager.addAudioCallback(this);
          }
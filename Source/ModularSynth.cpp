@@ -14,11 +14,13 @@
 #include "ChaosEngine.h"
 #include "ModuleSaveDataPanel.h"
 #include "Profiler.h"
+#include "ModuleCpuStats.h"
 #include "Sample.h"
 #include "FloatSliderLFOControl.h"
 //#include <CoreServices/CoreServices.h>
 #include "fenv.h"
 #include <stdlib.h>
+#include <numeric>
 #include "GridController.h"
 #include "PerformanceTimer.h"
 #include "FileStream.h"
@@ -97,6 +99,7 @@ ModularSynth::~ModularSynth()
 {
    DeleteAllModules();
 
+   mRecordBufferWriter.WaitUntilDone(); //it might still be reading from the record buffer
    delete mGlobalRecordBuffer;
    mAudioPluginFormatManager.reset();
    mKnownPluginList.reset();
@@ -235,6 +238,8 @@ void ModularSynth::Setup(juce::AudioDeviceManager* globalAudioDeviceManager, juc
 
    mIOBufferSize = gBufferSize;
 
+   mAudioGraphExecutor.SetNumThreads(UserPrefs.audio_threads.Get());
+
    mGlobalRecordBuffer = new RollingBuffer(UserPrefs.record_buffer_length_minutes.Get() * 60 * gSampleRate);
    mGlobalRecordBuffer->SetNumChannels(2);
 
@@ -291,12 +296,35 @@ void ModularSynth::LoadResources(void* nanoVG, void* fontBoundsNanoVG)
       mFatalError = "couldn't load font from " + gFont.GetFontPath() + "\nmaybe bespoke can't find your resources directory?";
 }
 
-void ModularSynth::InitIOBuffers(int inputChannelCount, int outputChannelCount)
+void ModularSynth::InitIOBuffers(int inputChannelCount, int outputChannelCount, int deviceBufferSize /*= -1*/)
 {
    for (int i = 0; i < inputChannelCount; ++i)
       mInputBuffers.push_back(new float[gBufferSize]);
    for (int i = 0; i < outputChannelCount; ++i)
       mOutputBuffers.push_back(new float[gBufferSize]);
+
+   if (deviceBufferSize > 0)
+      mIOBufferSize = deviceBufferSize * UserPrefs.oversampling.Get();
+   mUseIOFifos = mIOBufferSize != gBufferSize;
+   if (mUseIOFifos)
+   {
+      for (int i = 0; i < inputChannelCount; ++i)
+         mIOInputScratch.push_back(new float[mIOBufferSize]);
+      for (int i = 0; i < outputChannelCount; ++i)
+         mIOOutputScratch.push_back(new float[mIOBufferSize]);
+
+      //output runs behind by however far the device buffers can get ahead of our block boundaries.
+      //zero when the device buffer is a whole number of blocks, but a device buffer smaller than a block costs the difference
+      mIOFifoLatency = gBufferSize - std::gcd(mIOBufferSize, gBufferSize);
+      int fifoCapacity = 2 * (mIOBufferSize + gBufferSize);
+      mInputFifo.SetUp(inputChannelCount, fifoCapacity);
+      mOutputFifo.SetUp(outputChannelCount, fifoCapacity);
+      ResetIOFifos();
+   }
+
+   Oversampler::Quality oversamplingQuality = Oversampler::GetQualityForName(UserPrefs.oversampling_quality.Get());
+   mInputOversampler.Setup(UserPrefs.oversampling.Get(), inputChannelCount, oversamplingQuality);
+   mOutputOversampler.Setup(UserPrefs.oversampling.Get(), outputChannelCount, oversamplingQuality);
 }
 
 
@@ -321,6 +349,11 @@ std::string ModularSynth::GetUserPrefsPath()
 static int sFrameCount = 0;
 void ModularSynth::Poll()
 {
+   PROFILER(poll_total);
+
+   Profiler::PollTrace();
+   Sample::CollectAllGarbage();
+
    if (mFatalError == "")
    {
       if (!mInitialized && sFrameCount > 3) //let some frames render before blocking for a load
@@ -430,6 +463,16 @@ void ModularSynth::Poll()
       mArrangeDependenciesWhenLoadCompletes = false;
    }
 
+   if (mAudioGraphDirty && !mIsLoadingState)
+      PublishAudioGraph();
+   mAudioGraph.CollectGarbage();
+   TheTransport->CollectGarbage();
+
+   std::string writtenPath;
+   bool writeSucceeded;
+   if (mRecordBufferWriter.TakeFinished(writtenPath, writeSucceeded))
+      TheTitleBar->DisplayTemporaryMessage((writeSucceeded ? "wrote " : "failed to write ") + writtenPath);
+
    ++sFrameCount;
 }
 
@@ -497,6 +540,8 @@ void ModularSynth::PanTo(float x, float y)
 
 void ModularSynth::Draw(void* vg)
 {
+   PROFILER(draw_total);
+
    gNanoVG = (NVGcontext*)vg;
 
    ofNoFill();
@@ -958,9 +1003,8 @@ void ModularSynth::DrawConsole()
 
 void ModularSynth::Exit()
 {
-   mAudioThreadMutex.Lock("exiting");
-   mAudioPaused = true;
-   mAudioThreadMutex.Unlock();
+   SuspendAudioProcessing();
+   mAudioGraphExecutor.SetNumThreads(1);
    mModuleContainer.Exit();
    DeleteAllModules();
    ofExit();
@@ -1876,8 +1920,6 @@ void ModularSynth::OnModuleDeleted(IDrawableModule* module)
 
    mDeletedModules.push_back(module);
 
-   mAudioThreadMutex.Lock("delete");
-
    std::list<PatchCable*> cablesToRemove;
    for (auto* cable : mPatchCables)
    {
@@ -1887,7 +1929,12 @@ void ModularSynth::OnModuleDeleted(IDrawableModule* module)
    for (auto* cable : cablesToRemove)
       RemoveFromVector(cable, mPatchCables);
 
-   RemoveFromVector(dynamic_cast<IAudioSource*>(module), mSources);
+   IAudioSource* source = dynamic_cast<IAudioSource*>(module);
+   if (source != nullptr)
+   {
+      RemoveFromVector(source, mSources);
+      PublishAudioGraph();
+   }
    RemoveFromVector(module, mLissajousDrawers);
    TheTransport->RemoveAudioPoller(dynamic_cast<IAudioPoller*>(module));
    //delete module; TODO(Ryan) deleting is hard... need to clear out everything with a reference to this, or switch to smart pointers
@@ -1896,8 +1943,6 @@ void ModularSynth::OnModuleDeleted(IDrawableModule* module)
       TheChaosEngine = nullptr;
    if (module == TheLFOController)
       TheLFOController = nullptr;
-
-   mAudioThreadMutex.Unlock();
 }
 
 void ModularSynth::MouseReleased(int intX, int intY, int button, const juce::MouseInputSource& source)
@@ -1978,6 +2023,8 @@ void ModularSynth::AudioOut(float* const* output, int bufferSize, int nChannels)
 {
    PROFILER(audioOut_total);
 
+   const long long traceStartTime = Profiler::IsTracing() ? Profiler::GetTraceTime() : 0;
+
    sAudioThreadId = std::this_thread::get_id();
 
    static bool sFirst = true;
@@ -1987,84 +2034,120 @@ void ModularSynth::AudioOut(float* const* output, int bufferSize, int nChannels)
       sFirst = false;
    }
 
-   if (mAudioPaused)
+   AudioThreadEpoch::BeginBuffer();
+
+   if (mAudioPaused || mAudioSuspendCount > 0)
    {
       for (int ch = 0; ch < nChannels; ++ch)
       {
          for (int i = 0; i < bufferSize; ++i)
             output[ch][i] = 0;
       }
+      if (mUseIOFifos)
+         ResetIOFifos();
+      AudioThreadEpoch::EndBuffer();
       return;
    }
 
    ScopedMutex mutex(&mAudioThreadMutex, "audioOut()");
 
    /////////// AUDIO PROCESSING STARTS HERE /////////////
-   mNoteOutputQueue->Process();
+   mNoteOutputQueue.load()->Process();
+
+   const AudioGraph* graph = mAudioGraph.Get();
 
    int oversampling = UserPrefs.oversampling.Get();
+   int ioSamples = bufferSize * oversampling;
 
-   assert(bufferSize * oversampling == mIOBufferSize);
    assert(nChannels == (int)mOutputBuffers.size());
-   assert(mIOBufferSize == gBufferSize); //need to be the same for now
-   //if we want these different, need to fix outBuffer here, and also fix audioIn()
-   //by now, many assumptions will have to be fixed to support mIOBufferSize and gBufferSize diverging
-   for (int ioOffset = 0; ioOffset < mIOBufferSize; ioOffset += gBufferSize)
+   if (!mUseIOFifos)
    {
-      for (size_t i = 0; i < mOutputBuffers.size(); ++i)
-         Clear(mOutputBuffers[i], mIOBufferSize);
+      assert(ioSamples == gBufferSize);
+      ProcessAudioBlock(graph, nChannels);
 
-      double elapsed = gInvSampleRateMs * mIOBufferSize;
-      gTime += elapsed;
-      TheTransport->Advance(elapsed);
+      //put it into speakers
+      if (oversampling != 1)
+         mOutputOversampler.DownsampleInPlace(mOutputBuffers.data(), nChannels, bufferSize);
+      for (int ch = 0; ch < nChannels; ++ch)
+         BufferCopy(output[ch], mOutputBuffers[ch], bufferSize);
+   }
+   else
+   {
+      assert(ioSamples <= mIOBufferSize);
+      //run as many blocks as it takes to fill this device buffer
+      while (mOutputFifo.GetNumReady() < ioSamples)
+      {
+         mInputFifo.Read(mInputBuffers.data(), (int)mInputBuffers.size(), gBufferSize);
+         ProcessAudioBlock(graph, nChannels);
+         mOutputFifo.Write(mOutputBuffers.data(), nChannels, gBufferSize);
+      }
 
-      //process all audio
-      for (int i = 0; i < mSources.size(); ++i)
-         mSources[i]->Process(gTime);
+      //put it into speakers
+      mOutputFifo.Read(mIOOutputScratch.data(), nChannels, ioSamples);
+      if (oversampling != 1)
+         mOutputOversampler.DownsampleInPlace(mIOOutputScratch.data(), nChannels, bufferSize);
+      for (int ch = 0; ch < nChannels; ++ch)
+         BufferCopy(output[ch], mIOOutputScratch[ch], bufferSize);
+   }
 
-      if (gTime - mLastClapboardTime < 100)
+   /////////// AUDIO PROCESSING ENDS HERE /////////////
+
+   Profiler::PrintCounters();
+
+   if (traceStartTime != 0)
+   {
+      long long elapsed = Profiler::GetTraceTime() - traceStartTime;
+      if (elapsed > ioSamples * 1000000000.0 / gSampleRate)
+         Profiler::TraceMarker("xrun", elapsed);
+   }
+
+   AudioThreadEpoch::EndBuffer();
+}
+
+void ModularSynth::ProcessAudioBlock(const AudioGraph* graph, int nChannels)
+{
+   for (size_t i = 0; i < mOutputBuffers.size(); ++i)
+      Clear(mOutputBuffers[i], gBufferSize);
+
+   double elapsed = gInvSampleRateMs * gBufferSize;
+   gTime += elapsed;
+   TheTransport->Advance(elapsed);
+
+   //process all audio
+   if (graph != nullptr)
+   {
+      if (graph->mParallelPlan != nullptr)
       {
-         for (int ch = 0; ch < nChannels; ++ch)
-         {
-            for (int i = 0; i < bufferSize; ++i)
-            {
-               float sample = sin(GetPhaseInc(440) * i) * (1 - ((gTime - mLastClapboardTime) / 100));
-               output[ch][i] = sample;
-            }
-         }
+         mAudioGraphExecutor.Process(graph->mParallelPlan.get(), gTime);
       }
+      else
+      {
+         for (auto* source : graph->mSources)
+            source->ProcessAndMeasure(gTime);
+      }
+   }
 
-      //put it into speakers
+   if (gTime - mLastClapboardTime < 100)
+   {
       for (int ch = 0; ch < nChannels; ++ch)
       {
-         if (oversampling == 1)
+         for (int i = 0; i < gBufferSize; ++i)
          {
-            BufferCopy(output[ch], mOutputBuffers[ch], gBufferSize);
-            if (ch < 2)
-               mGlobalRecordBuffer->WriteChunk(output[ch], bufferSize, ch);
-         }
-         else
-         {
-            for (int sampleIndex = 0; sampleIndex < gBufferSize / oversampling; ++sampleIndex)
-            {
-               output[ch][sampleIndex] = 0;
-               for (int subsampleIndex = 0; subsampleIndex < oversampling; ++subsampleIndex)
-               {
-                  float sample = mOutputBuffers[ch][sampleIndex * oversampling + subsampleIndex];
-                  output[ch][sampleIndex] += sample / oversampling;
-                  if (ch < 2)
-                     mGlobalRecordBuffer->Write(sample, ch);
-               }
-            }
+            float sample = sin(GetPhaseInc(440) * i) * (1 - ((gTime - mLastClapboardTime) / 100));
+            mOutputBuffers[ch][i] = sample;
          }
       }
    }
 
-   /////////// AUDIO PROCESSING ENDS HERE /////////////
-   mRecordingLength += bufferSize * oversampling;
-   mRecordingLength = MIN(mRecordingLength, mGlobalRecordBuffer->Size());
+   //the record buffer runs at the processing rate
+   mRecordBufferWriter.Record(mGlobalRecordBuffer, mRecordingLength, mOutputBuffers.data(), MIN(nChannels, 2), gBufferSize);
+}
 
-   Profiler::PrintCounters();
+void ModularSynth::ResetIOFifos()
+{
+   mInputFifo.Clear();
+   mOutputFifo.Clear();
+   mOutputFifo.WriteSilence(mIOFifoLatency);
 }
 
 void ModularSynth::AudioIn(const float* const* input, int bufferSize, int nChannels)
@@ -2076,23 +2159,58 @@ void ModularSynth::AudioIn(const float* const* input, int bufferSize, int nChann
 
    int oversampling = UserPrefs.oversampling.Get();
 
-   assert(bufferSize * oversampling == mIOBufferSize);
    assert(nChannels == (int)mInputBuffers.size());
 
-   for (int i = 0; i < nChannels; ++i)
+   if (mUseIOFifos)
    {
+      assert(bufferSize * oversampling <= mIOBufferSize);
       if (oversampling == 1)
       {
-         BufferCopy(mInputBuffers[i], input[i], bufferSize);
+         mInputFifo.Write(input, nChannels, bufferSize);
       }
       else
       {
-         for (int sampleIndex = 0; sampleIndex < bufferSize * oversampling; ++sampleIndex)
-         {
-            mInputBuffers[i][sampleIndex] = input[i][sampleIndex / oversampling];
-         }
+         mInputOversampler.Upsample(input, mIOInputScratch.data(), nChannels, bufferSize);
+         mInputFifo.Write(mIOInputScratch.data(), nChannels, bufferSize * oversampling);
       }
+      return;
    }
+
+   assert(bufferSize * oversampling == mIOBufferSize);
+
+   if (oversampling == 1)
+   {
+      for (int i = 0; i < nChannels; ++i)
+         BufferCopy(mInputBuffers[i], input[i], bufferSize);
+   }
+   else
+   {
+      mInputOversampler.Upsample(input, mInputBuffers.data(), nChannels, bufferSize);
+   }
+}
+
+void ModularSynth::SuspendAudioProcessing()
+{
+   ++mAudioSuspendCount;
+   //the audio thread might have started its current buffer before it saw the suspend, let it finish
+   if (!IsAudioThread())
+      AudioThreadEpoch::WaitUntilMovedPast(AudioThreadEpoch::GetCompletedBuffers());
+}
+
+void ModularSynth::ResumeAudioProcessing()
+{
+   assert(mAudioSuspendCount > 0);
+   --mAudioSuspendCount;
+}
+
+void ModularSynth::PublishAudioGraph()
+{
+   auto graph = std::make_unique<AudioGraph>();
+   graph->mSources = mSources;
+   if (mAudioGraphExecutor.IsEnabled())
+      graph->mParallelPlan = AudioGraphExecutor::BuildPlan(mSources);
+   mAudioGraph.Publish(std::move(graph));
+   mAudioGraphDirty = false;
 }
 
 float* ModularSynth::GetInputBuffer(int channel)
@@ -2235,6 +2353,8 @@ void ModularSynth::ArrangeAudioSourceDependencies()
    /*ofLog() << "new ordering:";
    for (int i=0; i<mSources.size(); ++i)
       ofLog() << dynamic_cast<IDrawableModule*>(mSources[i])->Name();*/
+
+   PublishAudioGraph();
 }
 
 void ModularSynth::FindCircularDependencies()
@@ -2317,14 +2437,21 @@ void ModularSynth::ResetLayout()
    mModuleContainer.Clear();
    mUILayerModuleContainer.Clear();
 
+   //cut the audio thread off from everything that's about to be deleted, and let it finish the buffer it might be in
+   mSources.clear();
+   PublishAudioGraph();
+   TheTransport->ClearListenersAndPollers();
+   NoteOutputQueue* oldNoteOutputQueue = mNoteOutputQueue.exchange(new NoteOutputQueue());
+   if (!IsAudioThread())
+      AudioThreadEpoch::WaitUntilMovedPast(AudioThreadEpoch::GetCompletedBuffers());
+   delete oldNoteOutputQueue;
+
    for (int i = 0; i < mDeletedModules.size(); ++i)
       delete mDeletedModules[i];
 
    mDeletedModules.clear();
-   mSources.clear();
    mLissajousDrawers.clear();
    mMoveModule = nullptr;
-   TheTransport->ClearListenersAndPollers();
    TheScale->ClearListeners();
    LFOPool::Shutdown();
    IKeyboardFocusListener::ClearActiveKeyboardFocus(!K(notifyListeners));
@@ -2351,7 +2478,6 @@ void ModularSynth::ResetLayout()
    delete TheSaveDataPanel;
    delete mQuickSpawn;
    delete mUserPrefsEditor;
-   delete mNoteOutputQueue;
 
    TitleBar* titleBar = new TitleBar();
    titleBar->SetPosition(0, 0);
@@ -2406,8 +2532,6 @@ void ModularSynth::ResetLayout()
    GetDrawOffset().set(0, 0);
 
    SetUIScale(UserPrefs.ui_scale.Get());
-
-   mNoteOutputQueue = new NoteOutputQueue();
 }
 
 bool ModularSynth::LoadLayoutFromFile(std::string jsonFile, bool makeDefaultLayout /*= true*/)
@@ -2489,7 +2613,7 @@ void ModularSynth::LoadLayout(ofxJSONElement json)
 
    //ofLoadURLAsync("http://bespoke.com/telemetry/"+jsonFile);
 
-   ScopedMutex mutex(&mAudioThreadMutex, "LoadLayout()");
+   ScopedAudioSuspend audioSuspend;
    std::lock_guard<std::recursive_mutex> renderLock(mRenderLock);
 
    ResetLayout();
@@ -2586,7 +2710,10 @@ void ModularSynth::OnModuleAdded(IDrawableModule* module)
 {
    IAudioSource* source = dynamic_cast<IAudioSource*>(module);
    if (source)
+   {
       mSources.push_back(source);
+      mAudioGraphDirty = true;
+   }
 }
 
 void ModularSynth::AddDynamicModule(IDrawableModule* module)
@@ -2828,13 +2955,11 @@ void ModularSynth::SaveState(std::string file, bool autosave)
       TheTitleBar->DisplayTemporaryMessage("saved " + filename);
    }
 
-   mAudioThreadMutex.Lock("SaveState()");
-
-   //write to a temp file first, so we don't corrupt data if we crash mid-save
-   std::string tmpFilePath = ofToDataPath("tmp");
-
+   //serialize into memory with the audio thread held off, so nothing changes under us, and only then touch the disk
+   juce::MemoryBlock saveData;
    {
-      FileStreamOut out(tmpFilePath);
+      ScopedMutex mutex(&mAudioThreadMutex, "SaveState()");
+      FileStreamOut out(saveData);
 
       mZoomer.WriteCurrentLocation(-1);
       out << GetLayout().getRawString(true);
@@ -2842,11 +2967,12 @@ void ModularSynth::SaveState(std::string file, bool autosave)
       mUILayerModuleContainer.SaveState(out);
    }
 
+   //write to a temp file first, so we don't corrupt data if we crash mid-save
+   std::string tmpFilePath = ofToDataPath("tmp");
    juce::File writtenFile(tmpFilePath);
+   writtenFile.replaceWithData(saveData.getData(), saveData.getSize());
    juce::File targetFile(file);
    writtenFile.copyFileTo(targetFile);
-
-   mAudioThreadMutex.Unlock();
 }
 
 void ModularSynth::SetStartupSaveStateFile(std::string bskPath)
@@ -2856,6 +2982,8 @@ void ModularSynth::SetStartupSaveStateFile(std::string bskPath)
 
 void ModularSynth::LoadState(std::string file)
 {
+   PROFILER(loadState);
+
    ofLog() << "LoadState() " << file;
 
    if (!juce::File(file).existsAsFile())
@@ -2875,12 +3003,10 @@ void ModularSynth::LoadState(std::string file)
       return;
    }
 
-   mAudioThreadMutex.Lock("LoadState()");
+   SuspendAudioProcessing();
    LockRender(true);
-   mAudioPaused = true;
    mIsLoadingState = true;
    LockRender(false);
-   mAudioThreadMutex.Unlock();
 
    //TODO(Ryan) here's a little hack to allow older BSK files that were saved in 32-bit to load.
    //I guess this could bite me if someone ever has a very massive json. the number corresponds to a long-standing sanity check in FileStreamIn::operator>>(std::string &var), so this shouldn't break any current behavior.
@@ -2911,12 +3037,10 @@ void ModularSynth::LoadState(std::string file)
    std::string filename = File(mCurrentSaveStatePath).getFileName().toStdString();
    mMainComponent->getTopLevelComponent()->setName("bespoke synth - " + filename);
 
-   mAudioThreadMutex.Lock("LoadState()");
    LockRender(true);
-   mAudioPaused = false;
    mIsLoadingState = false;
    LockRender(false);
-   mAudioThreadMutex.Unlock();
+   ResumeAudioProcessing();
 }
 
 IAudioReceiver* ModularSynth::FindAudioReceiver(std::string name, bool fail)
@@ -2986,10 +3110,8 @@ void ModularSynth::OnConsoleInput(std::string command /* = "" */)
       }
       else if (tokens[0] == "clearall")
       {
-         mAudioThreadMutex.Lock("clearall");
          std::lock_guard<std::recursive_mutex> renderLock(mRenderLock);
          ResetLayout();
-         mAudioThreadMutex.Unlock();
       }
       else if (tokens[0] == "load")
       {
@@ -3014,6 +3136,30 @@ void ModularSynth::OnConsoleInput(std::string command /* = "" */)
       {
          Profiler::ToggleProfiler();
       }
+      else if (tokens[0] == "trace")
+      {
+         double seconds = tokens.size() > 1 ? ofToFloat(tokens[1]) : 5;
+         std::string error;
+         if (Profiler::StartTrace(seconds, error))
+            LogEvent("capturing a " + ofToString(seconds) + " second trace", kLogEventType_Verbose);
+         else
+            LogEvent(error, kLogEventType_Error);
+      }
+      else if (tokens[0] == "cpuoverlay")
+      {
+         ModuleCpuStats::ToggleEnabled();
+      }
+      else if (tokens[0] == "cpucsv")
+      {
+         if (!ModuleCpuStats::IsEnabled())
+            LogEvent("cpu stats aren't being collected, turn them on with \"cpuoverlay\"", kLogEventType_Warning);
+         std::string path = tokens.size() > 1 ? ofToDataPath(tokens[1]) : ofToDataPath(ofGetTimestampString("cpu_%Y-%m-%d_%H-%M-%S.csv"));
+         std::string error;
+         if (ModuleCpuStats::WriteCsv(path, error))
+            LogEvent("wrote " + path, kLogEventType_Verbose);
+         else
+            LogEvent(error, kLogEventType_Error);
+      }
       else if (tokens[0] == "clear")
       {
          mErrors.clear();
@@ -3188,7 +3334,6 @@ IDrawableModule* ModularSynth::SpawnModuleOnTheFly(ModuleFactory::Spawnable spaw
 
    try
    {
-      ScopedMutex mutex(&mAudioThreadMutex, "CreateModule");
       module = CreateModule(dummy);
       if (module != nullptr)
       {
@@ -3263,7 +3408,11 @@ void ModularSynth::ReconnectMidiDevices()
 
 void ModularSynth::SaveOutput()
 {
-   ScopedMutex mutex(&mAudioThreadMutex, "SaveOutput()");
+   if (mRecordBufferWriter.IsWriting())
+   {
+      TheTitleBar->DisplayTemporaryMessage("still writing the last recording");
+      return;
+   }
 
    std::string save_prefix = "recording_";
    if (!mCurrentSaveStatePath.empty())
@@ -3273,41 +3422,21 @@ void ModularSynth::SaveOutput()
       save_prefix = filename + "_";
    }
 
-   std::string filename = ofGetTimestampString(UserPrefs.recordings_path.Get() + save_prefix + "%Y-%m-%d_%H-%M.wav");
+   RecordingStream::Format format = RecordingStream::Format::Wav;
+   if (UserPrefs.record_buffer_format.GetIndex() == (int)RecordingStream::Format::Flac)
+      format = RecordingStream::Format::Flac;
+   std::string filename = ofGetTimestampString(UserPrefs.recordings_path.Get() + save_prefix + "%Y-%m-%d_%H-%M" + RecordingStream::GetExtension(format));
    //string filenamePos = ofGetTimestampString("recordings/pos_%Y-%m-%d_%H-%M.wav");
 
-   assert(mRecordingLength <= mGlobalRecordBuffer->Size());
+   const int kBitDepths[] = { 16, 24, 32 }; //in the order of the record_buffer_bit_depth labels
+   int bitDepthIndex = UserPrefs.record_buffer_bit_depth.GetIndex();
+   int bitDepth = (bitDepthIndex >= 0 && bitDepthIndex < 3) ? kBitDepths[bitDepthIndex] : 16;
 
-   int channels = 2;
-   auto wavFormat = std::make_unique<juce::WavAudioFormat>();
-   juce::File outputFile(ofToDataPath(filename));
-   outputFile.create();
-   auto outputTo = outputFile.createOutputStream();
-   assert(outputTo != nullptr);
-   bool b1{ false };
-   auto writer = std::unique_ptr<juce::AudioFormatWriter>(wavFormat->createWriterFor(outputTo.release(), gSampleRate, channels, 16, b1, 0));
+   std::string path = RecordBufferWriter::GetUnusedPath(ofToDataPath(filename)); //before the lock, since it checks the disk
 
-   long long samplesRemaining = mRecordingLength;
-   const int chunkSize = 256;
-   float leftChannel[chunkSize];
-   float rightChannel[chunkSize];
-   float* chunk[2]{ leftChannel, rightChannel };
-   while (samplesRemaining > 0)
-   {
-      int numSamples = MIN(chunkSize, samplesRemaining);
-      for (int i = 0; i < numSamples; ++i)
-      {
-         chunk[0][i] = mGlobalRecordBuffer->GetSample(samplesRemaining - 1, 0);
-         chunk[1][i] = mGlobalRecordBuffer->GetSample(samplesRemaining - 1, 1);
-         --samplesRemaining;
-      }
-      writer->writeFromFloatArrays(chunk, channels, numSamples);
-   }
-
-   mGlobalRecordBuffer->ClearBuffer();
-   mRecordingLength = 0;
-
-   TheTitleBar->DisplayTemporaryMessage("wrote " + filename);
+   //only long enough to note down what to write, the encoding happens on the writer's thread. Poll() says when it's done
+   ScopedMutex mutex(&mAudioThreadMutex, "SaveOutput()");
+   mRecordBufferWriter.Start(mGlobalRecordBuffer, mRecordingLength, path, format, bitDepth, gSampleRate);
 }
 
 const String& ModularSynth::GetTextFromClipboard() const
@@ -15,6 +15,11 @@
 #include "EffectFactory.h"
 #include "ModuleContainer.h"
 #include "Minimap.h"
+#include "AudioGraphExecutor.h"
+#include "SnapshotPublisher.h"
+#include "Oversampler.h"
+#include "AudioFifo.h"
+#include "RecordBufferWriter.h"
 #include <thread>
 
 #ifdef BESPOKE_LINUX
@@ -80,7 +85,7 @@ public:
 
    void Setup(juce::AudioDeviceManager* globalAudioDeviceManager, juce::AudioFormatManager* globalAudioFormatManager, juce::Component* mainComponent, juce::OpenGLContext* openGLContext);
    void LoadResources(void* nanoVG, void* fontBoundsNanoVG);
-   void InitIOBuffers(int inputChannelCount, int outputChannelCount);
+   void InitIOBuffers(int inputChannelCount, int outputChannelCount, int deviceBufferSize = -1);
    void Poll();
    void Draw(void* vg);
    void PostRender();
@@ -109,11 +114,15 @@ public:
    void ClearConsoleInput();
 
    bool IsReady();
+   bool IsInitialized() const { return mInitialized; }
    bool IsAudioPaused() const { return mAudioPaused; }
    void SetAudioPaused(bool paused) { mAudioPaused = paused; }
+   void SuspendAudioProcessing();
+   void ResumeAudioProcessing();
 
    void AddMidiDevice(MidiDevice* device);
    void ArrangeAudioSourceDependencies();
+   void OnNonAudioCableChanged() { mAudioGraphDirty = true; } //the parallel plan follows note, pulse and modulation cables too, republished on the next Poll()
    IDrawableModule* SpawnModuleOnTheFly(ModuleFactory::Spawnable spawnable, float x, float y, bool addToContainer = true, std::string name = "");
 
    void SetMoveModule(IDrawableModule* module, float offsetX, float offsetY, bool canStickToCursor);
@@ -238,7 +247,7 @@ public:
    std::recursive_mutex& GetRenderLock() { return mRenderLock; }
    NamedMutex* GetAudioMutex() { return &mAudioThreadMutex; }
    static std::thread::id GetAudioThreadID() { return sAudioThreadId; }
-   NoteOutputQueue* GetNoteOutputQueue() { return mNoteOutputQueue; }
+   NoteOutputQueue* GetNoteOutputQueue() { return mNoteOutputQueue.load(); }
 
    IDrawableModule* CreateModule(const ofxJSONElement& moduleInfo);
    void SetUpModule(IDrawableModule* module, const ofxJSONElement& moduleInfo);
@@ -261,6 +270,7 @@ public:
    ofxJSONElement GetLayout();
    void SaveLayoutAsPopup();
    void SaveOutput();
+   float GetSaveOutputProgress() const { return mRecordBufferWriter.IsWriting() ? mRecordBufferWriter.GetProgress() : -1; } //-1 when not saving
    void SaveState(std::string file, bool autosave);
    void LoadState(std::string file);
    void SetStartupSaveStateFile(std::string bskPath);
@@ -278,6 +288,7 @@ public:
    void CopyTextToClipboard(const juce::String& text);
 
    void SetFatalError(std::string error);
+   const std::string& GetFatalError() const { return mFatalError; }
 
    static bool sShouldAutosave;
    static float sBackgroundLissajousR;
@@ -308,10 +319,23 @@ private:
    void ClearCircularDependencyMarkers();
 
    void ReadClipboardTextFromSystem();
+   void PublishAudioGraph();
 
    int mIOBufferSize{ 0 };
 
    std::vector<IAudioSource*> mSources;
+
+   //what the audio thread actually processes. edits change mSources and then publish a new copy of it
+   struct AudioGraph
+   {
+      std::vector<IAudioSource*> mSources;
+      std::unique_ptr<AudioGraphExecutor::Plan> mParallelPlan;
+   };
+   SnapshotPublisher<AudioGraph> mAudioGraph;
+   void ProcessAudioBlock(const AudioGraph* graph, int nChannels);
+   void ResetIOFifos();
+   std::atomic<bool> mAudioGraphDirty{ false }; //cables can get repatched from the audio thread
+   AudioGraphExecutor mAudioGraphExecutor;
    std::vector<IDrawableModule*> mLissajousDrawers;
    std::vector<IDrawableModule*> mDeletedModules;
    bool mHasCircularDependency{ false };
@@ -351,6 +375,7 @@ private:
 
    RollingBuffer* mGlobalRecordBuffer{ nullptr };
    long long mRecordingLength{ 0 };
+   RecordBufferWriter mRecordBufferWriter;
 
    struct LogEventItem
    {
@@ -368,9 +393,10 @@ private:
 
    NamedMutex mAudioThreadMutex;
    static std::thread::id sAudioThreadId;
-   NoteOutputQueue* mNoteOutputQueue{ nullptr };
+   std::atomic<NoteOutputQueue*> mNoteOutputQueue{ nullptr };
 
-   bool mAudioPaused{ false };
+   std::atomic<bool> mAudioPaused{ false };
+   std::atomic<int> mAudioSuspendCount{ 0 };
    bool mIsLoadingState{ false };
    bool mArrangeDependenciesWhenLoadCompletes{ false };
 
@@ -441,6 +467,15 @@ private:
 
    std::vector<float*> mInputBuffers;
    std::vector<float*> mOutputBuffers;
+   //when the device buffer size differs from gBufferSize, audio goes through these so we can process in gBufferSize blocks
+   bool mUseIOFifos{ false };
+   AudioFifo mInputFifo;
+   AudioFifo mOutputFifo;
+   int mIOFifoLatency{ 0 };
+   std::vector<float*> mIOInputScratch;
+   std::vector<float*> mIOOutputScratch;
+   Oversampler mInputOversampler;
+   Oversampler mOutputOversampler;
 
    std::unique_ptr<juce::AudioPluginFormatManager> mAudioPluginFormatManager;
    std::unique_ptr<juce::KnownPluginList> mKnownPluginList;
@@ -448,4 +483,12 @@ private:
 
 extern ModularSynth* TheSynth;
 
+//silences the audio thread for the lifetime of this object, so modules can be torn down or rebuilt safely
+class ScopedAudioSuspend
+{
+public:
+   ScopedAudioSuspend() { TheSynth->SuspendAudioProcessing(); }
+   ~ScopedAudioSuspend() { TheSynth->ResumeAudioProcessing(); }
+};
+
 #endif
@@ -54,7 +54,12 @@ float ModulationChain::GetIndividualValue(int samplesIn) const
    else
       value = 0;
    if (mLFOAmount != 0)
-      value += mLFO.Value(samplesIn) * mLFOAmount;
+   {
+      if (mLFOBufferTime == gTime && samplesIn >= 0 && samplesIn < gBufferSize)
+         value += mLFOBuffer[samplesIn] * mLFOAmount;
+      else
+         value += mLFO.Value(samplesIn) * mLFOAmount;
+   }
    if (mBuffer != nullptr && samplesIn >= 0 && samplesIn < gBufferSize)
       value += mBuffer[samplesIn];
    return value;
@@ -74,6 +79,7 @@ void ModulationChain::SetLFO(NoteInterval interval, float amount)
 {
    mLFO.SetPeriod(interval);
    mLFOAmount = amount;
+   mLFOBufferTime = -1; //the rest of this buffer has to come from the new period
 }
 
 void ModulationChain::AppendTo(ModulationChain* chain)
@@ -111,6 +117,16 @@ float ModulationChain::GetBufferValue(int sampleIdx)
    return 0;
 }
 
+void ModulationChain::FillLFOBuffer()
+{
+   if (mLFOAmount == 0)
+      return;
+   if (mLFOBuffer == nullptr)
+      mLFOBuffer = new float[gBufferSize];
+   mLFO.FillBuffer(mLFOBuffer, gBufferSize);
+   mLFOBufferTime = gTime;
+}
+
 Modulations::Modulations(bool isGlobalEffect)
 {
    mVoiceModulations.resize(kNumVoices);
@@ -149,3 +165,10 @@ ModulationChain* Modulations::GetPressure(int voiceIdx)
    else
       return &mVoiceModulations[voiceIdx].mPressure;
 }
+
+void Modulations::FillLFOBuffers()
+{
+   mGlobalModulation.FillLFOBuffers();
+   for (auto& collection : mVoiceModulations)
+      collection.FillLFOBuffers();
+}
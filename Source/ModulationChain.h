@@ -44,11 +44,14 @@ public:
    void CreateBuffer();
    void FillBuffer(float* buffer);
    float GetBufferValue(int sampleIdx);
+   void FillLFOBuffer(); //renders this buffer's lfo in one go, call from an audio poller before anything reads the chain
 
 private:
    Ramp mRamp;
    LFO mLFO;
    float mLFOAmount{ 0 };
+   float* mLFOBuffer{ nullptr };
+   double mLFOBufferTime{ -1 };
    float* mBuffer{ nullptr };
    ModulationChain* mPrev{ nullptr };
    ModulationChain* mSidechain{ nullptr };
@@ -82,6 +85,13 @@ struct ModulationCollection
    ModulationChain mPitchBend{ ModulationParameters::kDefaultPitchBend };
    ModulationChain mModWheel{ ModulationParameters::kDefaultModWheel };
    ModulationChain mPressure{ ModulationParameters::kDefaultPressure };
+
+   void FillLFOBuffers()
+   {
+      mPitchBend.FillLFOBuffer();
+      mModWheel.FillLFOBuffer();
+      mPressure.FillLFOBuffer();
+   }
 };
 
 class Modulations
@@ -91,6 +101,7 @@ public:
    ModulationChain* GetPitchBend(int voiceIdx);
    ModulationChain* GetModWheel(int voiceIdx);
    ModulationChain* GetPressure(int voiceIdx);
+   void FillLFOBuffers();
 
 private:
    ModulationCollection mGlobalModulation;
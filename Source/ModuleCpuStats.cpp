@@ -0,0 +1,137 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  ModuleCpuStats.cpp
+//  Bespoke
+//
+//
+
+#include "ModuleCpuStats.h"
+#include "IAudioSource.h"
+#include "IDrawableModule.h"
+#include "ModularSynth.h"
+#include "SynthGlobals.h"
+
+#include "juce_core/juce_core.h"
+
+#include <algorithm>
+
+std::atomic<bool> ModuleCpuStats::sEnabled{ false };
+
+//static
+void ModuleCpuStats::ToggleEnabled()
+{
+   bool enable = !sEnabled.load();
+   if (enable)
+   {
+      //start from a clean slate rather than showing whatever was measured the last time this was on
+      std::vector<IDrawableModule*> modules;
+      TheSynth->GetAllModules(modules);
+      for (auto* module : modules)
+      {
+         IAudioSource* source = dynamic_cast<IAudioSource*>(module);
+         if (source != nullptr)
+            source->GetCpuStats().Reset();
+      }
+   }
+   sEnabled.store(enable);
+}
+
+void ModuleCpuStats::BeginBuffer()
+{
+   if (mResetPending.load(std::memory_order_relaxed) && mResetPending.exchange(false, std::memory_order_acquire))
+   {
+      mWriteIndex = 0;
+      mNumRecorded.store(0, std::memory_order_relaxed);
+   }
+   mVoiceCost.store(0, std::memory_order_relaxed);
+}
+
+void ModuleCpuStats::RecordBuffer(int64_t nanoseconds)
+{
+   double deadline = gBufferSize * 1000000000.0 / gSampleRate;
+   mHistory[mWriteIndex].store(float(nanoseconds * 100 / deadline), std::memory_order_relaxed);
+   mVoiceHistory[mWriteIndex].store(float(mVoiceCost.load(std::memory_order_relaxed) * 100 / deadline), std::memory_order_relaxed);
+   mWriteIndex = (mWriteIndex + 1) % kHistorySize;
+   int numRecorded = mNumRecorded.load(std::memory_order_relaxed);
+   mNumRecorded.store(std::min(numRecorded + 1, kHistorySize), std::memory_order_release);
+}
+
+ModuleCpuStats::Summary ModuleCpuStats::GetSummary() const
+{
+   Summary summary;
+   summary.mNumBuffers = mNumRecorded.load(std::memory_order_acquire);
+   if (summary.mNumBuffers == 0)
+      return summary;
+
+   //the audio thread may be overwriting the oldest entries while we read, which is fine for a rolling display
+   float costs[kHistorySize];
+   float voiceTotal = 0;
+   for (int i = 0; i < summary.mNumBuffers; ++i)
+   {
+      costs[i] = mHistory[i].load(std::memory_order_relaxed);
+      summary.mMean += costs[i];
+      summary.mMax = std::max(summary.mMax, costs[i]);
+      voiceTotal += mVoiceHistory[i].load(std::memory_order_relaxed);
+   }
+   summary.mMean /= summary.mNumBuffers;
+   summary.mVoiceMean = voiceTotal / summary.mNumBuffers;
+
+   int p99Index = std::min(summary.mNumBuffers - 1, summary.mNumBuffers * 99 / 100);
+   std::nth_element(costs, costs + p99Index, costs + summary.mNumBuffers);
+   summary.mP99 = costs[p99Index];
+
+   return summary;
+}
+
+//static
+bool ModuleCpuStats::WriteCsv(const std::string& path, std::string& error)
+{
+   struct Row
+   {
+      std::string mPath;
+      Summary mSummary;
+   };
+   std::vector<Row> rows;
+
+   std::vector<IDrawableModule*> modules;
+   TheSynth->GetAllModules(modules);
+   for (auto* module : modules)
+   {
+      IAudioSource* source = dynamic_cast<IAudioSource*>(module);
+      if (source != nullptr)
+         rows.push_back({ module->Path(), source->GetCpuStats().GetSummary() });
+   }
+   std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b)
+             { return a.mSummary.mMean > b.mSummary.mMean; });
+
+   std::string output = "module,mean %,p99 %,max %,voices mean %,buffers\n";
+   for (const auto& row : rows)
+   {
+      const Summary& summary = row.mSummary;
+      output += "\"" + row.mPath + "\"," + ofToString(summary.mMean, 3) + "," + ofToString(summary.mP99, 3) + "," +
+                ofToString(summary.mMax, 3) + "," + ofToString(summary.mVoiceMean, 3) + "," + ofToString(summary.mNumBuffers) + "\n";
+   }
+
+   if (!juce::File(path).replaceWithText(output))
+   {
+      error = "couldn't write " + path;
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,91 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  ModuleCpuStats.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+//per-module audio thread cost, as a percentage of the time we have to fill each buffer.
+//only measured while enabled (the "cpuoverlay" console command), so the hidden case costs a single relaxed load per module.
+class ModuleCpuStats
+{
+public:
+   struct Summary
+   {
+      float mMean{ 0 };
+      float mP99{ 0 };
+      float mMax{ 0 };
+      float mVoiceMean{ 0 }; //the part of mMean spent in IMidiVoice::Process()
+      int mNumBuffers{ 0 };
+   };
+
+   static bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+   static void ToggleEnabled();
+   static int64_t Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+   static bool WriteCsv(const std::string& path, std::string& error);
+
+   //audio thread, by whichever thread is processing the module for this buffer.
+   //voice costs only count between BeginBuffer() and RecordBuffer(), so a buffer that wasn't measured can't leak into the next one
+   void BeginBuffer();
+   void AddVoiceCost(int64_t nanoseconds) { mVoiceCost.fetch_add(nanoseconds, std::memory_order_relaxed); }
+   void RecordBuffer(int64_t nanoseconds);
+
+   //ui thread
+   Summary GetSummary() const;
+   void Reset() { mResetPending.store(true, std::memory_order_release); } //done by the audio thread at the start of the next measured buffer
+
+   //times a block on the audio thread, and does nothing if stats is null
+   class ScopedVoiceTimer
+   {
+   public:
+      explicit ScopedVoiceTimer(ModuleCpuStats* stats)
+      : mStats(stats)
+      , mStart(stats != nullptr ? Now() : 0)
+      {}
+      ~ScopedVoiceTimer()
+      {
+         if (mStats != nullptr)
+            mStats->AddVoiceCost(Now() - mStart);
+      }
+
+   private:
+      ModuleCpuStats* mStats;
+      int64_t mStart;
+   };
+
+private:
+   static const int kHistorySize = 512; //about 3 seconds of buffers at 256 samples/44.1k
+
+   //written by the audio thread while the ui reads, so relaxed atomics, which cost the same as plain floats to load and store
+   std::atomic<float> mHistory[kHistorySize]{};
+   std::atomic<float> mVoiceHistory[kHistorySize]{};
+   int mWriteIndex{ 0 }; //audio thread only
+   std::atomic<int> mNumRecorded{ 0 }; //saturates at kHistorySize
+   std::atomic<int64_t> mVoiceCost{ 0 };
+   std::atomic<bool> mResetPending{ false };
+
+   static std::atomic<bool> sEnabled;
+};
@@ -31,8 +31,16 @@ ModwheelToVibrato::ModwheelToVibrato()
 {
 }
 
+void ModwheelToVibrato::Init()
+{
+   IDrawableModule::Init();
+
+   TheTransport->AddAudioPoller(this);
+}
+
 ModwheelToVibrato::~ModwheelToVibrato()
 {
+   TheTransport->RemoveAudioPoller(this);
 }
 
 void ModwheelToVibrato::CreateUIControls()
@@ -60,6 +68,11 @@ void ModwheelToVibrato::DrawModule()
    mIntervalSelector->Draw();
 }
 
+void ModwheelToVibrato::OnTransportAdvanced(float amount)
+{
+   mModulation.FillLFOBuffers();
+}
+
 void ModwheelToVibrato::PlayNote(double time, int pitch, int velocity, int voiceIdx, ModulationParameters modulation)
 {
    if (mEnabled)
@@ -28,9 +28,9 @@
 #include "Profiler.h"
 #include "SynthGlobals.h"
 #include "Transport.h"
-#include "Sample.h"
 #include "UIControlMacros.h"
 #include "PatchCableSource.h"
+#include "SnapshotPublisher.h"
 #include "UserPrefs.h"
 
 MultitrackRecorder::MultitrackRecorder()
@@ -46,11 +46,16 @@ void MultitrackRecorder::CreateUIControls()
    CHECKBOX(mRecordCheckbox, "record", &mRecord);
    UIBLOCK_SHIFTRIGHT();
    BUTTON(mClearButton, "clear");
+   UIBLOCK_SHIFTRIGHT();
+   DROPDOWN(mFormatSelector, "format", (int*)&mFormat, 45);
    UIBLOCK_NEWLINE();
    BUTTON(mAddTrackButton, "add track");
    UIBLOCK_SHIFTRIGHT();
    BUTTON(mBounceButton, "bounce");
    ENDUIBLOCK0();
+
+   mFormatSelector->AddLabel("wav", (int)RecordingStream::Format::Wav);
+   mFormatSelector->AddLabel("flac", (int)RecordingStream::Format::Flac);
 }
 
 MultitrackRecorder::~MultitrackRecorder()
@@ -64,9 +69,11 @@ void MultitrackRecorder::DrawModule()
 
    mAddTrackButton->SetShowing(!mRecord);
    mBounceButton->SetShowing(!mRecord);
+   mFormatSelector->SetShowing(mTakePrefix.empty()); //the take's files are already open
 
    mRecordCheckbox->Draw();
    mClearButton->Draw();
+   mFormatSelector->Draw();
    mAddTrackButton->Draw();
    mBounceButton->Draw();
 
@@ -86,9 +93,20 @@ void MultitrackRecorder::DrawModule()
    mModuleContainer.DrawModules();
 }
 
+void MultitrackRecorder::Poll()
+{
+   //files get opened and closed here rather than on whatever thread hit record, bounce or clear
+   if (mWantBounce.exchange(false))
+      Bounce();
+   if (mWantClear.exchange(false))
+      ClearTake();
+   for (auto* track : mTracks)
+      track->UpdateStream();
+}
+
 void MultitrackRecorder::AddTrack()
 {
-   int recordingLength = GetRecordingLength();
+   int64_t recordingLength = GetRecordingLength();
 
    ModuleFactory::Spawnable spawnable;
    spawnable.mLabel = "multitrackrecordertrack";
@@ -109,9 +127,9 @@ void MultitrackRecorder::RemoveTrack(MultitrackRecorderTrack* track)
    }
 }
 
-int MultitrackRecorder::GetRecordingLength()
+int64_t MultitrackRecorder::GetRecordingLength()
 {
-   int recordingLength = 0;
+   int64_t recordingLength = 0;
    for (auto* track : mTracks)
    {
       if (track->GetRecordingLength() > recordingLength)
@@ -121,14 +139,9 @@ int MultitrackRecorder::GetRecordingLength()
    return recordingLength;
 }
 
-void MultitrackRecorder::ButtonClicked(ClickButton* button, double time)
+std::string MultitrackRecorder::GetTrackPath(MultitrackRecorderTrack* track)
 {
-   if (button == mAddTrackButton)
-   {
-      AddTrack();
-   }
-
-   if (button == mBounceButton)
+   if (mTakePrefix.empty())
    {
       std::string save_prefix = "multitrack_";
       if (!TheSynth->GetLastSavePath().empty())
@@ -142,33 +155,54 @@ void MultitrackRecorder::ButtonClicked(ClickButton* button, double time)
       {
          save_prefix += "%Y-%m-%d_%H-%M_";
       }
-      std::string filenamePrefix = ofGetTimestampString(UserPrefs.recordings_path.Get() + save_prefix);
-
-      int numFiles = 0;
-      for (int i = 0; i < (int)mTracks.size(); ++i)
-      {
-         Sample* sample = mTracks[i]->BounceRecording();
+      mTakePrefix = ofGetTimestampString(UserPrefs.recordings_path.Get() + save_prefix);
+   }
 
-         if (sample)
-         {
-            std::string filename = filenamePrefix + ofToString(i + 1) + ".wav";
-            sample->Write(filename.c_str());
-            ++numFiles;
-         }
-      }
+   int index = (int)(std::find(mTracks.begin(), mTracks.end(), track) - mTracks.begin());
+   return ofToDataPath(mTakePrefix + ofToString(index + 1) + RecordingStream::GetExtension(mFormat));
+}
 
-      if (numFiles > 0)
-      {
-         mStatusString = "wrote " + ofToString(numFiles) + " files to " + filenamePrefix + "*.wav";
-         mStatusStringTime = gTime;
-      }
+void MultitrackRecorder::ButtonClicked(ClickButton* button, double time)
+{
+   if (button == mAddTrackButton)
+   {
+      AddTrack();
    }
 
+   if (button == mBounceButton)
+      mWantBounce = true;
+
    if (button == mClearButton)
+      mWantClear = true;
+}
+
+void MultitrackRecorder::Bounce()
+{
+   //the files are written as we go, so all that's left is to finish them off
+   int numFiles = 0;
+   for (auto* track : mTracks)
    {
-      for (auto* track : mTracks)
-         track->Clear();
+      if (!track->FinishRecording().empty())
+         ++numFiles;
    }
+
+   if (numFiles > 0)
+   {
+      mStatusString = "wrote " + ofToString(numFiles) + " files to " + mTakePrefix + "*" + RecordingStream::GetExtension(mFormat);
+      mStatusStringTime = gTime;
+   }
+   mTakePrefix.clear();
+}
+
+void MultitrackRecorder::ClearTake()
+{
+   for (auto* track : mTracks)
+      track->Clear();
+   mTakePrefix.clear();
+
+   //keep going in a fresh take
+   for (auto* track : mTracks)
+      track->SetRecording(mRecord);
 }
 
 void MultitrackRecorder::CheckboxUpdated(Checkbox* checkbox, double time)
@@ -265,12 +299,6 @@ void MultitrackRecorder::LoadState(FileStreamIn& in, int rev)
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
-namespace
-{
-   const int kRecordingChunkSize = 48000 * 5;
-   const int kMinRecordingChunks = 2;
-};
-
 MultitrackRecorderTrack::MultitrackRecorderTrack()
 : IAudioProcessor(gBufferSize)
 {
@@ -278,6 +306,7 @@ MultitrackRecorderTrack::MultitrackRecorderTrack()
 
 MultitrackRecorderTrack::~MultitrackRecorderTrack()
 {
+   CloseStream();
 }
 
 void MultitrackRecorderTrack::CreateUIControls()
@@ -293,29 +322,13 @@ void MultitrackRecorderTrack::CreateUIControls()
 
 void MultitrackRecorderTrack::Process(double time)
 {
-   int numChannels = GetBuffer()->NumActiveChannels();
-   for (size_t i = 0; i < mRecordChunks.size(); ++i)
-   {
-      if (mRecordChunks[i]->NumActiveChannels() > numChannels)
-         numChannels = mRecordChunks[i]->NumActiveChannels();
-   }
-
    ComputeSliders(0);
-   SyncBuffers(numChannels);
+   SyncBuffers();
 
-   if (mDoRecording)
+   if (mDoRecording.load(std::memory_order_acquire))
    {
-      for (size_t i = 0; i < mRecordChunks.size(); ++i)
-         mRecordChunks[i]->SetNumActiveChannels(numChannels);
-
-      for (int i = 0; i < GetBuffer()->BufferSize(); ++i)
-      {
-         int chunkIndex = mRecordingLength / kRecordingChunkSize;
-         int chunkPos = mRecordingLength % kRecordingChunkSize;
-         for (int ch = 0; ch < numChannels; ++ch)
-            mRecordChunks[chunkIndex]->GetChannel(ch)[chunkPos] = GetBuffer()->GetChannel(MIN(ch, GetBuffer()->NumActiveChannels() - 1))[i];
-         ++mRecordingLength;
-      }
+      mStream->Write(GetBuffer(), GetBuffer()->BufferSize());
+      mRecordingLength += GetBuffer()->BufferSize();
    }
 
    if (GetTarget())
@@ -331,18 +344,6 @@ void MultitrackRecorderTrack::Process(double time)
    GetBuffer()->Reset();
 }
 
-void MultitrackRecorderTrack::Poll()
-{
-   IDrawableModule::Poll();
-
-   int chunkIndex = mRecordingLength / kRecordingChunkSize;
-   if (chunkIndex >= (int)mRecordChunks.size() - 1)
-   {
-      mRecordChunks.push_back(new ChannelBuffer(kRecordingChunkSize));
-      mRecordChunks[mRecordChunks.size() - 1]->GetChannel(0); //set up buffer
-   }
-}
-
 void MultitrackRecorderTrack::DrawModule()
 {
    mDeleteButton->Draw();
@@ -365,21 +366,35 @@ void MultitrackRecorderTrack::DrawModule()
       ofRect(0, 0, sampleWidth, height - 6);
    }
 
-   ofPushMatrix();
-   int numChunks = mRecordingLength / kRecordingChunkSize + 1;
-   float chunkWidth = sampleWidth / numChunks;
-   for (int i = 0; i < numChunks; ++i)
+   if (mStream != nullptr)
    {
-      if (i < (int)mRecordChunks.size())
-         DrawAudioBuffer(chunkWidth, height - 6, mRecordChunks[i], 0, kRecordingChunkSize, -1);
-      ofTranslate(chunkWidth, 0);
+      //the whole take squeezed into the width, one line per pixel
+      std::lock_guard<std::mutex> lock(mStream->GetOverviewMutex());
+      const std::vector<float>& overview = mStream->GetOverview();
+      int numPoints = (int)overview.size();
+      float halfHeight = (height - 6) / 2;
+      ofSetColor(255, 255, 255, 180);
+      for (int x = 0; x < (int)sampleWidth; ++x)
+      {
+         int start = int(x * (int64_t)numPoints / (int)sampleWidth);
+         int end = std::min(std::max(start + 1, int((x + 1) * (int64_t)numPoints / (int)sampleWidth)), numPoints);
+         float peak = 0;
+         for (int i = start; i < end; ++i)
+            peak = std::max(peak, overview[i]);
+         if (peak > 0)
+            ofLine(x, halfHeight - peak * halfHeight, x, halfHeight + peak * halfHeight);
+      }
    }
-   ofPopMatrix();
 
    ofPopMatrix();
+
+   if (mStream != nullptr && mStream->HasFailed())
+      DrawTextNormal("couldn't write to " + mStream->GetPath(), 30, 15);
+   else if (mStream != nullptr && mStream->GetDroppedFrames() > 0)
+      DrawTextNormal("dropped " + ofToString(mStream->GetDroppedFrames()) + " samples, the disk isn't keeping up. they're silent in the file", 30, 15);
 }
 
-void MultitrackRecorderTrack::Setup(MultitrackRecorder* recorder, int minLength)
+void MultitrackRecorderTrack::Setup(MultitrackRecorder* recorder, int64_t minLength)
 {
    mRecorder = recorder;
    mRecordingLength = minLength;
@@ -387,64 +402,55 @@ void MultitrackRecorderTrack::Setup(MultitrackRecorder* recorder, int minLength)
 
 void MultitrackRecorderTrack::SetRecording(bool record)
 {
-   if (record)
-   {
-      if (mRecordingLength == 0)
-      {
-         mRecordingLength = 0;
+   mWantRecording = record;
+   if (!record)
+      mDoRecording.store(false, std::memory_order_release);
+}
 
-         for (size_t i = mRecordChunks.size(); i < kMinRecordingChunks; ++i)
-         {
-            mRecordChunks.push_back(new ChannelBuffer(kRecordingChunkSize));
-            mRecordChunks[i]->GetChannel(0); //set up buffer
-         }
+void MultitrackRecorderTrack::UpdateStream()
+{
+   if (!mWantRecording || mDoRecording)
+      return;
 
-         for (size_t i = 0; i < mRecordChunks.size(); ++i)
-            mRecordChunks[i]->Clear();
-      }
+   //tracks that join a take late start with silence, to line up with the rest
+   if (mStream == nullptr)
+      mStream = std::make_unique<RecordingStream>(mRecorder->GetTrackPath(this), mRecorder->GetFormat(), gSampleRate, mRecordingLength);
 
-      mDoRecording = true;
-   }
-   else
-   {
-      mDoRecording = false;
-   }
+   mDoRecording.store(true, std::memory_order_release);
+   if (!mWantRecording) //turned off again while we were opening the file
+      mDoRecording.store(false, std::memory_order_release);
 }
 
-Sample* MultitrackRecorderTrack::BounceRecording()
+std::string MultitrackRecorderTrack::FinishRecording()
 {
-   Sample* sample = nullptr;
-   if (mRecordingLength > 0)
-   {
-      sample = new Sample();
-      sample->Create(mRecordingLength);
-      ChannelBuffer* data = sample->Data();
-      int channelCount = mRecordChunks[0]->NumActiveChannels();
-      data->SetNumActiveChannels(channelCount);
-
-      int numChunks = mRecordingLength / kRecordingChunkSize + 1;
-      for (int i = 0; i < numChunks; ++i)
-      {
-         int samplesLeftToRecord = mRecordingLength - i * kRecordingChunkSize;
-         int samplesToCopy;
-         if (samplesLeftToRecord > kRecordingChunkSize)
-            samplesToCopy = kRecordingChunkSize;
-         else
-            samplesToCopy = samplesLeftToRecord;
-         for (int ch = 0; ch < channelCount; ++ch)
-            BufferCopy(data->GetChannel(ch) + i * kRecordingChunkSize, mRecordChunks[i]->GetChannel(ch), samplesToCopy);
-      }
-   }
-
-   return sample;
+   std::string path = CloseStream();
+   if (!juce::File(path).existsAsFile())
+      return "";
+   return path;
 }
 
 void MultitrackRecorderTrack::Clear()
 {
-   for (auto* recordChunk : mRecordChunks)
-      delete recordChunk;
-   mRecordChunks.clear();
+   std::string path = CloseStream();
+   if (!path.empty())
+      juce::File(path).deleteFile();
+}
+
+//stops recording and closes the file, once the audio thread is done with it. returns the file's path, if there was one
+std::string MultitrackRecorderTrack::CloseStream()
+{
+   mWantRecording = false;
+   mDoRecording = false;
+   std::string path;
+   if (mStream != nullptr)
+   {
+      if (!IsAudioThread())
+         AudioThreadEpoch::WaitUntilMovedPast(AudioThreadEpoch::GetCompletedBuffers());
+      path = mStream->GetPath();
+      mStream.reset();
+   }
    mRecordingLength = 0;
+   return path;
 }
 
 void MultitrackRecorderTrack::FloatSliderUpdated(FloatSlider* slider, float oldVal, double time)
@@ -33,10 +33,14 @@
 #include "Checkbox.h"
 #include "IAudioProcessor.h"
 #include "ModuleContainer.h"
+#include "DropdownList.h"
+#include "RecordingStream.h"
 
 class MultitrackRecorderTrack;
 
-class MultitrackRecorder : public IDrawableModule, public IButtonListener
+//each track records straight to its own file, so takes can run as long as the disk has room.
+//a take runs from the first time record is turned on until bounce, which closes the files
+class MultitrackRecorder : public IDrawableModule, public IButtonListener, public IDropdownListener
 {
 public:
    MultitrackRecorder();
@@ -47,14 +51,18 @@ public:
    static bool AcceptsPulses() { return false; }
 
    void CreateUIControls() override;
+   void Poll() override;
    ModuleContainer* GetContainer() override { return &mModuleContainer; }
    bool IsResizable() const override { return true; }
    void Resize(float width, float height) override { mWidth = ofClamp(width, 210, 9999); }
 
    void RemoveTrack(MultitrackRecorderTrack* track);
+   std::string GetTrackPath(MultitrackRecorderTrack* track); //starts a new take if there isn't one
+   RecordingStream::Format GetFormat() const { return mFormat; }
 
    void ButtonClicked(ClickButton* button, double time) override;
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
+   void DropdownUpdated(DropdownList* list, int oldVal, double time) override {}
 
    void SaveLayout(ofxJSONElement& moduleInfo) override;
    void LoadLayout(const ofxJSONElement& moduleInfo) override;
@@ -73,7 +81,9 @@ private:
    }
 
    void AddTrack();
-   int GetRecordingLength();
+   int64_t GetRecordingLength();
+   void Bounce();
+   void ClearTake();
 
    float mWidth{ 700 };
    float mHeight{ 142 };
@@ -85,8 +95,13 @@ private:
    bool mRecord{ false };
    ClickButton* mBounceButton{ nullptr };
    ClickButton* mClearButton{ nullptr };
+   std::atomic<bool> mWantBounce{ false }; //handled in Poll(), the buttons can get hit from the audio thread
+   std::atomic<bool> mWantClear{ false };
+   DropdownList* mFormatSelector{ nullptr };
+   RecordingStream::Format mFormat{ RecordingStream::Format::Wav };
 
    std::vector<MultitrackRecorderTrack*> mTracks;
+   std::string mTakePrefix; //empty between takes
    std::string mStatusString;
    double mStatusStringTime{ -9999 };
 };
@@ -104,14 +119,14 @@ public:
    void CreateUIControls() override;
    bool HasTitleBar() const override { return false; }
 
-   void Poll() override;
    void Process(double time) override;
 
-   void Setup(MultitrackRecorder* recorder, int minLength);
-   void SetRecording(bool record);
-   Sample* BounceRecording();
-   void Clear();
-   int GetRecordingLength() const { return mRecordingLength; }
+   void Setup(MultitrackRecorder* recorder, int64_t minLength);
+   void SetRecording(bool record); //any thread, the file gets opened by the next UpdateStream()
+   void UpdateStream(); //main thread
+   std::string FinishRecording(); //main thread. closes the file and returns its path, or an empty string if nothing was recorded
+   void Clear(); //main thread. throws away the file
+   int64_t GetRecordingLength() const { return mRecordingLength; }
 
    void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override;
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
@@ -125,10 +140,13 @@ private:
    void DrawModule() override;
    void GetModuleDimensions(float& width, float& height) override;
 
+   std::string CloseStream();
+
    MultitrackRecorder* mRecorder{ nullptr };
 
-   std::vector<ChannelBuffer*> mRecordChunks;
-   bool mDoRecording{ false };
-   int mRecordingLength{ 0 };
+   std::unique_ptr<RecordingStream> mStream; //only opened and closed on the main thread
+   std::atomic<bool> mWantRecording{ false };
+   std::atomic<bool> mDoRecording{ false }; //set after mStream, so the audio thread only sees it once mStream is ready
+   std::atomic<int64_t> mRecordingLength{ 0 };
    ClickButton* mDeleteButton{ nullptr };
 };
@@ -48,6 +48,17 @@ void NoteOutputQueue::QueueFlush(NoteOutput* target, double time)
    mQueue.enqueue(output);
 }
 
+void NoteOutputQueue::QueueCC(NoteOutput* target, int control, int value, int voiceIdx)
+{
+   PendingNoteOutput output;
+   output.target = target;
+   output.isCC = true;
+   output.pitch = control;
+   output.velocity = value;
+   output.voiceIdx = voiceIdx;
+   mQueue.enqueue(output);
+}
+
 void NoteOutputQueue::Process()
 {
    assert(IsAudioThread());
@@ -63,6 +74,10 @@ void NoteOutputQueue::Process()
       {
          output.target->Flush(output.time);
       }
+      else if (output.isCC)
+      {
+         output.target->SendCC(output.pitch, output.velocity, output.voiceIdx);
+      }
       else
       {
          //ofLog() << "playing queued note " << output.time << " " << output.pitch << " " << output.velocity << " " << gTime;
@@ -35,6 +35,7 @@ class NoteOutputQueue
 public:
    void QueuePlayNote(NoteOutput* target, double time, int pitch, int velocity, int voiceIdx, ModulationParameters modulation);
    void QueueFlush(NoteOutput* target, double time);
+   void QueueCC(NoteOutput* target, int control, int value, int voiceIdx);
    void Process();
 
 private:
@@ -42,9 +43,10 @@ private:
    {
       NoteOutput* target;
       bool isFlush{ false };
+      bool isCC{ false };
       double time{ 0 };
-      int pitch{ 0 };
-      int velocity{ 0 };
+      int pitch{ 0 }; //cc number for isCC
+      int velocity{ 0 }; //cc value for isCC
       int voiceIdx{ -1 };
       ModulationParameters modulation{};
    };
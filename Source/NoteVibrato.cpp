@@ -71,6 +71,7 @@ void NoteVibrato::DrawModule()
 void NoteVibrato::OnTransportAdvanced(float amount)
 {
    ComputeSliders(0);
+   mModulation.FillLFOBuffers();
 }
 
 void NoteVibrato::PlayNote(double time, int pitch, int velocity, int voiceIdx, ModulationParameters modulation)
@@ -0,0 +1,237 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  OfflineRenderer.cpp
+//  Bespoke
+//
+//
+
+#include "OfflineRenderer.h"
+#include "ModularSynth.h"
+#include "SynthGlobals.h"
+#include "UserPrefs.h"
+
+#include "juce_audio_devices/juce_audio_devices.h"
+#include "juce_audio_formats/juce_audio_formats.h"
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include <iostream>
+
+namespace
+{
+   const char* kRenderFlag = "--render";
+   const int kPollsPerSecond = 60; //matches the ui timer in MainComponent
+   const int kMaxPollsBeforeLoad = 100;
+
+   std::unique_ptr<juce::AudioFormatWriter> CreateWavWriter(const juce::File& file, double sampleRate, int numChannels, int bitDepth)
+   {
+      file.deleteFile();
+      auto outputTo = file.createOutputStream();
+      if (outputTo == nullptr)
+         return nullptr;
+
+      juce::WavAudioFormat wavFormat;
+      std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(outputTo.get(), sampleRate, numChannels, bitDepth, {}, 0));
+      if (writer != nullptr)
+         outputTo.release(); //the writer owns the stream now
+      return writer;
+   }
+}
+
+//static
+bool OfflineRenderer::IsRequested(const juce::StringArray& args)
+{
+   return args.contains(kRenderFlag);
+}
+
+//static
+void OfflineRenderer::PrintUsage()
+{
+   std::cout << "usage: BespokeSynth --render song.bsk [options]\n"
+             << "   --out path          wav file to write (default: next to the .bsk)\n"
+             << "   --length seconds    how much audio to render (default: 60)\n"
+             << "   --samplerate rate   (default: samplerate from userprefs)\n"
+             << "   --buffersize size   (default: buffersize from userprefs)\n"
+             << "   --channels count    output channels to render (default: 2)\n"
+             << "   --bitdepth bits     16, 24, or 32 (float) (default: 24)\n"
+             << "   --threads count     audio processing threads (default: audio_threads from userprefs)\n"
+             << "   --stems             write each pair of output channels to its own file" << std::endl;
+}
+
+bool OfflineRenderer::ParseArgs(const juce::StringArray& args)
+{
+   for (int i = 0; i < args.size(); ++i)
+   {
+      const juce::String& arg = args[i];
+      bool hasValue = i + 1 < args.size();
+      if (arg == kRenderFlag || arg.endsWith(".json")) //userprefs path is picked up by ModularSynth::GetUserPrefsPath()
+         continue;
+      else if (arg.endsWith(".bsk"))
+         mSaveStatePath = juce::File::getCurrentWorkingDirectory().getChildFile(arg).getFullPathName().toStdString();
+      else if (arg == "--out" && hasValue)
+         mOutputPath = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]).getFullPathName().toStdString();
+      else if (arg == "--length" && hasValue)
+         mLengthSeconds = args[++i].getDoubleValue();
+      else if (arg == "--samplerate" && hasValue)
+         mSampleRate = args[++i].getIntValue();
+      else if (arg == "--buffersize" && hasValue)
+         mBufferSize = args[++i].getIntValue();
+      else if (arg == "--channels" && hasValue)
+         mNumChannels = args[++i].getIntValue();
+      else if (arg == "--bitdepth" && hasValue)
+         mBitDepth = args[++i].getIntValue();
+      else if (arg == "--threads" && hasValue)
+         mNumThreads = args[++i].getIntValue();
+      else if (arg == "--stems")
+         mWriteStems = true;
+      else
+      {
+         std::cout << "unrecognized argument: " << arg << std::endl;
+         return false;
+      }
+   }
+
+   if (mSaveStatePath.empty())
+   {
+      std::cout << "no .bsk file specified" << std::endl;
+      return false;
+   }
+   if (mLengthSeconds <= 0 || mNumChannels <= 0 || (mBitDepth != 16 && mBitDepth != 24 && mBitDepth != 32))
+   {
+      std::cout << "invalid length, channel count, or bit depth" << std::endl;
+      return false;
+   }
+
+   if (mOutputPath.empty())
+      mOutputPath = juce::File(mSaveStatePath).withFileExtension("wav").getFullPathName().toStdString();
+
+   return true;
+}
+
+int OfflineRenderer::Run(const juce::StringArray& args)
+{
+   if (!ParseArgs(args))
+   {
+      PrintUsage();
+      return 1;
+   }
+
+   if (!juce::File(mSaveStatePath).existsAsFile())
+   {
+      std::cout << "couldn't find " << mSaveStatePath << std::endl;
+      return 1;
+   }
+
+   //this stands in for the main window, for code that wants to know the window size
+   juce::Component mainComponent;
+   juce::AudioDeviceManager deviceManager; //never initialised, so no device gets opened
+   juce::AudioFormatManager audioFormatManager;
+
+   auto synth = std::make_unique<ModularSynth>();
+   UserPrefs.Init();
+
+   int sampleRate = mSampleRate > 0 ? mSampleRate : UserPrefs.samplerate.Get();
+   int bufferSize = mBufferSize > 0 ? mBufferSize : UserPrefs.buffersize.Get();
+   if (bufferSize * UserPrefs.oversampling.Get() > kWorkBufferSize)
+   {
+      std::cout << "buffer size " << bufferSize << " is too large" << std::endl;
+      return 1;
+   }
+   if (mNumThreads > 0)
+      UserPrefs.audio_threads.Get() = mNumThreads;
+
+   mainComponent.setSize(UserPrefs.width.Get(), UserPrefs.height.Get());
+   SetGlobalSampleRateAndBufferSize(sampleRate, bufferSize);
+   synth->Setup(&deviceManager, &audioFormatManager, &mainComponent, nullptr);
+   synth->InitIOBuffers(0, mNumChannels);
+
+   //load the same way the gui does on startup, ModularSynth::Poll() picks up the startup file after a few frames
+   synth->SetStartupSaveStateFile(mSaveStatePath);
+   for (int i = 0; i < kMaxPollsBeforeLoad && !synth->IsInitialized() && synth->GetFatalError().empty(); ++i)
+      synth->Poll();
+   synth->Poll(); //let the audio graph get published
+   if (!synth->IsInitialized() || !synth->GetFatalError().empty())
+   {
+      std::cout << "couldn't load " << mSaveStatePath << ": " << synth->GetFatalError() << std::endl;
+      return 1;
+   }
+
+   std::vector<std::unique_ptr<juce::AudioFormatWriter> > writers;
+   std::vector<int> writerFirstChannels;
+   juce::File outputFile(mOutputPath);
+   for (int channel = 0; channel < mNumChannels; channel += mWriteStems ? 2 : mNumChannels)
+   {
+      int numWriterChannels = mWriteStems ? std::min(2, mNumChannels - channel) : mNumChannels;
+      juce::File file = outputFile;
+      if (mWriteStems)
+      {
+         juce::String channelLabel = numWriterChannels == 2 ? juce::String(channel + 1) + "-" + juce::String(channel + 2) : juce::String(channel + 1);
+         file = outputFile.getSiblingFile(outputFile.getFileNameWithoutExtension() + "_" + channelLabel + outputFile.getFileExtension());
+      }
+      auto writer = CreateWavWriter(file, sampleRate, numWriterChannels, mBitDepth);
+      if (writer == nullptr)
+      {
+         std::cout << "couldn't open " << file.getFullPathName() << " for writing" << std::endl;
+         return 1;
+      }
+      std::cout << "writing " << file.getFullPathName() << std::endl;
+      writers.push_back(std::move(writer));
+      writerFirstChannels.push_back(channel);
+   }
+
+   std::vector<std::vector<float> > outputBuffers(mNumChannels, std::vector<float>(bufferSize));
+   std::vector<float*> outputs;
+   for (auto& buffer : outputBuffers)
+      outputs.push_back(buffer.data());
+
+   const juce::int64 totalSamples = juce::int64(mLengthSeconds * sampleRate);
+   const int samplesPerPoll = sampleRate / kPollsPerSecond;
+   int samplesSincePoll = 0;
+   int lastReportedPercent = -1;
+   double startTime = juce::Time::getMillisecondCounterHiRes();
+
+   for (juce::int64 rendered = 0; rendered < totalSamples; rendered += bufferSize)
+   {
+      synth->AudioOut(outputs.data(), bufferSize, mNumChannels);
+
+      int numSamples = (int)std::min<juce::int64>(bufferSize, totalSamples - rendered);
+      for (size_t i = 0; i < writers.size(); ++i)
+         writers[i]->writeFromFloatArrays(outputs.data() + writerFirstChannels[i], writers[i]->getNumChannels(), numSamples);
+
+      samplesSincePoll += bufferSize;
+      if (samplesSincePoll >= samplesPerPoll)
+      {
+         synth->Poll();
+         samplesSincePoll -= samplesPerPoll;
+      }
+
+      int percent = int((rendered + numSamples) * 100 / totalSamples);
+      if (percent / 10 != lastReportedPercent / 10)
+      {
+         std::cout << percent << "%" << std::endl;
+         lastReportedPercent = percent;
+      }
+   }
+
+   writers.clear(); //flushes the files
+
+   double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000;
+   std::cout << "rendered " << mLengthSeconds << "s of audio in " << elapsedSeconds << "s (" << (elapsedSeconds > 0 ? mLengthSeconds / elapsedSeconds : 0) << "x realtime)" << std::endl;
+
+   return 0;
+}
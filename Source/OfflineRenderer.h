@@ -0,0 +1,56 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  OfflineRenderer.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include "juce_core/juce_core.h"
+
+#include <string>
+
+//renders a savestate straight to disk as fast as the cpu allows, without opening an audio device, a window,
+//or an OpenGL context. the synth is driven with a virtual clock: AudioOut() is called back to back, and Poll()
+//is called as often as the 60fps ui timer would have called it for the amount of audio rendered.
+//
+//usage: BespokeSynth --render song.bsk [--out song.wav] [--length seconds] [--samplerate rate]
+//                    [--buffersize size] [--channels count] [--bitdepth 16|24|32] [--threads count] [--stems]
+class OfflineRenderer
+{
+public:
+   static bool IsRequested(const juce::StringArray& args);
+
+   int Run(const juce::StringArray& args); //returns the process exit code
+
+private:
+   bool ParseArgs(const juce::StringArray& args);
+   static void PrintUsage();
+
+   std::string mSaveStatePath;
+   std::string mOutputPath;
+   double mLengthSeconds{ 60 };
+   int mSampleRate{ -1 }; //-1 uses the userprefs value
+   int mBufferSize{ -1 };
+   int mNumChannels{ 2 };
+   int mBitDepth{ 24 };
+   int mNumThreads{ -1 };
+   bool mWriteStems{ false }; //one stereo file per output channel pair
+};
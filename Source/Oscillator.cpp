@@ -24,9 +24,102 @@
 //
 
 #include "Oscillator.h"
+#include "SimdVec.h"
+
+namespace
+{
+   //difference between a polyblep step and a naive one, for a unit step at t = 0. t and dt are in cycles
+   float BlepResidual(float t, float dt)
+   {
+      if (t < dt)
+      {
+         float x = 1 - t / dt;
+         return -x * x * .5f;
+      }
+      if (t > 1 - dt)
+      {
+         float x = (t - 1) / dt + 1;
+         return x * x * .5f;
+      }
+      return 0;
+   }
+
+   //the integral of BlepResidual(), for a unit change in slope (per sample) at t = 0
+   float BlampResidual(float t, float dt)
+   {
+      if (t < dt)
+      {
+         float x = 1 - t / dt;
+         return x * x * x / 6;
+      }
+      if (t > 1 - dt)
+      {
+         float x = (t - 1) / dt + 1;
+         return x * x * x / 6;
+      }
+      return 0;
+   }
+
+   float Wrap01(float t)
+   {
+      return t - floorf(t);
+   }
+
+   using namespace Simd;
+
+   Vec BlepResidual(Vec t, Vec dt)
+   {
+      const Vec one = VecSet(1);
+      Vec x0 = VecSub(one, VecDiv(t, dt));
+      Vec x1 = VecAdd(VecDiv(VecSub(t, one), dt), one);
+      Vec afterStep = VecMul(VecMul(x0, x0), VecSet(-.5f));
+      Vec beforeStep = VecMul(VecMul(x1, x1), VecSet(.5f));
+      return VecSelect(VecLess(t, dt), afterStep, VecSelect(VecGreater(t, VecSub(one, dt)), beforeStep, VecSet(0)));
+   }
+
+   Vec BlampResidual(Vec t, Vec dt)
+   {
+      const Vec one = VecSet(1);
+      const Vec sixth = VecSet(1.0f / 6);
+      Vec x0 = VecSub(one, VecDiv(t, dt));
+      Vec x1 = VecAdd(VecDiv(VecSub(t, one), dt), one);
+      Vec afterCorner = VecMul(VecMul(VecMul(x0, x0), x0), sixth);
+      Vec beforeCorner = VecMul(VecMul(VecMul(x1, x1), x1), sixth);
+      return VecSelect(VecLess(t, dt), afterCorner, VecSelect(VecGreater(t, VecSub(one, dt)), beforeCorner, VecSet(0)));
+   }
+}
 
 float Oscillator::Value(float phase) const
 {
+   float rateMult;
+   phase = WarpPhase(phase, rateMult);
+   return ApplyPulseWidth(ShapeSample(phase));
+}
+
+float Oscillator::Value(float phase, float phaseInc) const
+{
+   if (!IsBandLimited())
+      return Value(phase);
+
+   float rateMult;
+   phase = WarpPhase(phase, rateMult);
+   float sample = ShapeSample(phase);
+   sample += BandLimitCorrection(phase / FTWO_PI, ofClamp(phaseInc * rateMult / FTWO_PI, 1e-6f, .5f));
+   return ApplyPulseWidth(sample);
+}
+
+void Oscillator::Render(const float* phases, const float* phaseIncs, float* out, int numSamples) const
+{
+   int i = RenderSimd(phases, phaseIncs, out, numSamples);
+   for (; i < numSamples; ++i)
+      out[i] = Value(phases[i], phaseIncs[i]);
+}
+
+//wraps phase into [0, 2pi), applying the triangle offset and shuffle. rateMult is how much faster than the input the output phase moves
+float Oscillator::WarpPhase(float phase, float& rateMult) const
+{
+   rateMult = 1;
+
    if (mType == kOsc_Tri)
       phase += .5f * FPI; //shift phase to make triangle start at zero instead of 1, to eliminate click on start
 
@@ -37,13 +130,22 @@ float Oscillator::Value(float phase) const
       float shufflePoint = FTWO_PI * (1 + mShuffle);
 
       if (phase < shufflePoint)
+      {
          phase = phase / (1 + mShuffle);
+         rateMult = 1 / (1 + mShuffle);
+      }
       else
+      {
          phase = (phase - shufflePoint) / (1 - mShuffle);
+         rateMult = 1 / (1 - mShuffle);
+      }
    }
 
-   phase = fmod(phase, FTWO_PI);
+   return fmod(phase, FTWO_PI);
+}
 
+float Oscillator::ShapeSample(float phase) const
+{
    float sample = 0;
    switch (mType)
    {
@@ -80,13 +182,89 @@ float Oscillator::Value(float phase) const
          //assert(false);
          break;
    }
+   return sample;
+}
 
+float Oscillator::ApplyPulseWidth(float sample) const
+{
    if (mType != kOsc_Square && mType != kOsc_Saw && mType != kOsc_NegSaw && mPulseWidth != .5f)
       sample = (Bias(sample / 2 + .5f, mPulseWidth) - .5f) * 2; //give "pulse width" to non-square/saw oscillators
-
    return sample;
 }
 
+bool Oscillator::IsBandLimited() const
+{
+   return mType == kOsc_Saw || mType == kOsc_NegSaw || mType == kOsc_Square || mType == kOsc_Tri;
+}
+
+//t is the warped phase in cycles, dt how far it moves per sample
+float Oscillator::BandLimitCorrection(float t, float dt) const
+{
+   switch (mType)
+   {
+      case kOsc_Saw: //drops by 2 at the wrap. softened saws don't have a step
+         return mSoften == 0 ? -2 * BlepResidual(t, dt) : 0;
+      case kOsc_NegSaw:
+         return mSoften == 0 ? 2 * BlepResidual(t, dt) : 0;
+      case kOsc_Square: //up by 2 at the wrap, down by 2 at the pulse width
+         return mSoften == 0 ? 2 * (BlepResidual(t, dt) - BlepResidual(Wrap01(t - mPulseWidth), dt)) : 0;
+      case kOsc_Tri: //slope goes from 4 to -4 at the wrap, and back at the halfway point
+         return 8 * dt * (BlampResidual(Wrap01(t - .5f), dt) - BlampResidual(t, dt));
+      default:
+         return 0;
+   }
+}
+
+//the common cases, four samples at a time. returns how many samples it rendered
+int Oscillator::RenderSimd(const float* phases, const float* phaseIncs, float* out, int numSamples) const
+{
+   if (mShuffle != 0 || mSoften != 0)
+      return 0;
+   if (mType != kOsc_Square && !((mType == kOsc_Saw || mType == kOsc_NegSaw || mType == kOsc_Tri) && mPulseWidth == .5f))
+      return 0;
+
+   const Vec one = VecSet(1);
+   const Vec two = VecSet(2);
+   const Vec half = VecSet(.5f);
+   const Vec invTwoPi = VecSet(1 / FTWO_PI);
+   const Vec minDt = VecSet(1e-6f);
+   const Vec pulseWidth = VecSet(mPulseWidth);
+   const Vec phaseShift = VecSet(mType == kOsc_Tri ? .5f * FPI : 0);
+
+   int i = 0;
+   for (; i + kNumLanes <= numSamples; i += kNumLanes)
+   {
+      Vec t = VecFrac(VecMul(VecAdd(VecLoad(phases + i), phaseShift), invTwoPi));
+      Vec dt = VecMin(VecMax(VecMul(VecLoad(phaseIncs + i), invTwoPi), minDt), half);
+
+      Vec sample;
+      switch (mType)
+      {
+         case kOsc_Saw:
+            sample = VecSub(VecSub(VecMul(t, two), one), VecMul(two, BlepResidual(t, dt)));
+            break;
+         case kOsc_NegSaw:
+            sample = VecAdd(VecSub(one, VecMul(t, two)), VecMul(two, BlepResidual(t, dt)));
+            break;
+         case kOsc_Square:
+            sample = VecSelect(VecGreater(t, pulseWidth), VecSet(-1), one);
+            sample = VecAdd(sample, VecMul(two, VecSub(BlepResidual(t, dt), BlepResidual(VecFrac(VecSub(t, pulseWidth)), dt))));
+            break;
+         default: //kOsc_Tri
+         {
+            Vec centered = VecSub(t, half);
+            Vec distance = VecMax(centered, VecSub(VecSet(0), centered));
+            sample = VecSub(VecMul(distance, VecSet(4)), one);
+            Vec correction = VecSub(BlampResidual(VecFrac(centered), dt), BlampResidual(t, dt));
+            sample = VecAdd(sample, VecMul(VecMul(VecSet(8), dt), correction));
+            break;
+         }
+      }
+      VecStore(out + i, sample);
+   }
+   return i;
+}
+
 float Oscillator::SawSample(float phase) const
 {
    phase /= FTWO_PI;
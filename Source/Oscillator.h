@@ -40,6 +40,10 @@ public:
    OscillatorType GetType() const { return mType; }
    void SetType(OscillatorType type) { mType = type; }
    float Value(float phase) const;
+   //band-limited versions of Value() for audio rate use, phaseInc is how far the phase moves each sample.
+   //saw, square and triangle edges get polyblep/polyblamp corrections, the other types come out the same as Value()
+   float Value(float phase, float phaseInc) const;
+   void Render(const float* phases, const float* phaseIncs, float* out, int numSamples) const;
    float GetPulseWidth() const { return mPulseWidth; }
    void SetPulseWidth(float width) { mPulseWidth = width; }
    float GetShuffle() const { return mShuffle; }
@@ -49,6 +53,12 @@ public:
    OscillatorType mType{ OscillatorType::kOsc_Sin };
 
 private:
+   float WarpPhase(float phase, float& rateMult) const;
+   float ShapeSample(float phase) const;
+   float ApplyPulseWidth(float sample) const;
+   float BandLimitCorrection(float t, float dt) const;
+   bool IsBandLimited() const;
+   int RenderSimd(const float* phases, const float* phaseIncs, float* out, int numSamples) const;
    float SawSample(float phase) const;
 
    float mPulseWidth{ .5 };
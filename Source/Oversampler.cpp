@@ -0,0 +1,314 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Oversampler.cpp
+//  Bespoke
+//
+//
+
+#include "Oversampler.h"
+#include "SimdVec.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+   using namespace Simd;
+
+   const int kMaxCoefs = 12;
+
+   struct HalfBandSpec
+   {
+      int mNumCoefs;
+      double mTransitionBandwidth; //relative to the higher of the stage's two sample rates
+   };
+
+   //the stage at the base rate has to keep the whole audible band clean. the stages above it only need to
+   //keep images out of the region that the base stage doesn't already remove, so they can be much cheaper
+   HalfBandSpec GetStageSpec(Oversampler::Quality quality, int stage)
+   {
+      if (stage == 0)
+      {
+         switch (quality)
+         {
+            case Oversampler::Quality::LowLatency: return { 4, .1 };
+            case Oversampler::Quality::HighQuality: return { 12, .02 };
+            default: return { 8, .04 };
+         }
+      }
+      return { quality == Oversampler::Quality::LowLatency ? 3 : 4, .25 - 1.0 / (4 << stage) };
+   }
+
+   //allpass coefficients for a polyphase half-band filter with an elliptic-like response. this is the
+   //classic closed-form design, as described in "Digital Signal Processing Schemes for Efficient Interpolation
+   //and Decimation" (Valenzuela & Constantinides, 1983)
+   void DesignHalfBand(int numCoefs, double transitionBandwidth, std::vector<float>& coefs)
+   {
+      double k = tan((1 - transitionBandwidth * 2) * M_PI / 4);
+      k *= k;
+      double kkSqrt = pow(1 - k * k, .25);
+      double e = .5 * (1 - kkSqrt) / (1 + kkSqrt);
+      double e2 = e * e;
+      double e4 = e2 * e2;
+      double q = e * (1 + e4 * (2 + e4 * (15 + 150 * e4)));
+
+      int order = numCoefs * 2 + 1;
+      coefs.resize(numCoefs);
+      for (int index = 0; index < numCoefs; ++index)
+      {
+         int c = index + 1;
+
+         double num = 0;
+         double term;
+         int i = 0;
+         int sign = 1;
+         do
+         {
+            term = pow(q, i * (i + 1)) * sin((i * 2 + 1) * c * M_PI / order) * sign;
+            num += term;
+            sign = -sign;
+            ++i;
+         } while (fabs(term) > 1e-100);
+         num *= pow(q, .25);
+
+         double den = .5;
+         i = 1;
+         sign = -1;
+         do
+         {
+            term = pow(q, i * i) * cos(i * 2 * c * M_PI / order) * sign;
+            den += term;
+            sign = -sign;
+            ++i;
+         } while (fabs(term) > 1e-100);
+
+         double ww = num / den;
+         double wwSq = ww * ww;
+         double x = sqrt((1 - wwSq * k) * (1 - wwSq / k)) / (1 + wwSq);
+         coefs[index] = float((1 - x) / (1 + x));
+      }
+   }
+
+   //gathers one sample from each channel in the lane group. unused lanes read as silence
+   inline Vec Gather(const float* const* channels, int numLanes, int index)
+   {
+      alignas(16) float lanes[kNumLanes] = { 0, 0, 0, 0 };
+      for (int lane = 0; lane < numLanes; ++lane)
+         lanes[lane] = channels[lane][index];
+      return VecLoad(lanes);
+   }
+
+   inline void Scatter(float* const* channels, int numLanes, int index, Vec value)
+   {
+      alignas(16) float lanes[kNumLanes];
+      VecStore(lanes, value);
+      for (int lane = 0; lane < numLanes; ++lane)
+         channels[lane][index] = lanes[lane];
+   }
+
+   //first-order allpass in the polyphase branch: y[n] = c * (x[n] - y[n-1]) + x[n-1]
+   inline Vec Allpass(Vec input, Vec coef, Vec& x, Vec& y)
+   {
+      Vec output = VecAdd(VecMul(VecSub(input, y), coef), x);
+      x = input;
+      y = output;
+      return output;
+   }
+
+   struct LaneState
+   {
+      Vec mCoefs[kMaxCoefs];
+      Vec mX[kMaxCoefs];
+      Vec mY[kMaxCoefs];
+      int mNumCoefs;
+
+      LaneState(const std::vector<float>& coefs, const float* state)
+      : mNumCoefs((int)coefs.size())
+      {
+         assert(mNumCoefs <= kMaxCoefs);
+         for (int i = 0; i < mNumCoefs; ++i)
+         {
+            mCoefs[i] = VecSet(coefs[i]);
+            mX[i] = VecLoad(state + (i * 2) * kNumLanes);
+            mY[i] = VecLoad(state + (i * 2 + 1) * kNumLanes);
+         }
+      }
+
+      void Store(float* state) const
+      {
+         for (int i = 0; i < mNumCoefs; ++i)
+         {
+            VecStore(state + (i * 2) * kNumLanes, mX[i]);
+            VecStore(state + (i * 2 + 1) * kNumLanes, mY[i]);
+         }
+      }
+
+      //even coefficients form the first branch, odd coefficients the second
+      void Run(Vec& branch0, Vec& branch1)
+      {
+         for (int i = 0; i < mNumCoefs; i += 2)
+         {
+            branch0 = Allpass(branch0, mCoefs[i], mX[i], mY[i]);
+            if (i + 1 < mNumCoefs)
+               branch1 = Allpass(branch1, mCoefs[i + 1], mX[i + 1], mY[i + 1]);
+         }
+      }
+   };
+}
+
+//static
+const char* Oversampler::GetQualityName(Quality quality)
+{
+   switch (quality)
+   {
+      case Quality::LowLatency: return "low latency";
+      case Quality::HighQuality: return "high quality";
+      default: return "balanced";
+   }
+}
+
+//static
+Oversampler::Quality Oversampler::GetQualityForName(const std::string& name)
+{
+   for (int i = 0; i < (int)Quality::Count; ++i)
+   {
+      if (name == GetQualityName((Quality)i))
+         return (Quality)i;
+   }
+   return Quality::Balanced;
+}
+
+Oversampler::Oversampler()
+{
+}
+
+Oversampler::~Oversampler()
+{
+}
+
+void Oversampler::Setup(int factor, int maxChannels, Quality quality)
+{
+   assert(factor >= 1 && (factor & (factor - 1)) == 0); //power of two
+
+   mFactor = factor;
+   mMaxLaneGroups = (maxChannels + kNumLanes - 1) / kNumLanes;
+   mStages.clear();
+   for (int stageFactor = 2, stage = 0; stageFactor <= factor; stageFactor *= 2, ++stage)
+   {
+      HalfBandSpec spec = GetStageSpec(quality, stage);
+      mStages.push_back(Stage());
+      DesignHalfBand(spec.mNumCoefs, spec.mTransitionBandwidth, mStages.back().mCoefs);
+   }
+   Reset();
+}
+
+void Oversampler::Reset()
+{
+   for (auto& stage : mStages)
+   {
+      size_t stateSize = mMaxLaneGroups * stage.mCoefs.size() * 2 * kNumLanes;
+      stage.mUpState.assign(stateSize, 0);
+      stage.mDownState.assign(stateSize, 0);
+   }
+}
+
+float Oversampler::GetLatency() const
+{
+   //a first-order allpass in z^-2 delays dc by 2(1-c)/(1+c) samples at the stage's higher rate, and the
+   //second branch has an extra sample of delay. at dc the output is the average of the two branches
+   float latency = 0;
+   int stageFactor = 2;
+   for (const auto& stage : mStages)
+   {
+      float branchDelay[2] = { 0, 1 };
+      for (size_t i = 0; i < stage.mCoefs.size(); ++i)
+         branchDelay[i % 2] += 2 * (1 - stage.mCoefs[i]) / (1 + stage.mCoefs[i]);
+      latency += (branchDelay[0] + branchDelay[1]) / 2 / stageFactor;
+      stageFactor *= 2;
+   }
+   return latency;
+}
+
+void Oversampler::Upsample(const float* const* input, float* const* output, int numChannels, int numInputSamples)
+{
+   int numLaneGroups = (numChannels + kNumLanes - 1) / kNumLanes;
+   assert(numLaneGroups <= mMaxLaneGroups);
+
+   int totalSamples = numInputSamples * mFactor;
+   for (int ch = 0; ch < numChannels; ++ch)
+      std::copy(input[ch], input[ch] + numInputSamples, output[ch] + totalSamples - numInputSamples);
+
+   //each stage reads from the tail of the output buffer and writes its doubled result ahead of it, so the
+   //samples it still has to read are never overwritten before it gets to them
+   int numSamples = numInputSamples;
+   for (auto& stage : mStages)
+   {
+      int readOffset = totalSamples - numSamples;
+      int writeOffset = totalSamples - numSamples * 2;
+      for (int group = 0; group < numLaneGroups; ++group)
+      {
+         int numLanes = std::min(kNumLanes, numChannels - group * kNumLanes);
+         float* const* channels = output + group * kNumLanes;
+         float* state = stage.mUpState.data() + group * stage.mCoefs.size() * 2 * kNumLanes;
+
+         LaneState lanes(stage.mCoefs, state);
+         for (int i = 0; i < numSamples; ++i)
+         {
+            Vec branch0 = Gather(channels, numLanes, readOffset + i);
+            Vec branch1 = branch0;
+            lanes.Run(branch0, branch1);
+            Scatter(channels, numLanes, writeOffset + i * 2, branch0);
+            Scatter(channels, numLanes, writeOffset + i * 2 + 1, branch1);
+         }
+         lanes.Store(state);
+      }
+      numSamples *= 2;
+   }
+}
+
+void Oversampler::DownsampleInPlace(float* const* buffers, int numChannels, int numOutputSamples)
+{
+   int numLaneGroups = (numChannels + kNumLanes - 1) / kNumLanes;
+   assert(numLaneGroups <= mMaxLaneGroups);
+
+   const Vec half = VecSet(.5f);
+   int numSamples = numOutputSamples * mFactor / 2;
+   for (int stageIndex = (int)mStages.size() - 1; stageIndex >= 0; --stageIndex)
+   {
+      Stage& stage = mStages[stageIndex];
+      for (int group = 0; group < numLaneGroups; ++group)
+      {
+         int numLanes = std::min(kNumLanes, numChannels - group * kNumLanes);
+         float* const* channels = buffers + group * kNumLanes;
+         float* state = stage.mDownState.data() + group * stage.mCoefs.size() * 2 * kNumLanes;
+
+         LaneState lanes(stage.mCoefs, state);
+         for (int i = 0; i < numSamples; ++i)
+         {
+            Vec branch0 = Gather(channels, numLanes, i * 2 + 1);
+            Vec branch1 = Gather(channels, numLanes, i * 2);
+            lanes.Run(branch0, branch1);
+            Scatter(channels, numLanes, i, VecMul(VecAdd(branch0, branch1), half));
+         }
+         lanes.Store(state);
+      }
+      numSamples /= 2;
+   }
+}
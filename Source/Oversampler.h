@@ -0,0 +1,71 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Oversampler.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+//power-of-two up/downsampling through a cascade of polyphase IIR half-band filters (two parallel chains of
+//first-order allpasses per 2x stage). each stage runs at the lower of its two rates, and channels are
+//processed together in SIMD lanes.
+class Oversampler
+{
+public:
+   enum class Quality
+   {
+      LowLatency,
+      Balanced,
+      HighQuality,
+      Count
+   };
+
+   static const char* GetQualityName(Quality quality);
+   static Quality GetQualityForName(const std::string& name); //falls back to Balanced
+
+   Oversampler();
+   ~Oversampler();
+
+   void Setup(int factor, int maxChannels, Quality quality);
+   void Reset();
+   int GetFactor() const { return mFactor; }
+   float GetLatency() const; //approximate group delay at dc of one direction, in samples at the base rate
+
+   //output needs room for numInputSamples * factor samples per channel
+   void Upsample(const float* const* input, float* const* output, int numChannels, int numInputSamples);
+   //buffers hold numOutputSamples * factor samples per channel, the result is written to the start of each buffer
+   void DownsampleInPlace(float* const* buffers, int numChannels, int numOutputSamples);
+
+private:
+   struct Stage
+   {
+      std::vector<float> mCoefs;
+      //allpass input/output history, interleaved as [lane group][coefficient][x, y][lane]
+      std::vector<float> mUpState;
+      std::vector<float> mDownState;
+   };
+
+   int mFactor{ 1 };
+   int mMaxLaneGroups{ 0 };
+   std::vector<Stage> mStages; //ordered from the base rate outwards
+};
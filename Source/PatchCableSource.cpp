@@ -125,6 +125,8 @@ void PatchCableSource::SetPatchCableTarget(PatchCable* cable, IClickable* target
       mAudioReceiver = audioReceiver;
       TheSynth->ArrangeAudioSourceDependencies();
    }
+   if (mType != kConnectionType_Audio)
+      TheSynth->OnNonAudioCableChanged();
 
    mOwner->PostRepatch(this, fromUserClick);
 
@@ -699,6 +701,8 @@ void PatchCableSource::RemovePatchCable(PatchCable* cable, bool fromUserAction)
 
    if (hadAudioReceiver)
       TheSynth->ArrangeAudioSourceDependencies();
+   if (mType != kConnectionType_Audio)
+      TheSynth->OnNonAudioCableChanged();
 }
 
 void PatchCableSource::ClearPatchCables()
@@ -48,6 +48,7 @@ public:
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
    float GetEffectAmount() override;
    std::string GetType() override { return "pitchshift"; }
+   float GetTailLengthMs() override { return 4 * 1024 * gInvSampleRateMs; } //a few fft windows of overlap-add
 
    void IntSliderUpdated(IntSlider* slider, int oldVal, double time) override;
    void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override;
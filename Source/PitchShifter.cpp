@@ -160,8 +160,8 @@ void PitchShifter::Process(float* buffer, int bufferSize)
       double phase = mSumPhase[k];
 
       // get real and imag part and re-interleave
-      mFFTData.mRealValues[k + 1] = mag * cos(phase);
-      mFFTData.mImaginaryValues[k + 1] = mag * sin(phase);
+      mFFTData.mRealValues[k] = mag * cos(phase);
+      mFFTData.mImaginaryValues[k] = mag * sin(phase);
    }
 
    mFFT.Inverse(mFFTData.mRealValues,
@@ -181,78 +181,6 @@ void PitchShifter::Process(float* buffer, int bufferSize)
 
 #else
 
-void smbFft(float* fftBuffer, long fftFrameSize, long sign)
-/*
-	FFT routine, (C)1996 S.M.Bernsee. Sign = -1 is FFT, 1 is iFFT (inverse)
-	Fills fftBuffer[0...2*fftFrameSize-1] with the Fourier transform of the
-	time domain data in fftBuffer[0...2*fftFrameSize-1]. The FFT array takes
-	and returns the cosine and sine parts in an interleaved manner, ie.
-	fftBuffer[0] = cosPart[0], fftBuffer[1] = sinPart[0], asf. fftFrameSize
-	must be a power of 2. It expects a complex input signal (see footnote 2),
-	ie. when working with 'common' audio signals our input signal has to be
-	passed as {in[0],0.,in[1],0.,in[2],0.,...} asf. In that case, the transform
-	of the frequencies of interest is in fftBuffer[0...fftFrameSize].
- */
-{
-   float wr, wi, arg, *p1, *p2, temp;
-   float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-   long i, bitm, j, le, le2, k;
-
-   for (i = 2; i < 2 * fftFrameSize - 2; i += 2)
-   {
-      for (bitm = 2, j = 0; bitm < 2 * fftFrameSize; bitm <<= 1)
-      {
-         if (i & bitm)
-            j++;
-         j <<= 1;
-      }
-      if (i < j)
-      {
-         p1 = fftBuffer + i;
-         p2 = fftBuffer + j;
-         temp = *p1;
-         *(p1++) = *p2;
-         *(p2++) = temp;
-         temp = *p1;
-         *p1 = *p2;
-         *p2 = temp;
-      }
-   }
-   for (k = 0, le = 2; k < (long)(log(fftFrameSize) / log(2.) + .5); k++)
-   {
-      le <<= 1;
-      le2 = le >> 1;
-      ur = 1.0;
-      ui = 0.0;
-      arg = M_PI / (le2 >> 1);
-      wr = cos(arg);
-      wi = sign * sin(arg);
-      for (j = 0; j < le2; j += 2)
-      {
-         p1r = fftBuffer + j;
-         p1i = p1r + 1;
-         p2r = p1r + le2;
-         p2i = p2r + 1;
-         for (i = j; i < 2 * fftFrameSize; i += le)
-         {
-            tr = *p2r * ur - *p2i * ui;
-            ti = *p2r * ui + *p2i * ur;
-            *p2r = *p1r - tr;
-            *p2i = *p1i - ti;
-            *p1r += tr;
-            *p1i += ti;
-            p1r += le;
-            p1i += le;
-            p2r += le;
-            p2i += le;
-         }
-         tr = ur * wr - ui * wi;
-         ui = ur * wi + ui * wr;
-         ur = tr;
-      }
-   }
-}
-
 /****************************************************************************
  *
  * NAME: smbPitchShift.cpp
@@ -303,7 +231,7 @@ void PitchShifter::Process(float* buffer, int bufferSize)
    float* outdata = buffer;
    const float pitchShift = mRatio;
 
-   double magn, phase, tmp, window, real, imag;
+   double magn, phase, tmp, real, imag;
    double freqPerBin, expct;
    long i, k, qpd, index, inFifoLatency, stepSize, fftFrameSize2;
 
@@ -323,7 +251,6 @@ void PitchShifter::Process(float* buffer, int bufferSize)
    {
       memset(gInFIFO, 0, MAX_FRAME_LENGTH * sizeof(float));
       memset(gOutFIFO, 0, MAX_FRAME_LENGTH * sizeof(float));
-      memset(gFFTworksp, 0, 2 * MAX_FRAME_LENGTH * sizeof(float));
       memset(gLastPhase, 0, (MAX_FRAME_LENGTH / 2 + 1) * sizeof(float));
       memset(gSumPhase, 0, (MAX_FRAME_LENGTH / 2 + 1) * sizeof(float));
       memset(gOutputAccum, 0, 2 * MAX_FRAME_LENGTH * sizeof(float));
@@ -345,25 +272,20 @@ void PitchShifter::Process(float* buffer, int bufferSize)
       {
          gRover = inFifoLatency;
 
-         /* do windowing and re,im interleave */
+         /* do windowing */
          for (k = 0; k < fftFrameSize; k++)
-         {
-            window = -.5 * cos(2. * M_PI * (double)k / (double)fftFrameSize) + .5;
-            gFFTworksp[2 * k] = gInFIFO[k] * window;
-            gFFTworksp[2 * k + 1] = 0.;
-         }
+            mFFTData.mTimeDomain[k] = gInFIFO[k] * mWindower[k];
 
 
          /* ***************** ANALYSIS ******************* */
          /* do transform */
-         smbFft(gFFTworksp, fftFrameSize, -1);
+         mFFT.Forward(mFFTData.mTimeDomain, mFFTData.mRealValues, mFFTData.mImaginaryValues);
 
          /* this is the analysis step */
          for (k = 0; k <= fftFrameSize2; k++)
          {
-            /* de-interlace FFT buffer */
-            real = gFFTworksp[2 * k];
-            imag = gFFTworksp[2 * k + 1];
+            real = mFFTData.mRealValues[k];
+            imag = mFFTData.mImaginaryValues[k];
 
             /* compute magnitude and phase */
             magn = 2. * sqrt(real * real + imag * imag);
@@ -433,23 +355,23 @@ void PitchShifter::Process(float* buffer, int bufferSize)
             gSumPhase[k] += tmp;
             phase = gSumPhase[k];
 
-            /* get real and imag part and re-interleave */
-            gFFTworksp[2 * k] = magn * cos(phase);
-            gFFTworksp[2 * k + 1] = magn * sin(phase);
-         }
+            /* the real inverse mirrors every bin but dc and nyquist into the negative frequencies, so halve those
+               to get the real part of the one-sided inverse */
+            if (k > 0 && k < fftFrameSize2)
+               magn *= .5;
 
-         /* zero negative frequencies */
-         for (k = fftFrameSize + 2; k < 2 * fftFrameSize; k++)
-            gFFTworksp[k] = 0.;
+            /* get real and imag part */
+            mFFTData.mRealValues[k] = magn * cos(phase);
+            mFFTData.mImaginaryValues[k] = magn * sin(phase);
+         }
 
          /* do inverse transform */
-         smbFft(gFFTworksp, fftFrameSize, 1);
+         mFFT.Inverse(mFFTData.mRealValues, mFFTData.mImaginaryValues, mFFTData.mTimeDomain);
 
          /* do windowing and add to output accumulator */
          for (k = 0; k < fftFrameSize; k++)
          {
-            window = -.5 * cos(2. * M_PI * (double)k / (double)fftFrameSize) + .5;
-            gOutputAccum[k] += 2. * window * gFFTworksp[2 * k] / (fftFrameSize2 * osamp);
+            gOutputAccum[k] += 2. * mWindower[k] * mFFTData.mTimeDomain[k] / (fftFrameSize2 * osamp);
          }
          for (k = 0; k < stepSize; k++)
             gOutFIFO[k] = gOutputAccum[k];
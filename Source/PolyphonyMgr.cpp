@@ -31,8 +31,11 @@
 #include "SampleVoice.h"
 #include "SynthGlobals.h"
 #include "Profiler.h"
-
-ChannelBuffer gMidiVoiceWorkChannelBuffer(kWorkBufferSize);
+#include "ModularSynth.h"
+#include "UserPrefs.h"
+#include "IAudioSource.h"
+#include "ModuleCpuStats.h"
+#include "SimdVec.h"
 
 PolyphonyMgr::PolyphonyMgr(IDrawableModule* owner)
 : mOwner(owner)
@@ -83,6 +86,38 @@ void PolyphonyMgr::Init(VoiceType type, IVoiceParams* params)
    {
       assert(false); //unsupported voice type
    }
+
+   for (int i = 0; i < kNumVoices; ++i)
+      mVoices[i].mVoice->SetMaxBufferSize(GetMaxVoiceBufferSize());
+
+   IAudioSource* ownerSource = dynamic_cast<IAudioSource*>(mOwner);
+   if (ownerSource != nullptr)
+      mOwnerCpuStats = &ownerSource->GetCpuStats();
+}
+
+//voices render into the oversampled buffer, or the fade out buffer when they get stolen
+int PolyphonyMgr::GetMaxVoiceBufferSize() const
+{
+   return std::max(gBufferSize, kVoiceFadeSamples) * mOversampling;
+}
+
+void PolyphonyMgr::SetOversampling(int oversampling)
+{
+   if (oversampling == mOversampling)
+      return;
+
+   ScopedAudioSuspend audioSuspend; //buffers get reallocated
+   mOversampling = oversampling;
+   mOversampledBuffer.Resize(gBufferSize * oversampling);
+   mFadeOutBuffer.Resize(kVoiceFadeSamples * oversampling);
+   mFadeOutWorkBuffer.Resize(kVoiceFadeSamples * oversampling);
+   mFadeOutBufferPos = 0;
+   mOversampler.Setup(oversampling, ChannelBuffer::kMaxNumChannels, Oversampler::GetQualityForName(UserPrefs.oversampling_quality.Get()));
+   for (int i = 0; i < kNumVoices; ++i)
+   {
+      if (mVoices[i].mVoice != nullptr)
+         mVoices[i].mVoice->SetMaxBufferSize(GetMaxVoiceBufferSize());
+   }
 }
 
 void PolyphonyMgr::Start(double time, int pitch, float amount, int voiceIdx, ModulationParameters modulation)
@@ -134,11 +169,12 @@ void PolyphonyMgr::Start(double time, int pitch, float amount, int voiceIdx, Mod
       //ofLog() << "fading stolen voice " << voiceIdx << " at " << time;
       mFadeOutWorkBuffer.Clear();
       voice->Process(time, &mFadeOutWorkBuffer, mOversampling);
-      for (int i = 0; i < kVoiceFadeSamples; ++i)
+      int fadeLength = mFadeOutBuffer.BufferSize();
+      for (int i = 0; i < fadeLength; ++i)
       {
-         float fade = 1 - (float(i) / kVoiceFadeSamples);
+         float fade = 1 - (float(i) / fadeLength);
          for (int ch = 0; ch < mFadeOutBuffer.NumActiveChannels(); ++ch)
-            mFadeOutBuffer.GetChannel(ch)[(i + mFadeOutBufferPos) % kVoiceFadeSamples] += mFadeOutWorkBuffer.GetChannel(ch)[i] * fade;
+            mFadeOutBuffer.GetChannel(ch)[(i + mFadeOutBufferPos) % fadeLength] += mFadeOutWorkBuffer.GetChannel(ch)[i] * fade;
       }
    }
    if (!preserveVoice)
@@ -188,37 +224,85 @@ void PolyphonyMgr::Process(double time, ChannelBuffer* out, int bufferSize)
 {
    PROFILER(PolyphonyMgr);
 
-   mFadeOutBuffer.SetNumActiveChannels(out->NumActiveChannels());
-   mFadeOutWorkBuffer.SetNumActiveChannels(out->NumActiveChannels());
+   int numChannels = out->NumActiveChannels();
+   mFadeOutBuffer.SetNumActiveChannels(numChannels);
+   mFadeOutWorkBuffer.SetNumActiveChannels(numChannels);
 
+   //summing the voices at the oversampled rate means the mix only needs to be filtered down once
+   ChannelBuffer* voiceBuffer = out;
+   if (mOversampling != 1)
+   {
+      assert(mOversampledBuffer.BufferSize() == bufferSize * mOversampling);
+      voiceBuffer = &mOversampledBuffer;
+      mOversampledBuffer.SetNumActiveChannels(numChannels);
+      mOversampledBuffer.Clear();
+   }
+   int voiceBufferSize = bufferSize * mOversampling;
+
+   ModuleCpuStats* cpuStats = ModuleCpuStats::IsEnabled() ? mOwnerCpuStats : nullptr;
+
+   //active voices get rendered in groups, so voices that support it can run a SIMD lane each
+   const int kMaxBatchSize = Simd::kNumLanes;
+   int batchSize = UserPrefs.batch_voices.Get() ? kMaxBatchSize : 1;
+   int batch[kMaxBatchSize];
+   int numInBatch = 0;
    float debugRef = 0;
    for (int i = 0; i < mVoiceLimit; ++i)
    {
       if (mVoices[i].mPitch != -1)
+         batch[numInBatch++] = i;
+
+      if (numInBatch == batchSize || (numInBatch > 0 && i == mVoiceLimit - 1))
       {
-         mVoices[i].mVoice->Process(time, out, mOversampling);
+         {
+            ModuleCpuStats::ScopedVoiceTimer voiceTimer(cpuStats);
+            IMidiVoice* voices[kMaxBatchSize];
+            for (int j = 0; j < numInBatch; ++j)
+               voices[j] = mVoices[batch[j]].mVoice;
+            if (numInBatch == 1 || !voices[0]->ProcessBatch(voices, numInBatch, time, voiceBuffer, mOversampling))
+            {
+               for (int j = 0; j < numInBatch; ++j)
+                  voices[j]->Process(time, voiceBuffer, mOversampling);
+            }
+         }
 
-         float testSample = out->GetChannel(0)[0];
-         mVoices[i].mActivity = testSample - debugRef;
+         float testSample = voiceBuffer->GetChannel(0)[0];
+         for (int j = 0; j < numInBatch; ++j)
+         {
+            VoiceInfo& voice = mVoices[batch[j]];
+            voice.mActivity = testSample - debugRef;
 
-         if (!mVoices[i].mNoteOn && mVoices[i].mVoice->IsDone(time))
-            mVoices[i].mPitch = -1;
+            if (!voice.mNoteOn && voice.mVoice->IsDone(time))
+               voice.mPitch = -1;
+         }
 
          debugRef = testSample;
+         numInBatch = 0;
       }
    }
 
-   for (int ch = 0; ch < out->NumActiveChannels(); ++ch)
+   int fadeLength = mFadeOutBuffer.BufferSize();
+   for (int ch = 0; ch < numChannels; ++ch)
    {
-      for (int i = 0; i < bufferSize; ++i)
+      for (int i = 0; i < voiceBufferSize; ++i)
       {
-         int fadeOutIdx = (i + mFadeOutBufferPos) % kVoiceFadeSamples;
-         out->GetChannel(ch)[i] += mFadeOutBuffer.GetChannel(ch)[fadeOutIdx];
+         int fadeOutIdx = (i + mFadeOutBufferPos) % fadeLength;
+         voiceBuffer->GetChannel(ch)[i] += mFadeOutBuffer.GetChannel(ch)[fadeOutIdx];
          mFadeOutBuffer.GetChannel(ch)[fadeOutIdx] = 0;
       }
    }
 
-   mFadeOutBufferPos += bufferSize;
+   mFadeOutBufferPos += voiceBufferSize;
+
+   if (mOversampling != 1)
+   {
+      float* channels[ChannelBuffer::kMaxNumChannels];
+      for (int ch = 0; ch < numChannels; ++ch)
+         channels[ch] = mOversampledBuffer.GetChannel(ch);
+      mOversampler.DownsampleInPlace(channels, numChannels, bufferSize);
+      for (int ch = 0; ch < numChannels; ++ch)
+         Add(out->GetChannel(ch), channels[ch], bufferSize);
+   }
 }
 
 void PolyphonyMgr::DrawDebug(float x, float y)
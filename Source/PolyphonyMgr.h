@@ -30,14 +30,14 @@
 #include "OpenFrameworksPort.h"
 #include "SynthGlobals.h"
 #include "ChannelBuffer.h"
+#include "Oversampler.h"
 
 const int kVoiceFadeSamples = 50;
 
-extern ChannelBuffer gMidiVoiceWorkChannelBuffer;
-
 class IMidiVoice;
 class IVoiceParams;
 class IDrawableModule;
+class ModuleCpuStats;
 struct ModulationParameters;
 
 enum VoiceType
@@ -72,17 +72,22 @@ public:
    void DrawDebug(float x, float y);
    void SetVoiceLimit(int limit) { mVoiceLimit = limit; }
    void KillAll();
-   void SetOversampling(int oversampling) { mOversampling = oversampling; }
+   void SetOversampling(int oversampling); //voices then render at the oversampled rate, and get filtered down together
 
 private:
+   int GetMaxVoiceBufferSize() const;
+
    VoiceInfo mVoices[kNumVoices];
    bool mAllowStealing{ true };
    int mLastVoice{ -1 };
-   ChannelBuffer mFadeOutBuffer{ kVoiceFadeSamples };
+   ChannelBuffer mFadeOutBuffer{ kVoiceFadeSamples }; //at the oversampled rate
    ChannelBuffer mFadeOutWorkBuffer{ kVoiceFadeSamples };
+   ChannelBuffer mOversampledBuffer{ 1 };
+   Oversampler mOversampler;
    float mWorkBuffer[2048]{};
    int mFadeOutBufferPos{ 0 };
    IDrawableModule* mOwner;
+   ModuleCpuStats* mOwnerCpuStats{ nullptr }; //voice costs are reported as part of the owner's
    int mVoiceLimit{ kNumVoices };
    int mOversampling{ 1 };
 };
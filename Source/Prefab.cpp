@@ -296,7 +296,7 @@ void Prefab::LoadPrefab(std::string loadPath)
 {
    sLoadingPrefab = true;
 
-   ScopedMutex mutex(TheSynth->GetAudioMutex(), "LoadPrefab()");
+   ScopedAudioSuspend audioSuspend;
    std::lock_guard<std::recursive_mutex> renderLock(TheSynth->GetRenderLock());
 
    mModuleContainer.Clear();
@@ -31,8 +31,16 @@ PressureToVibrato::PressureToVibrato()
 {
 }
 
+void PressureToVibrato::Init()
+{
+   IDrawableModule::Init();
+
+   TheTransport->AddAudioPoller(this);
+}
+
 PressureToVibrato::~PressureToVibrato()
 {
+   TheTransport->RemoveAudioPoller(this);
 }
 
 void PressureToVibrato::CreateUIControls()
@@ -60,6 +68,11 @@ void PressureToVibrato::DrawModule()
    mIntervalSelector->Draw();
 }
 
+void PressureToVibrato::OnTransportAdvanced(float amount)
+{
+   mModulation.FillLFOBuffers();
+}
+
 void PressureToVibrato::PlayNote(double time, int pitch, int velocity, int voiceIdx, ModulationParameters modulation)
 {
    if (mEnabled)
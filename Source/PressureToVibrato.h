@@ -32,8 +32,9 @@
 #include "Checkbox.h"
 #include "ModulationChain.h"
 #include "DropdownList.h"
+#include "Transport.h"
 
-class PressureToVibrato : public NoteEffectBase, public IDrawableModule, public IFloatSliderListener, public IDropdownListener
+class PressureToVibrato : public NoteEffectBase, public IDrawableModule, public IFloatSliderListener, public IDropdownListener, public IAudioPoller
 {
 public:
    PressureToVibrato();
@@ -44,8 +45,11 @@ public:
    static bool AcceptsPulses() { return false; }
 
    void CreateUIControls() override;
+   void Init() override;
    void SetEnabled(bool enabled) override { mEnabled = enabled; }
 
+   void OnTransportAdvanced(float amount) override;
+
    //INoteReceiver
    void PlayNote(double time, int pitch, int velocity, int voiceIdx = -1, ModulationParameters modulation = ModulationParameters()) override;
 
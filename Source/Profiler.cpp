@@ -25,18 +25,63 @@
 
 #include "Profiler.h"
 #include "SynthGlobals.h"
+#include "ModularSynth.h"
+#include "AudioGraphExecutor.h"
 #include <time.h>
+#include <chrono>
+#include <thread>
 #if BESPOKE_WINDOWS
 #include <intrin.h>
-#else
-#include <chrono>
 #endif
 
+#include "juce_events/juce_events.h"
+
 Profiler::Cost Profiler::sCosts[];
 bool Profiler::sEnableProfiler = false;
+std::atomic<bool> Profiler::sTracing{ false };
+
+struct Profiler::TraceThread
+{
+   struct Event
+   {
+      const char* mName;
+      long long mStart;
+      long long mDuration;
+      bool mIsMarker;
+   };
+
+   //only the owning thread writes, and the trace is only read once StopTrace() has seen every thread finish.
+   //once full it wraps around over the oldest events, so a long capture keeps its most recent stretch
+   void Add(const char* name, long long start, long long duration, bool isMarker)
+   {
+      int numEvents = mNumEvents.load(std::memory_order_relaxed);
+      mEvents[numEvents % kCapacity] = { name, start, duration, isMarker };
+      mNumEvents.store(numEvents + 1, std::memory_order_release);
+   }
+
+   static const int kCapacity = 1 << 16;
+
+   std::unique_ptr<Event[]> mEvents; //only allocated while a capture is running
+   std::atomic<int> mNumEvents{ 0 };
+   std::atomic<bool> mAdding{ false }; //held around Add(), so StopTrace() can wait out one that's partway through
+   const char* mLabel{ "" };
+};
 
 namespace
 {
+   const int kMaxTraceThreads = 16;
+   const double kMaxTraceSeconds = 60;
+
+   //allocated on the first capture and never freed, so a scope that outlives its capture can't write into freed memory
+   std::unique_ptr<Profiler::TraceThread> sTraceThreads[kMaxTraceThreads];
+   std::atomic<int> sNumTraceThreads{ 0 };
+   std::atomic<int> sTraceGeneration{ 0 };
+   long long sTraceStartTime = 0;
+   long long sTraceEndTime = 0;
+
+   thread_local Profiler::TraceThread* tTraceThread = nullptr;
+   thread_local int tTraceGeneration = -1;
+
    static inline uint64_t rdtscp(uint32_t& aux)
    {
 #if BESPOKE_WINDOWS
@@ -55,7 +100,19 @@ namespace
 
 Profiler::Profiler(const char* name, uint32_t hash)
 {
-   if (sEnableProfiler)
+   if (sTracing.load(std::memory_order_relaxed))
+   {
+      mTraceThread = GetTraceThread();
+      if (mTraceThread != nullptr)
+      {
+         mName = name;
+         mTraceGeneration = sTraceGeneration.load(std::memory_order_relaxed);
+         mTraceStart = GetTraceTime();
+      }
+   }
+
+   //the counters are per audio buffer, so only audio thread scopes are meaningful there
+   if (sEnableProfiler && IsAudioThread())
    {
       for (int i = 0; i < PROFILER_MAX_TRACK; ++i)
       {
@@ -84,7 +141,10 @@ Profiler::Profiler(const char* name, uint32_t hash)
 
 Profiler::~Profiler()
 {
-   if (sEnableProfiler)
+   if (mTraceThread != nullptr && sTracing.load(std::memory_order_relaxed))
+      AddTraceEvent(mTraceThread, mTraceGeneration, mName, mTraceStart, GetTraceTime() - mTraceStart, false);
+
+   if (mIndex != -1)
    {
       uint32_t aux;
       sCosts[mIndex].mFrameCost += rdtscp(aux) - mTimerStart;
@@ -186,3 +246,165 @@ unsigned long long Profiler::Cost::MaxCost() const
       maxCost = MAX(maxCost, mHistory[i]);
    return maxCost;
 }
+
+//static
+long long Profiler::GetTraceTime()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//static
+Profiler::TraceThread* Profiler::GetTraceThread()
+{
+   //each thread claims a buffer the first time it hits a scope during a capture
+   int generation = sTraceGeneration.load(std::memory_order_acquire);
+   if (tTraceGeneration != generation)
+   {
+      tTraceGeneration = generation;
+      int index = sNumTraceThreads.fetch_add(1);
+      tTraceThread = index < kMaxTraceThreads ? sTraceThreads[index].get() : nullptr;
+      if (tTraceThread != nullptr)
+      {
+         if (AudioGraphExecutor::IsWorkerThread())
+            tTraceThread->mLabel = "audio worker";
+         else if (IsAudioThread())
+            tTraceThread->mLabel = "audio";
+         else if (juce::MessageManager::existsAndIsCurrentThread())
+            tTraceThread->mLabel = "main";
+         else
+            tTraceThread->mLabel = "other";
+      }
+   }
+   return tTraceThread;
+}
+
+//static
+bool Profiler::StartTrace(double seconds, std::string& error)
+{
+   if (IsTracing())
+   {
+      error = "already capturing a trace";
+      return false;
+   }
+   if (seconds <= 0 || seconds > kMaxTraceSeconds)
+   {
+      error = "trace length must be between 0 and " + ofToString(kMaxTraceSeconds) + " seconds";
+      return false;
+   }
+
+   //nothing is adding to these, since the last capture waited for every thread to finish in StopTrace()
+   for (auto& traceThread : sTraceThreads)
+   {
+      if (traceThread == nullptr)
+         traceThread = std::make_unique<TraceThread>();
+      traceThread->mEvents.reset(new TraceThread::Event[TraceThread::kCapacity]);
+      traceThread->mNumEvents.store(0);
+   }
+   sNumTraceThreads.store(0);
+   sTraceGeneration.fetch_add(1, std::memory_order_release);
+   sTraceStartTime = GetTraceTime();
+   sTraceEndTime = sTraceStartTime + (long long)(seconds * 1000000000);
+   sTracing.store(true);
+   return true;
+}
+
+//static
+void Profiler::PollTrace()
+{
+   if (IsTracing() && GetTraceTime() >= sTraceEndTime)
+   {
+      StopTrace();
+      WriteTrace();
+
+      for (auto& traceThread : sTraceThreads)
+         traceThread->mEvents.reset();
+   }
+}
+
+//static
+void Profiler::StopTrace()
+{
+   sTracing.store(false);
+
+   //a scope that saw tracing still on might be partway through adding its event, so let those finish before reading.
+   //AddTraceEvent() sets the flag before it checks sTracing, so any that we don't see here will see tracing is off
+   for (auto& traceThread : sTraceThreads)
+   {
+      while (traceThread->mAdding.load())
+         std::this_thread::yield();
+   }
+}
+
+//static
+void Profiler::AddTraceEvent(TraceThread* traceThread, int generation, const char* name, long long start, long long duration, bool isMarker)
+{
+   traceThread->mAdding.store(true);
+   if (sTracing.load() && sTraceGeneration.load(std::memory_order_relaxed) == generation)
+      traceThread->Add(name, start, duration, isMarker);
+   traceThread->mAdding.store(false, std::memory_order_release);
+}
+
+//static
+void Profiler::TraceMarker(const char* name, long long durationNanoseconds)
+{
+   if (!IsTracing())
+      return;
+   TraceThread* traceThread = GetTraceThread();
+   if (traceThread != nullptr)
+      AddTraceEvent(traceThread, tTraceGeneration, name, GetTraceTime(), durationNanoseconds, true);
+}
+
+//static
+void Profiler::WriteTrace()
+{
+   std::string output = "{\"traceEvents\":[\n";
+   int numThreads = std::min(sNumTraceThreads.load(), kMaxTraceThreads);
+   int numDropped = 0;
+   int numMarkers = 0;
+   bool first = true;
+   char line[256];
+   for (int i = 0; i < numThreads; ++i)
+   {
+      const TraceThread* traceThread = sTraceThreads[i].get();
+      int tid = i + 1;
+      snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", first ? "" : ",\n", tid, traceThread->mLabel, tid);
+      output += line;
+      first = false;
+
+      int numEvents = traceThread->mNumEvents.load(std::memory_order_acquire);
+      int firstEvent = std::max(0, numEvents - TraceThread::kCapacity); //anything before this has been written over
+      numDropped += firstEvent;
+      for (int j = firstEvent; j < numEvents; ++j)
+      {
+         const TraceThread::Event& event = traceThread->mEvents[j % TraceThread::kCapacity];
+         double start = (event.mStart - sTraceStartTime) / 1000.0;
+         double duration = event.mDuration / 1000.0;
+         if (event.mIsMarker)
+         {
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"duration_us\":%.3f}}", event.mName, tid, start, duration);
+            ++numMarkers;
+         }
+         else
+         {
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.mName, tid, start, duration);
+         }
+         output += line;
+      }
+   }
+   snprintf(line, sizeof(line), "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"samplerate\":%d,\"buffersize\":%d,\"droppedEvents\":%d}}\n", gSampleRate, gBufferSize, numDropped);
+   output += line;
+
+   std::string path = ofToDataPath(ofGetTimestampString("trace_%Y-%m-%d_%H-%M-%S.json"));
+   if (!juce::File(path).replaceWithText(output))
+   {
+      TheSynth->LogEvent("couldn't write " + path, kLogEventType_Error);
+      return;
+   }
+
+   std::string summary = "wrote " + path;
+   if (numMarkers > 0)
+      summary += " (" + ofToString(numMarkers) + " markers)";
+   TheSynth->LogEvent(summary, numMarkers > 0 ? kLogEventType_Warning : kLogEventType_Verbose);
+   if (numDropped > 0 || sNumTraceThreads.load() > kMaxTraceThreads)
+      TheSynth->LogEvent("trace buffers filled up, the earliest events are missing", kLogEventType_Warning);
+}
@@ -29,6 +29,8 @@
 #include "OpenFrameworksPort.h"
 #include "SynthGlobals.h"
 
+#include <atomic>
+
 #define PROFILER_HISTORY_LENGTH 500
 #define PROFILER_MAX_TRACK 100
 
@@ -47,8 +49,23 @@ public:
 
    static void ToggleProfiler();
 
+   //chrome trace capture (load the file in chrome://tracing or ui.perfetto.dev). every PROFILER scope on every thread
+   //gets recorded into a per-thread ring for the requested number of seconds, then PollTrace() stops it and writes it out.
+   //the rings only exist during a capture, and keep the most recent events if a long capture overflows them.
+   static bool StartTrace(double seconds, std::string& error);
+   static void PollTrace(); //main thread
+   static bool IsTracing() { return sTracing.load(std::memory_order_relaxed); }
+   static long long GetTraceTime(); //nanoseconds
+   static void TraceMarker(const char* name, long long durationNanoseconds); //an instant event, e.g. an xrun
+
+   struct TraceThread; //defined in Profiler.cpp
+
 private:
    static long GetSafeFrameLengthNanoseconds();
+   static TraceThread* GetTraceThread();
+   static void AddTraceEvent(TraceThread* traceThread, int generation, const char* name, long long start, long long duration, bool isMarker);
+   static void StopTrace();
+   static void WriteTrace();
 
    struct Cost
    {
@@ -64,9 +81,14 @@ private:
 
    unsigned long long mTimerStart{ 0 };
    int mIndex{ -1 };
+   const char* mName{ nullptr };
+   TraceThread* mTraceThread{ nullptr };
+   long long mTraceStart{ 0 };
+   int mTraceGeneration{ 0 };
 
    static Cost sCosts[PROFILER_MAX_TRACK];
    static bool sEnableProfiler;
+   static std::atomic<bool> sTracing;
 };
 
 #endif /* defined(__modularSynth__Profiler__) */
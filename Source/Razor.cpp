@@ -39,6 +39,7 @@ namespace
 }
 
 Razor::Razor()
+: mWorkBuffer(gBufferSize * 4)
 {
    std::memset(mAmp, 0, sizeof(float) * NUM_PARTIALS);
    std::memset(mPeakHistory, 0, sizeof(float) * (VIZ_WIDTH + 1) * RAZOR_HISTORY);
@@ -106,32 +107,48 @@ void Razor::Process(double time)
    if (!mManualControl)
       CalcAmp();
 
+   float* freqs = mWorkBuffer.data();
+   float* nyquistLimitIdxs = freqs + bufferSize;
+   float* envelope = nyquistLimitIdxs + bufferSize;
+   float* write = envelope + bufferSize;
+
+   int maxNyquistLimitIdx = 0;
    for (int i = 0; i < bufferSize; ++i)
    {
-      float freq = TheScale->PitchToFreq(mPitch + (mPitchBend ? mPitchBend->GetValue(i) : 0));
-
-      int oscNyquistLimitIdx = int(gNyquistLimit / freq);
+      freqs[i] = TheScale->PitchToFreq(mPitch + (mPitchBend ? mPitchBend->GetValue(i) : 0));
+      int oscNyquistLimitIdx = int(gNyquistLimit / freqs[i]);
+      nyquistLimitIdxs[i] = oscNyquistLimitIdx;
+      maxNyquistLimitIdx = MAX(maxNyquistLimitIdx, oscNyquistLimitIdx);
+      write[i] = 0;
+   }
 
-      float write = 0;
-      for (int j = 0; j < mUseNumPartials && j < oscNyquistLimitIdx; ++j)
+   //a partial at a time, so each envelope can be rendered for the whole block
+   for (int j = 0; j < mUseNumPartials && j < maxNyquistLimitIdx; ++j)
+   {
+      mAdsr[j].FillBuffer(time, gInvSampleRateMs, envelope, bufferSize);
+      for (int i = 0; i < bufferSize; ++i)
       {
-         float phaseInc = 512. / (gSampleRate / (freq)) * (j + 1) * mDetune[j];
+         if (j >= nyquistLimitIdxs[i])
+            continue;
+
+         float phaseInc = 512. / (gSampleRate / (freqs[i])) * (j + 1) * mDetune[j];
          mPhases[j] += phaseInc;
          while (mPhases[j] >= 512)
          {
             mPhases[j] -= 512;
          }
 
-         float sample = SinSample(mPhases[j]) * mAdsr[j].Value(time) * mAmp[j] * mVol;
+         float sample = SinSample(mPhases[j]) * envelope[i] * mAmp[j] * mVol;
 
-         write += sample;
+         write[i] += sample;
       }
+   }
 
-      GetVizBuffer()->Write(write, 0);
-
-      out[i] += write;
+   for (int i = 0; i < bufferSize; ++i)
+   {
+      GetVizBuffer()->Write(write[i], 0);
 
-      time += gInvSampleRateMs;
+      out[i] += write[i];
    }
 }
 
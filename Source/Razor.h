@@ -97,6 +97,7 @@ private:
    float mAmp[NUM_PARTIALS]{};
    float mPhases[NUM_PARTIALS]{};
    float mDetune[NUM_PARTIALS]{};
+   std::vector<float> mWorkBuffer; //per-sample frequencies, partial limits, envelope and output for the current block
 
    int mPitch{ -1 };
 
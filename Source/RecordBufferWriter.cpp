@@ -0,0 +1,146 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  RecordBufferWriter.cpp
+//  Bespoke
+//
+//
+
+
+#include "RecordBufferWriter.h"
+#include "RollingBuffer.h"
+
+#include "juce_audio_formats/juce_audio_formats.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+   const int kWriteChunkSize = 1 << 16;
+}
+
+RecordBufferWriter::~RecordBufferWriter()
+{
+   WaitUntilDone();
+}
+
+void RecordBufferWriter::WaitUntilDone()
+{
+   if (mThread.joinable())
+      mThread.join();
+}
+
+//static
+std::string RecordBufferWriter::GetUnusedPath(const std::string& path)
+{
+   juce::File file(path);
+   if (file.exists())
+      file = file.getNonexistentSibling();
+   return file.getFullPathName().toStdString();
+}
+
+bool RecordBufferWriter::Start(RollingBuffer* buffer, long long& recordingLength, const std::string& path, RecordingStream::Format format, int bitsPerSample, int sampleRate)
+{
+   if (mState.load() == State::Writing)
+      return false;
+   if (mThread.joinable())
+      mThread.join();
+
+   mPath = path;
+   mFormat = format;
+   mBitsPerSample = bitsPerSample;
+   mSampleRate = sampleRate;
+
+   //oldest first, ending where the audio thread is about to write next
+   mNumChannels = std::min(buffer->NumChannels(), ChannelBuffer::kMaxNumChannels);
+   for (int ch = 0; ch < mNumChannels; ++ch)
+      mChannels[ch] = buffer->GetRawBuffer()->GetChannel(ch);
+   mBufferSize = buffer->Size();
+   mLength = std::min<int64_t>(recordingLength, mBufferSize);
+   mStart = int((buffer->GetRawBufferOffset(0) - mLength + mBufferSize) % mBufferSize);
+   mFramesRead = 0;
+   mFramesRecorded = 0;
+   recordingLength = 0;
+
+   mState = State::Writing;
+   mThread = std::thread(&RecordBufferWriter::Run, this);
+   return true;
+}
+
+bool RecordBufferWriter::TakeFinished(std::string& path, bool& succeeded)
+{
+   if (mState.load() != State::Finished)
+      return false;
+
+   mThread.join();
+   path = mPath;
+   succeeded = mSucceeded;
+   mState = State::Idle;
+   return true;
+}
+
+void RecordBufferWriter::Record(RollingBuffer* buffer, long long& recordingLength, float* const* samples, int numChannels, int size)
+{
+   if (mState.load(std::memory_order_acquire) == State::Writing)
+   {
+      //what's left after the part still waiting to be copied out
+      int64_t space = mBufferSize - mLength + mFramesRead.load(std::memory_order_acquire) - mFramesRecorded;
+      if (space < size)
+      {
+         recordingLength = 0; //start again after this, rather than leave a gap in the middle of the next recording
+         return;
+      }
+      mFramesRecorded += size;
+   }
+
+   for (int ch = 0; ch < numChannels; ++ch)
+      buffer->WriteChunk(samples[ch], size, ch);
+   recordingLength = std::min<long long>(recordingLength + size, buffer->Size());
+}
+
+void RecordBufferWriter::Run()
+{
+   auto writer = RecordingStream::CreateWriter(mPath, mFormat, mSampleRate, mNumChannels, mBitsPerSample);
+   mSucceeded = writer != nullptr;
+
+   std::vector<std::vector<float> > chunk(mNumChannels, std::vector<float>(kWriteChunkSize));
+   const float* chunkChannels[ChannelBuffer::kMaxNumChannels];
+   for (int ch = 0; ch < mNumChannels; ++ch)
+      chunkChannels[ch] = chunk[ch].data();
+
+   for (int64_t pos = 0; pos < mLength && mSucceeded; pos += kWriteChunkSize)
+   {
+      //copied out before encoding, so the audio thread gets this part of the buffer back as soon as possible
+      int length = (int)std::min<int64_t>(kWriteChunkSize, mLength - pos);
+      int readPos = int((mStart + pos) % mBufferSize);
+      int firstPart = std::min(length, mBufferSize - readPos);
+      for (int ch = 0; ch < mNumChannels; ++ch)
+      {
+         std::copy(mChannels[ch] + readPos, mChannels[ch] + readPos + firstPart, chunk[ch].data());
+         std::copy(mChannels[ch], mChannels[ch] + length - firstPart, chunk[ch].data() + firstPart);
+      }
+      mFramesRead.store(pos + length, std::memory_order_release);
+
+      mSucceeded = writer->writeFromFloatArrays(chunkChannels, mNumChannels, length);
+   }
+
+   writer.reset(); //finishes off the header
+   mFramesRead = mLength;
+   mState.store(State::Finished, std::memory_order_release);
+}
@@ -0,0 +1,87 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  RecordBufferWriter.h
+//  Bespoke
+//
+//
+
+
+#pragma once
+
+#include "ChannelBuffer.h"
+#include "RecordingStream.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+class RollingBuffer;
+
+//writes out the always-on record buffer on a thread of its own, so the audio keeps going while the file is encoded.
+//Start() only notes down which part of the buffer to write, and the audio thread then records over just the part that's
+//been copied out already. the copy gets ahead of the audio within a block or two, so the next recording starts from there
+class RecordBufferWriter
+{
+public:
+   ~RecordBufferWriter();
+
+   //path, or a new name next to it if something is already there. touches the disk, so call it before taking the audio thread mutex
+   static std::string GetUnusedPath(const std::string& path);
+
+   //main thread, holding the audio thread mutex so the buffer is still while it's looked at. resets recordingLength.
+   //path is written as given, so get it from GetUnusedPath() first. returns false if the last write hasn't finished yet
+   bool Start(RollingBuffer* buffer, long long& recordingLength, const std::string& path, RecordingStream::Format format, int bitsPerSample, int sampleRate);
+   bool IsWriting() const { return mState.load() != State::Idle; }
+   float GetProgress() const { return mLength > 0 ? float(mFramesRead.load()) / mLength : 1; }
+   //true once per write, after it's done. path comes back as it was actually written, which might have been renamed to not overwrite anything
+   bool TakeFinished(std::string& path, bool& succeeded);
+   void WaitUntilDone();
+
+   //audio thread, in place of writing to the buffer directly
+   void Record(RollingBuffer* buffer, long long& recordingLength, float* const* samples, int numChannels, int size);
+
+private:
+   enum class State
+   {
+      Idle,
+      Writing,
+      Finished
+   };
+
+   void Run();
+
+   std::thread mThread;
+   std::atomic<State> mState{ State::Idle };
+   std::string mPath;
+   RecordingStream::Format mFormat{ RecordingStream::Format::Wav };
+   int mBitsPerSample{ 16 };
+   int mSampleRate{ 44100 };
+   bool mSucceeded{ false };
+
+   //the snapshot
+   const float* mChannels[ChannelBuffer::kMaxNumChannels]{};
+   int mNumChannels{ 0 };
+   int mBufferSize{ 1 };
+   int mStart{ 0 };
+   int64_t mLength{ 0 };
+
+   std::atomic<int64_t> mFramesRead{ 0 }; //copied out of the buffer, by the writer thread
+   int64_t mFramesRecorded{ 0 }; //into the buffer since Start(), by the audio thread
+};
@@ -0,0 +1,328 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  RecordingStream.cpp
+//  Bespoke
+//
+//
+
+#include "RecordingStream.h"
+#include "ChannelBuffer.h"
+
+#include "juce_audio_formats/juce_audio_formats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <thread>
+
+namespace
+{
+   const int kWriteChunkSize = 8192;
+   const int kRingSeconds = 10;
+   const int kBitsPerSample = 24;
+}
+
+//one thread drains every open recording, a chunk from each in turn so one slow file doesn't hold up the rest
+class RecordingStreamWriter
+{
+public:
+   static RecordingStreamWriter& Get()
+   {
+      static RecordingStreamWriter sWriter;
+      return sWriter;
+   }
+
+   void Add(RecordingStream* stream)
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStreams.push_back(stream);
+      if (!mThread.joinable())
+         mThread = std::thread(&RecordingStreamWriter::Run, this);
+      mCondition.notify_all();
+   }
+
+   //once this returns the thread is done with the stream
+   void Remove(RecordingStream* stream)
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStreams.erase(std::remove(mStreams.begin(), mStreams.end(), stream), mStreams.end());
+   }
+
+private:
+   ~RecordingStreamWriter()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mMutex);
+         mExit = true;
+      }
+      mCondition.notify_all();
+      if (mThread.joinable())
+         mThread.join();
+   }
+
+   void Run()
+   {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while (!mExit)
+      {
+         bool didWork = false;
+         for (auto* stream : mStreams)
+            didWork = stream->Drain() || didWork;
+
+         //the audio thread doesn't signal anything, and the ring holds seconds, so there's no hurry
+         if (!didWork)
+            mCondition.wait_for(lock, std::chrono::milliseconds(10));
+      }
+   }
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::vector<RecordingStream*> mStreams;
+   std::thread mThread;
+   bool mExit{ false };
+};
+
+RecordingStream::RecordingStream(const std::string& path, Format format, int sampleRate, int64_t leadingSilence)
+: mFormat(format)
+, mSampleRate(sampleRate)
+, mLeadingSilence(leadingSilence)
+{
+   juce::File file(path);
+   if (file.exists())
+      file = file.getNonexistentSibling();
+   file.create(); //claims the name now, and makes any missing folders
+   mPath = file.getFullPathName().toStdString();
+
+   mCapacity = std::max(sampleRate * kRingSeconds, kWriteChunkSize);
+   mRing.assign(ChannelBuffer::kMaxNumChannels, std::vector<float>(mCapacity, 0));
+
+   RecordingStreamWriter::Get().Add(this);
+}
+
+RecordingStream::~RecordingStream()
+{
+   RecordingStreamWriter::Get().Remove(this);
+
+   while (Drain())
+   {
+   }
+
+   //the audio thread is done, so anything it dropped after the last frames it got into the ring goes on the end
+   if (mWriter != nullptr && !mFailed && mUnpushedGap > 0)
+      WriteSilence(mUnpushedGap);
+
+   if (mWriter != nullptr)
+      mWriter.reset(); //finishes off the header
+   else
+      juce::File(mPath).deleteFile(); //nothing was ever recorded, don't leave an empty file behind
+}
+
+void RecordingStream::Write(ChannelBuffer* buffer, int numFrames)
+{
+   int numChannels = mNumChannels.load(std::memory_order_relaxed);
+   if (numChannels == 0)
+   {
+      numChannels = std::min(buffer->NumActiveChannels(), ChannelBuffer::kMaxNumChannels);
+      mNumChannels.store(numChannels, std::memory_order_relaxed); //the writer only looks once it sees frames, so the release below covers this
+   }
+
+   int64_t written = mFramesWritten.load(std::memory_order_relaxed);
+   int space = mCapacity - int(written - mFramesRead.load(std::memory_order_acquire));
+   int length = std::min(numFrames, space);
+
+   //the writer has to know where the dropped frames were before it sees what came after them
+   if (length > 0 && mUnpushedGap > 0)
+   {
+      int pushed = mGapsPushed.load(std::memory_order_relaxed);
+      if (pushed - mGapsPopped.load(std::memory_order_acquire) < kMaxGaps)
+      {
+         mGaps[pushed % kMaxGaps] = { written, mUnpushedGap };
+         mGapsPushed.store(pushed + 1, std::memory_order_release);
+         mUnpushedGap = 0;
+      }
+      else
+      {
+         length = 0; //no room to say where the gap is, so keep growing it rather than lose track of it
+      }
+   }
+
+   if (length < numFrames)
+   {
+      mUnpushedGap += numFrames - length;
+      mDroppedFrames.fetch_add(numFrames - length, std::memory_order_relaxed);
+   }
+
+   int pos = int(written % mCapacity);
+   int firstPart = std::min(length, mCapacity - pos);
+   for (int ch = 0; ch < numChannels; ++ch)
+   {
+      const float* source = buffer->GetChannel(std::min(ch, buffer->NumActiveChannels() - 1));
+      float* dest = mRing[ch].data();
+      std::copy(source, source + firstPart, dest + pos);
+      std::copy(source + firstPart, source + length, dest);
+   }
+
+   mFramesWritten.store(written + length, std::memory_order_release);
+}
+
+bool RecordingStream::Drain()
+{
+   int64_t read = mFramesRead.load(std::memory_order_relaxed);
+   int64_t available = mFramesWritten.load(std::memory_order_acquire) - read;
+   int popped = mGapsPopped.load(std::memory_order_relaxed);
+   bool hasGap = popped != mGapsPushed.load(std::memory_order_acquire);
+   if (available == 0 && !hasGap)
+      return false;
+
+   if (mWriter == nullptr && !mFailed && !Open())
+      mFailed = true;
+
+   if (hasGap)
+   {
+      const Gap& gap = mGaps[popped % kMaxGaps];
+      if (gap.mAt == read)
+      {
+         if (!mFailed)
+            WriteSilence(gap.mLength);
+         mGapsPopped.store(popped + 1, std::memory_order_release);
+         return true;
+      }
+      available = std::min(available, gap.mAt - read); //up to the gap, then fill it in on the next pass
+   }
+   if (available == 0)
+      return false;
+
+   int pos = int(read % mCapacity);
+   int length = (int)std::min<int64_t>(std::min<int64_t>(available, kWriteChunkSize), mCapacity - pos);
+   if (!mFailed)
+   {
+      const float* data[ChannelBuffer::kMaxNumChannels];
+      for (int ch = 0; ch < mNumChannels; ++ch)
+         data[ch] = mRing[ch].data() + pos;
+      WriteToFile(data, length);
+   }
+   else
+   {
+      length = (int)available; //nowhere to put it, but keep the ring moving so the audio thread doesn't count it as dropped
+   }
+
+   mFramesRead.store(read + length, std::memory_order_release);
+   return true;
+}
+
+//static
+std::unique_ptr<juce::AudioFormatWriter> RecordingStream::CreateWriter(const std::string& path, Format format, int sampleRate, int numChannels, int bitsPerSample)
+{
+   std::unique_ptr<juce::AudioFormat> audioFormat;
+   if (format == Format::Flac)
+   {
+      audioFormat = std::make_unique<juce::FlacAudioFormat>();
+      bitsPerSample = std::min(bitsPerSample, 24);
+   }
+   else
+   {
+      audioFormat = std::make_unique<juce::WavAudioFormat>();
+   }
+
+   juce::File file(path);
+   file.create(); //makes any missing folders
+   auto outputTo = file.createOutputStream();
+   if (outputTo == nullptr)
+      return nullptr;
+   std::unique_ptr<juce::AudioFormatWriter> writer(audioFormat->createWriterFor(outputTo.get(), sampleRate, numChannels, bitsPerSample, {}, 0));
+   if (writer != nullptr)
+      outputTo.release(); //the writer owns it now
+   return writer;
+}
+
+bool RecordingStream::Open()
+{
+   mWriter = CreateWriter(mPath, mFormat, mSampleRate, mNumChannels, kBitsPerSample);
+   if (mWriter == nullptr)
+      return false;
+
+   WriteSilence(mLeadingSilence);
+
+   return !mFailed;
+}
+
+void RecordingStream::WriteSilence(int64_t numFrames)
+{
+   if (numFrames <= 0)
+      return;
+
+   std::vector<float> silence((size_t)std::min<int64_t>(numFrames, kWriteChunkSize), 0);
+   const float* data[ChannelBuffer::kMaxNumChannels];
+   for (int ch = 0; ch < mNumChannels; ++ch)
+      data[ch] = silence.data();
+   for (int64_t pos = 0; pos < numFrames && !mFailed; pos += kWriteChunkSize)
+      WriteToFile(data, (int)std::min<int64_t>(kWriteChunkSize, numFrames - pos));
+}
+
+void RecordingStream::WriteToFile(const float* const* data, int numFrames)
+{
+   if (!mWriter->writeFromFloatArrays(data, mNumChannels, numFrames))
+   {
+      mFailed = true; //most likely the disk is full
+      return;
+   }
+
+   mFramesSinceFlush += numFrames;
+   if (mFramesSinceFlush >= mSampleRate)
+   {
+      mWriter->flush(); //rewrites the wav header to cover everything so far
+      mFramesSinceFlush = 0;
+   }
+
+   AddToOverview(data, numFrames);
+}
+
+void RecordingStream::AddToOverview(const float* const* data, int numFrames)
+{
+   //peak each channel over the run that fits in the current point first, rather than checking the step every frame
+   std::lock_guard<std::mutex> lock(mOverviewMutex);
+   for (int i = 0; i < numFrames;)
+   {
+      int run = (int)std::min<int64_t>(numFrames - i, mOverviewStep - mOverviewCount);
+      for (int ch = 0; ch < mNumChannels; ++ch)
+      {
+         for (int j = i; j < i + run; ++j)
+            mOverviewPeak = std::max(mOverviewPeak, std::abs(data[ch][j]));
+      }
+      i += run;
+      mOverviewCount += run;
+
+      if (mOverviewCount == mOverviewStep)
+      {
+         mOverview.push_back(mOverviewPeak);
+         mOverviewPeak = 0;
+         mOverviewCount = 0;
+
+         //full, so halve the resolution. the vector never grows past this, so drawing costs the same however long the take
+         if ((int)mOverview.size() == kMaxOverviewPoints)
+         {
+            for (int p = 0; p < kMaxOverviewPoints / 2; ++p)
+               mOverview[p] = std::max(mOverview[p * 2], mOverview[p * 2 + 1]);
+            mOverview.resize(kMaxOverviewPoints / 2);
+            mOverviewStep *= 2;
+         }
+      }
+   }
+}
@@ -0,0 +1,123 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  RecordingStream.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ChannelBuffer;
+
+namespace juce
+{
+   class AudioFormatWriter;
+}
+
+//records straight to a file on disk, so a recording can be as long as the disk allows. the audio thread only copies into a
+//preallocated ring, and a shared writer thread drains it into the file. wav headers are rewritten every second as it goes,
+//so a crash leaves a playable file. flac only writes its length at the end, which decoders treat as unknown if it never gets there.
+//if the disk falls behind by more than the ring holds, the audio thread drops what doesn't fit rather than waiting, and counts it.
+//the writer puts silence in the file where the dropped audio would have gone, so the file stays in time with the rest of the take
+class RecordingStream
+{
+public:
+   enum class Format
+   {
+      Wav,
+      Flac
+   };
+
+   static const int kMaxOverviewPoints = 4096;
+
+   //leadingSilence frames of silence go in ahead of whatever gets written, to line the file up with ones that started earlier.
+   //if path already exists, the file goes next to it under a new name, see GetPath()
+   RecordingStream(const std::string& path, Format format, int sampleRate, int64_t leadingSilence);
+   ~RecordingStream(); //writes out whatever is still in the ring and closes the file. the audio thread has to be done with it first
+
+   static std::string GetExtension(Format format) { return format == Format::Flac ? ".flac" : ".wav"; }
+   //opens path for writing in the given format. flac can't hold floats, so 32 bits comes out as 24 there. null if it can't be opened
+   static std::unique_ptr<juce::AudioFormatWriter> CreateWriter(const std::string& path, Format format, int sampleRate, int numChannels, int bitsPerSample);
+
+   std::string GetPath() const { return mPath; }
+   bool HasFailed() const { return mFailed; }
+   int64_t GetDroppedFrames() const { return mDroppedFrames; }
+
+   //audio thread. the number of channels is fixed by the first call, anything past it is ignored and missing channels are
+   //filled from the last one
+   void Write(ChannelBuffer* buffer, int numFrames);
+
+   //one point per GetOverviewStep() frames of the file, holding the peak across all channels in that stretch, for drawing.
+   //the step doubles whenever the overview would go past kMaxOverviewPoints, so a long take stays cheap to draw.
+   //hold the lock while reading either
+   const std::vector<float>& GetOverview() const { return mOverview; }
+   int64_t GetOverviewStep() const { return mOverviewStep; }
+   std::mutex& GetOverviewMutex() { return mOverviewMutex; }
+
+private:
+   friend class RecordingStreamWriter;
+
+   //a stretch of dropped frames, at its position in the stream of frames going into the ring
+   struct Gap
+   {
+      int64_t mAt{ 0 };
+      int64_t mLength{ 0 };
+   };
+   static const int kMaxGaps = 64;
+
+   bool Drain(); //writer thread. returns true if it wrote anything
+   bool Open();
+   void WriteSilence(int64_t numFrames);
+   void WriteToFile(const float* const* data, int numFrames);
+   void AddToOverview(const float* const* data, int numFrames);
+
+   std::string mPath;
+   Format mFormat{ Format::Wav };
+   int mSampleRate{ 44100 };
+   int64_t mLeadingSilence{ 0 };
+   std::unique_ptr<juce::AudioFormatWriter> mWriter;
+   int64_t mFramesSinceFlush{ 0 };
+   std::atomic<bool> mFailed{ false };
+
+   std::vector<std::vector<float> > mRing;
+   int mCapacity{ 1 };
+   std::atomic<int> mNumChannels{ 0 }; //set by the first Write()
+   std::atomic<int64_t> mFramesWritten{ 0 }; //into the ring, by the audio thread
+   std::atomic<int64_t> mFramesRead{ 0 }; //out of the ring, by the writer thread
+   std::atomic<int64_t> mDroppedFrames{ 0 };
+
+   //gaps go from the audio thread to the writer in order, through a fixed ring so the audio thread never allocates
+   Gap mGaps[kMaxGaps];
+   std::atomic<int> mGapsPushed{ 0 };
+   std::atomic<int> mGapsPopped{ 0 };
+   int64_t mUnpushedGap{ 0 }; //audio thread. frames dropped at the end of the ring that aren't in mGaps yet
+
+   std::mutex mOverviewMutex; //the writer thread and drawing, never the audio thread
+   std::vector<float> mOverview;
+   int64_t mOverviewStep{ 256 };
+   float mOverviewPeak{ 0 };
+   int64_t mOverviewCount{ 0 };
+};
@@ -0,0 +1,302 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Resampler.cpp
+//  Bespoke
+//
+//
+
+#include "Resampler.h"
+#include "SimdVec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Simd;
+
+namespace
+{
+   const int kNumPhases = 256;
+   const int kNumCutoffs = 9; //quarter octaves, from no lowering down to two octaves below nyquist
+
+   //one table per tap count and cutoff. each phase has its kernel followed by the difference to the next phase's,
+   //so a kernel between two phases is row + frac * delta
+   struct KernelTable
+   {
+      int mNumTaps{ 0 };
+      std::vector<float> mRows;
+
+      const float* GetRow(int phase) const { return mRows.data() + phase * mNumTaps * 2; }
+   };
+
+   struct KernelTables
+   {
+      KernelTables()
+      {
+         const int kTapCounts[] = { 8, 16, 32 };
+         for (int i = 0; i < 3; ++i)
+         {
+            for (int cutoff = 0; cutoff < kNumCutoffs; ++cutoff)
+               Build(mTables[i][cutoff], kTapCounts[i], pow(2.0, -cutoff / 4.0));
+         }
+      }
+
+      void Build(KernelTable& table, int numTaps, double cutoff)
+      {
+         const double kPi = 3.14159265358979323846;
+         int half = numTaps / 2;
+         std::vector<float> kernels((kNumPhases + 1) * numTaps);
+         for (int phase = 0; phase <= kNumPhases; ++phase)
+         {
+            double frac = double(phase) / kNumPhases;
+            float* kernel = &kernels[phase * numTaps];
+            double sum = 0;
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+               //distance from this tap to the point being read
+               double x = frac + half - 1 - tap;
+               double sinc = x == 0 ? 1 : sin(kPi * cutoff * x) / (kPi * cutoff * x);
+               double w = 0.42 + 0.5 * cos(kPi * x / half) + 0.08 * cos(2 * kPi * x / half);
+               kernel[tap] = float(cutoff * sinc * w);
+               sum += kernel[tap];
+            }
+            for (int tap = 0; tap < numTaps; ++tap)
+               kernel[tap] /= float(sum); //unity gain at dc for every phase, or the level would ripple with the position
+         }
+
+         table.mNumTaps = numTaps;
+         table.mRows.resize(kNumPhases * numTaps * 2);
+         for (int phase = 0; phase < kNumPhases; ++phase)
+         {
+            const float* kernel = &kernels[phase * numTaps];
+            const float* next = &kernels[(phase + 1) * numTaps];
+            float* row = table.mRows.data() + phase * numTaps * 2;
+            for (int tap = 0; tap < numTaps; ++tap)
+            {
+               row[tap] = kernel[tap];
+               row[numTaps + tap] = next[tap] - kernel[tap];
+            }
+         }
+      }
+
+      KernelTable mTables[3][kNumCutoffs];
+   };
+
+   //built up front rather than on first use, so the first sample played doesn't pay for it on the audio thread
+   const KernelTables sKernelTables;
+
+   double Wrap(double position, int length)
+   {
+      position -= length * floor(position / length);
+      return position < length ? position : 0; //floating point can round up to length
+   }
+
+   //the frame at index, wrapped around the buffer or silent off either end
+   inline float GetFrame(const float* data, int index, int sourceLength, bool wrap)
+   {
+      if (index >= 0 && index < sourceLength)
+         return data[index];
+      if (!wrap)
+         return 0;
+      index %= sourceLength;
+      return data[index < 0 ? index + sourceLength : index];
+   }
+
+   //the whole frame at or before pos. positions only go negative when not wrapping, and int() rounds those the wrong way
+   inline int GetWholeFrame(double pos)
+   {
+      int whole = int(pos);
+      return pos < whole ? whole - 1 : whole;
+   }
+
+   //no interpolation to do, so copy straight through, wrapping as needed
+   void ReadUnity(const float* const* source, int numSourceChannels, int sourceLength, int start, float* const* dest, int numDestChannels, int numFrames, float gain, bool add, bool wrap)
+   {
+      for (int ch = 0; ch < numDestChannels; ++ch)
+      {
+         const float* data = source[std::min(ch, numSourceChannels - 1)];
+         if (!wrap)
+         {
+            for (int i = 0; i < numFrames; ++i)
+            {
+               float sample = GetFrame(data, start + i, sourceLength, false) * gain;
+               dest[ch][i] = add ? dest[ch][i] + sample : sample;
+            }
+            continue;
+         }
+
+         int pos = start;
+         for (int i = 0; i < numFrames;)
+         {
+            int length = std::min(numFrames - i, sourceLength - pos);
+            for (int j = 0; j < length; ++j)
+               dest[ch][i + j] = add ? dest[ch][i + j] + data[pos + j] * gain : data[pos + j] * gain;
+            i += length;
+            pos = 0;
+         }
+      }
+   }
+
+   double ReadLinear(const float* const* source, int numSourceChannels, int sourceLength, double offset, double step, float* const* dest, int numDestChannels, int numFrames, float gain, bool add, bool wrap)
+   {
+      double pos = wrap ? Wrap(offset, sourceLength) : offset;
+      for (int i = 0; i < numFrames; ++i)
+      {
+         int whole = GetWholeFrame(pos);
+         float a = float(pos - whole);
+         for (int ch = 0; ch < numDestChannels; ++ch)
+         {
+            const float* data = source[std::min(ch, numSourceChannels - 1)];
+            float sample = ((1 - a) * GetFrame(data, whole, sourceLength, wrap) + a * GetFrame(data, whole + 1, sourceLength, wrap)) * gain;
+            dest[ch][i] = add ? dest[ch][i] + sample : sample;
+         }
+
+         pos += step;
+         if (wrap && (pos >= sourceLength || pos < 0))
+            pos = Wrap(pos, sourceLength);
+      }
+      return offset + step * numFrames;
+   }
+
+   //the tap count is a template argument so the tap loops unroll. frames go kNumLanes at a time, so their dot products
+   //can be summed across with one transpose instead of a horizontal add each
+   template <int NumTaps>
+   void ReadSinc(const KernelTable& table, const float* const* source, int numSourceChannels, int sourceLength, double offset, double step, float* const* dest, int numDestChannels, int numFrames, float gain, bool add, bool wrap)
+   {
+      const int half = NumTaps / 2;
+      const int kNumVecs = NumTaps / kNumLanes;
+
+      Vec kernels[kNumLanes][kNumVecs];
+      int firsts[kNumLanes];
+      alignas(16) float gathered[kNumLanes][NumTaps];
+      alignas(16) float samples[kNumLanes];
+      Vec gainVec = VecSet(gain);
+      double pos = wrap ? Wrap(offset, sourceLength) : offset;
+      for (int i = 0; i < numFrames; i += kNumLanes)
+      {
+         //a short last group works out its spare lanes at the last frame's position, and doesn't write them
+         int numInGroup = std::min(kNumLanes, numFrames - i);
+         for (int frame = 0; frame < kNumLanes; ++frame)
+         {
+            int whole = GetWholeFrame(pos);
+            float phasePos = float(pos - whole) * kNumPhases;
+            int phase = std::min(int(phasePos), kNumPhases - 1);
+            Vec phaseFrac = VecSet(phasePos - phase);
+            const float* row = table.GetRow(phase);
+            for (int v = 0; v < kNumVecs; ++v)
+               kernels[frame][v] = VecAdd(VecLoad(row + v * kNumLanes), VecMul(phaseFrac, VecLoad(row + NumTaps + v * kNumLanes)));
+            firsts[frame] = whole - half + 1;
+
+            if (frame < numInGroup)
+            {
+               pos += step;
+               if (wrap && (pos >= sourceLength || pos < 0))
+                  pos = Wrap(pos, sourceLength);
+            }
+         }
+
+         int lastSourceChannel = -1;
+         for (int ch = 0; ch < numDestChannels; ++ch)
+         {
+            int sourceChannel = std::min(ch, numSourceChannels - 1);
+            if (sourceChannel != lastSourceChannel)
+            {
+               const float* data = source[sourceChannel];
+               Vec sums[kNumLanes];
+               for (int frame = 0; frame < kNumLanes; ++frame)
+               {
+                  int first = firsts[frame];
+                  const float* taps = data + first;
+                  if (first < 0 || first + NumTaps > sourceLength)
+                  {
+                     //near an end, so gather the taps around it
+                     for (int tap = 0; tap < NumTaps; ++tap)
+                        gathered[frame][tap] = GetFrame(data, first + tap, sourceLength, wrap);
+                     taps = gathered[frame];
+                  }
+
+                  Vec sum = VecMul(VecLoad(taps), kernels[frame][0]);
+                  for (int v = 1; v < kNumVecs; ++v)
+                     sum = VecAdd(sum, VecMul(VecLoad(taps + v * kNumLanes), kernels[frame][v]));
+                  sums[frame] = sum;
+               }
+               VecTranspose(sums[0], sums[1], sums[2], sums[3]);
+               VecStore(samples, VecMul(VecAdd(VecAdd(sums[0], sums[1]), VecAdd(sums[2], sums[3])), gainVec));
+               lastSourceChannel = sourceChannel;
+            }
+
+            for (int frame = 0; frame < numInGroup; ++frame)
+               dest[ch][i + frame] = add ? dest[ch][i + frame] + samples[frame] : samples[frame];
+         }
+      }
+   }
+}
+
+const char* Resampler::GetQualityName(Quality quality)
+{
+   switch (quality)
+   {
+      case Quality::Linear: return "linear";
+      case Quality::Sinc8: return "sinc 8";
+      case Quality::Sinc32: return "sinc 32";
+      default: return "sinc 16";
+   }
+}
+
+Resampler::Quality Resampler::GetQualityForName(const std::string& name)
+{
+   for (int i = 0; i < (int)Quality::Count; ++i)
+   {
+      if (name == GetQualityName((Quality)i))
+         return (Quality)i;
+   }
+   return Quality::Sinc16;
+}
+
+double Resampler::Read(const float* const* source, int numSourceChannels, int sourceLength, double offset, double step, float* const* dest, int numDestChannels, int numFrames, Quality quality, float gain, bool add, bool wrap)
+{
+   if (sourceLength <= 0 || numSourceChannels <= 0)
+   {
+      for (int ch = 0; ch < numDestChannels && !add; ++ch)
+         std::fill(dest[ch], dest[ch] + numFrames, 0.0f);
+      return offset + step * numFrames;
+   }
+
+   //every kernel passes the source straight through at phase 0 with no lowered cutoff, so this is the same answer, cheaper
+   if (step == 1 && offset == floor(offset))
+   {
+      ReadUnity(source, numSourceChannels, sourceLength, wrap ? int(Wrap(offset, sourceLength)) : int(offset), dest, numDestChannels, numFrames, gain, add, wrap);
+      return offset + numFrames;
+   }
+
+   if (quality == Quality::Linear)
+      return ReadLinear(source, numSourceChannels, sourceLength, offset, step, dest, numDestChannels, numFrames, gain, add, wrap);
+
+   //a cutoff at or below 1/step, in quarter octaves
+   double speed = fabs(step);
+   int cutoff = speed > 1 ? std::min(int(ceil(4 * log2(speed) - 1e-6)), kNumCutoffs - 1) : 0;
+   const KernelTable& table = sKernelTables.mTables[(int)quality - (int)Quality::Sinc8][cutoff];
+   switch (quality)
+   {
+      case Quality::Sinc8: ReadSinc<8>(table, source, numSourceChannels, sourceLength, offset, step, dest, numDestChannels, numFrames, gain, add, wrap); break;
+      case Quality::Sinc16: ReadSinc<16>(table, source, numSourceChannels, sourceLength, offset, step, dest, numDestChannels, numFrames, gain, add, wrap); break;
+      default: ReadSinc<32>(table, source, numSourceChannels, sourceLength, offset, step, dest, numDestChannels, numFrames, gain, add, wrap); break;
+   }
+   return offset + step * numFrames;
+}
@@ -0,0 +1,51 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  Resampler.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <string>
+
+//reads a buffer at fractional positions a block at a time, for playing it back at another rate.
+//the sinc qualities blend between precomputed blackman-windowed sinc kernels at kNumPhases fractional offsets. when
+//stepping faster than one source frame per frame the cutoff is lowered to match, so speeding up doesn't alias.
+//the taps run in simd lanes, and each frame's kernel is worked out once and shared by every channel
+namespace Resampler
+{
+   enum class Quality
+   {
+      Linear,
+      Sinc8,
+      Sinc16,
+      Sinc32,
+      Count
+   };
+
+   const char* GetQualityName(Quality quality);
+   Quality GetQualityForName(const std::string& name); //falls back to Sinc16
+
+   //fills numFrames frames of each dest channel, starting at offset in source and moving step source frames per frame.
+   //with wrap, positions and taps wrap around sourceLength, for loops. without it, anything before the start or past the end
+   //reads as silence, so a one-shot doesn't pick up its other end. dest channels past numSourceChannels repeat the last
+   //source channel. returns the offset after the block
+   double Read(const float* const* source, int numSourceChannels, int sourceLength, double offset, double step, float* const* dest, int numDestChannels, int numFrames, Quality quality, float gain = 1, bool add = false, bool wrap = true);
+}
@@ -68,7 +68,7 @@ void RollingBuffer::Accum(int samplesAgo, float sample, int channel)
    mBuffer.GetChannel(channel)[(Size() + mOffsetToNow[channel] - samplesAgo) % Size()] += sample;
 }
 
-void RollingBuffer::WriteChunk(float* samples, int size, int channel)
+void RollingBuffer::WriteChunk(const float* samples, int size, int channel)
 {
    assert(size < Size());
 
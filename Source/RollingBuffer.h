@@ -37,7 +37,7 @@ public:
    ~RollingBuffer();
    float GetSample(int samplesAgo, int channel);
    void ReadChunk(float* dst, int size, int samplesAgo, int channel);
-   void WriteChunk(float* samples, int size, int channel);
+   void WriteChunk(const float* samples, int size, int channel);
    void Write(float sample, int channel);
    void ClearBuffer();
    void Draw(int x, int y, int width, int height, int length = -1, int channel = -1, int delayOffset = 0);
@@ -0,0 +1,254 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  STFT.cpp
+//  Bespoke
+//
+//
+
+#include "STFT.h"
+#include "SynthGlobals.h"
+
+#include <algorithm>
+
+STFT::Layout::Layout(int numInputs, int windowSize, int overlap)
+: mWindowSize(windowSize)
+, mHopSize(std::max(1, windowSize / std::max(1, overlap)))
+{
+   mFFT = std::make_unique<::FFT>(mWindowSize);
+
+   mWindow.resize(mWindowSize);
+   for (int i = 0; i < mWindowSize; ++i)
+      mWindow[i] = -.5f * cosf(FTWO_PI * i / mWindowSize) + .5f;
+
+   mOutputGain.assign(mHopSize, 0);
+   for (int i = 0; i < mWindowSize; ++i)
+      mOutputGain[i % mHopSize] += mWindow[i] * mWindow[i];
+   for (int i = 0; i < mHopSize; ++i)
+      mOutputGain[i] = mOutputGain[i] > 0 ? 1.0f / (mOutputGain[i] * mWindowSize) : 0;
+
+   mInputHistory.assign(numInputs, std::vector<float>(mWindowSize, 0));
+   mFrameInputs.assign(numInputs, std::vector<float>(mWindowSize, 0));
+   for (int i = 0; i < numInputs; ++i)
+   {
+      mFrames.push_back(std::make_unique<FFTData>(mWindowSize, mWindowSize / 2 + 1));
+      mFramePointers.push_back(mFrames.back().get());
+   }
+   mOutputAccum.assign(mWindowSize, 0);
+   mOutputQueue.assign(mHopSize, 0);
+   mFrameOutput.assign(mHopSize, 0);
+}
+
+STFT::STFT(ISpectralFrameProcessor* processor, int numInputs, int windowSize, int overlap)
+: mProcessor(processor)
+, mNumInputs(numInputs)
+, mRequestedWindowSize(windowSize)
+, mRequestedOverlap(overlap)
+, mLayout(std::make_unique<Layout>(numInputs, windowSize, overlap))
+{
+   mWindowSize = mLayout->mWindowSize;
+   mHopSize = mLayout->mHopSize;
+}
+
+STFT::~STFT()
+{
+   if (mHelper.joinable())
+   {
+      WaitForHelper(); //the frame in flight could still be using the processor
+      {
+         std::lock_guard<std::mutex> lock(mHelperMutex);
+         mExit = true;
+      }
+      mHelperCondition.notify_all();
+      mHelper.join();
+   }
+   delete mPendingLayout.exchange(nullptr);
+   DeleteRetiredLayouts();
+}
+
+void STFT::SetUp(int windowSize, int overlap)
+{
+   if (windowSize == mRequestedWindowSize && overlap == mRequestedOverlap)
+      return;
+   mRequestedWindowSize = windowSize;
+   mRequestedOverlap = overlap;
+
+   DeleteRetiredLayouts();
+   //replaces any layout the audio thread hasn't picked up yet
+   delete mPendingLayout.exchange(new Layout(mNumInputs, windowSize, overlap), std::memory_order_acq_rel);
+}
+
+void STFT::SetUseHelperThread(bool use)
+{
+   if (use && !mHelper.joinable())
+      mHelper = std::thread(&STFT::HelperLoop, this);
+   mUseHelperThread = use;
+}
+
+//audio thread. the old layout goes on a lock-free list for SetUp() or the destructor to delete
+void STFT::SwapInPendingLayout()
+{
+   Layout* pending = mPendingLayout.exchange(nullptr, std::memory_order_acq_rel);
+   if (pending == nullptr)
+      return;
+
+   WaitForHelper(); //the frame in flight is using the old one
+   mFrameInFlight = false;
+
+   Layout* old = mLayout.release();
+   mLayout.reset(pending);
+   mWindowSize = pending->mWindowSize;
+   mHopSize = pending->mHopSize;
+   mHopPosition = 0;
+
+   old->mNextRetired = mRetiredLayouts.load();
+   while (!mRetiredLayouts.compare_exchange_weak(old->mNextRetired, old))
+   {
+   }
+}
+
+void STFT::DeleteRetiredLayouts()
+{
+   for (Layout* retired = mRetiredLayouts.exchange(nullptr); retired != nullptr;)
+   {
+      Layout* next = retired->mNextRetired;
+      delete retired;
+      retired = next;
+   }
+}
+
+void STFT::Process(const float* const* inputs, float* output, int numSamples)
+{
+   SwapInPendingLayout();
+
+   Layout& layout = *mLayout;
+   const int windowSize = layout.mWindowSize;
+   const int hopSize = layout.mHopSize;
+   int pos = 0;
+   while (pos < numSamples)
+   {
+      int length = std::min(numSamples - pos, hopSize - mHopPosition);
+      for (int i = 0; i < mNumInputs; ++i)
+         std::copy(inputs[i] + pos, inputs[i] + pos + length, layout.mInputHistory[i].begin() + (windowSize - hopSize + mHopPosition));
+      std::copy(layout.mOutputQueue.begin() + mHopPosition, layout.mOutputQueue.begin() + mHopPosition + length, output + pos);
+
+      mHopPosition += length;
+      pos += length;
+
+      if (mHopPosition == hopSize)
+      {
+         FinishHop();
+         mHopPosition = 0;
+      }
+   }
+}
+
+//a full hop of new input has arrived: start the next frame and fill mOutputQueue with the next hop to play
+void STFT::FinishHop()
+{
+   Layout& layout = *mLayout;
+   bool useHelper = mUseHelperThread;
+
+   if (mFrameInFlight)
+   {
+      WaitForHelper();
+      layout.mOutputQueue = layout.mFrameOutput;
+      mFrameInFlight = false;
+   }
+   else if (useHelper)
+   {
+      //just switched over, so there's nothing ready yet
+      std::fill(layout.mOutputQueue.begin(), layout.mOutputQueue.end(), 0.0f);
+   }
+
+   for (int i = 0; i < mNumInputs; ++i)
+   {
+      layout.mFrameInputs[i] = layout.mInputHistory[i];
+      std::copy(layout.mInputHistory[i].begin() + layout.mHopSize, layout.mInputHistory[i].end(), layout.mInputHistory[i].begin());
+   }
+
+   if (useHelper)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mHelperMutex);
+         mFramePending = true;
+      }
+      mHelperCondition.notify_all();
+      mFrameInFlight = true;
+   }
+   else
+   {
+      RunFrame();
+      layout.mOutputQueue = layout.mFrameOutput;
+   }
+}
+
+void STFT::RunFrame()
+{
+   Layout& layout = *mLayout;
+   const int windowSize = layout.mWindowSize;
+   const int hopSize = layout.mHopSize;
+   for (int i = 0; i < mNumInputs; ++i)
+   {
+      FFTData* frame = layout.mFrames[i].get();
+      for (int j = 0; j < windowSize; ++j)
+         frame->mTimeDomain[j] = layout.mFrameInputs[i][j] * layout.mWindow[j];
+      layout.mFFT->Forward(frame->mTimeDomain, frame->mRealValues, frame->mImaginaryValues);
+   }
+
+   mProcessor->ProcessSpectralFrame(layout.mFramePointers.data(), mNumInputs);
+
+   FFTData* result = layout.mFrames[0].get();
+   layout.mFFT->Inverse(result->mRealValues, result->mImaginaryValues, result->mTimeDomain);
+   for (int j = 0; j < windowSize; ++j)
+      layout.mOutputAccum[j] += result->mTimeDomain[j] * layout.mWindow[j];
+
+   for (int j = 0; j < hopSize; ++j)
+      layout.mFrameOutput[j] = layout.mOutputAccum[j] * layout.mOutputGain[j];
+   std::copy(layout.mOutputAccum.begin() + hopSize, layout.mOutputAccum.end(), layout.mOutputAccum.begin());
+   std::fill(layout.mOutputAccum.end() - hopSize, layout.mOutputAccum.end(), 0.0f);
+}
+
+void STFT::WaitForHelper()
+{
+   std::unique_lock<std::mutex> lock(mHelperMutex);
+   mHelperCondition.wait(lock, [this]
+                         { return !mFramePending; });
+}
+
+void STFT::HelperLoop()
+{
+   while (true)
+   {
+      {
+         std::unique_lock<std::mutex> lock(mHelperMutex);
+         mHelperCondition.wait(lock, [this]
+                               { return mFramePending || mExit; });
+         if (mExit)
+            return;
+      }
+
+      RunFrame();
+
+      {
+         std::lock_guard<std::mutex> lock(mHelperMutex);
+         mFramePending = false;
+      }
+      mHelperCondition.notify_all();
+   }
+}
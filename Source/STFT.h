@@ -0,0 +1,115 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  STFT.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include "FFT.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ISpectralFrameProcessor
+{
+public:
+   virtual ~ISpectralFrameProcessor() {}
+   //frames[i] holds the spectrum of input i. whatever is left in frames[0] gets resynthesized
+   virtual void ProcessSpectralFrame(FFTData* const* frames, int numInputs) = 0;
+};
+
+//short-time fourier transform stage with its own window and hop size, so the spectral work happens once a hop instead of once a
+//buffer. every hop it hands the hann-windowed spectra of the last window of input to the processor, then overlap-adds the
+//resynthesized result, normalized so that an untouched spectrum comes back out at unity gain.
+//the output trails the input by one window. on the helper thread each frame gets a whole hop to finish, for one more hop of delay
+class STFT
+{
+public:
+   STFT(ISpectralFrameProcessor* processor, int numInputs, int windowSize, int overlap);
+   ~STFT();
+
+   //not for the audio thread. the new buffers are built here and picked up at the start of the next Process()
+   void SetUp(int windowSize, int overlap);
+   //not for the audio thread. starts the helper thread the first time it's turned on
+   void SetUseHelperThread(bool use);
+
+   int GetWindowSize() const { return mWindowSize; }
+   int GetHopSize() const { return mHopSize; }
+   int GetLatency() const { return mWindowSize + (mUseHelperThread ? mHopSize.load() : 0); }
+
+   //inputs holds numInputs channels of numSamples each. output gets numSamples of resynthesized audio
+   void Process(const float* const* inputs, float* output, int numSamples);
+
+private:
+   //everything sized by the window and hop
+   struct Layout
+   {
+      Layout(int numInputs, int windowSize, int overlap);
+
+      int mWindowSize{ 0 };
+      int mHopSize{ 0 };
+      std::unique_ptr<::FFT> mFFT;
+      std::vector<float> mWindow;
+      std::vector<float> mOutputGain; //per position within a hop: 1 / (nfft * the summed squared windows that overlap there)
+      std::vector<std::vector<float> > mInputHistory; //the last window of each input, newest at the end
+      std::vector<float> mOutputQueue; //the hop currently being played out
+
+      //frame state, only touched by whoever is running the frame
+      std::vector<std::vector<float> > mFrameInputs;
+      std::vector<std::unique_ptr<FFTData> > mFrames;
+      std::vector<FFTData*> mFramePointers;
+      std::vector<float> mOutputAccum;
+      std::vector<float> mFrameOutput;
+
+      Layout* mNextRetired{ nullptr }; //for mRetiredLayouts
+   };
+
+   void SwapInPendingLayout();
+   void DeleteRetiredLayouts();
+   void FinishHop();
+   void RunFrame();
+   void WaitForHelper();
+   void HelperLoop();
+
+   ISpectralFrameProcessor* mProcessor{ nullptr };
+   int mNumInputs{ 1 };
+   int mRequestedWindowSize{ 0 };
+   int mRequestedOverlap{ 0 };
+   std::atomic<int> mWindowSize{ 0 };
+   std::atomic<int> mHopSize{ 0 };
+   std::atomic<bool> mUseHelperThread{ false };
+
+   std::unique_ptr<Layout> mLayout; //the audio thread's, and the helper's while a frame is in flight
+   std::atomic<Layout*> mPendingLayout{ nullptr }; //from SetUp(), for the audio thread to swap in
+   std::atomic<Layout*> mRetiredLayouts{ nullptr }; //swapped out by the audio thread, for SetUp() to delete
+   int mHopPosition{ 0 };
+
+   std::thread mHelper;
+   std::mutex mHelperMutex;
+   std::condition_variable mHelperCondition;
+   bool mFramePending{ false };
+   bool mFrameInFlight{ false };
+   bool mExit{ false };
+};
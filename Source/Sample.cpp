@@ -28,20 +28,140 @@
 #include "FileStream.h"
 #include "ModularSynth.h"
 #include "ChannelBuffer.h"
+#include "Profiler.h"
+#include "UserPrefs.h"
+#include <algorithm>
 #include <memory>
+#include <mutex>
 
 #include "juce_audio_formats/juce_audio_formats.h"
 
+namespace
+{
+   const int kReadChunkSize = 1 << 16;
+   const int kMinStreamHeadLength = 4096;
+   const double kStreamHeadSeconds = 2;
+   const double kStreamWindowSeconds = 8;
+
+   //every live sample, so CollectAllGarbage() can reach them. never freed, since samples can outlive static destruction
+   struct LiveSamples
+   {
+      std::mutex mMutex;
+      std::vector<Sample*> mSamples;
+   };
+   LiveSamples& GetLiveSamples()
+   {
+      static LiveSamples* sLiveSamples = new LiveSamples();
+      return *sLiveSamples;
+   }
+}
+
+//allocates the channels up front, so the audio thread never ends up doing it through GetChannel()
+Sample::Content::Content(int length, int numChannels)
+: mData(std::make_unique<ChannelBuffer>(length))
+, mNumSamples(length)
+{
+   mData->SetNumActiveChannels(numChannels);
+   for (int ch = 0; ch < mData->NumActiveChannels(); ++ch)
+      mData->GetChannel(ch);
+}
+
+//takes mData's pointers back out of the mapping before it's unmapped, so mData never tries to delete them
+Sample::Content::~Content()
+{
+   if (mCached != nullptr)
+   {
+      for (int ch = 0; ch < mCached->GetNumChannels(); ++ch)
+         mData->SetChannelPointer(nullptr, ch, false);
+   }
+}
+
 Sample::Sample()
 {
+   mInterpolationQuality = Resampler::GetQualityForName(UserPrefs.sample_interpolation.Get());
+   mContent.Publish(std::make_unique<Content>(0, 1));
+
+   LiveSamples& liveSamples = GetLiveSamples();
+   std::lock_guard<std::mutex> lock(liveSamples.mMutex);
+   liveSamples.mSamples.push_back(this);
 }
 
 Sample::~Sample()
 {
+   {
+      LiveSamples& liveSamples = GetLiveSamples();
+      std::lock_guard<std::mutex> lock(liveSamples.mMutex);
+      liveSamples.mSamples.erase(std::remove(liveSamples.mSamples.begin(), liveSamples.mSamples.end(), this), liveSamples.mSamples.end());
+   }
+
+   stopTimer();
+   for (Content* retired = mRetiredOnAudioThread.exchange(nullptr); retired != nullptr;)
+   {
+      Content* next = retired->mNextRetired;
+      delete retired;
+      retired = next;
+   }
+}
+
+//swaps in new data for the audio thread without waiting on it, since the caller might hold a lock the audio thread is
+//after. the old data is freed by a later CollectGarbage(), once the audio thread is past any buffer that could have
+//been reading it and nobody else is holding LockDataMutex()
+void Sample::Publish(std::unique_ptr<Content> content)
+{
+   if (IsAudioThread())
+   {
+      uint64_t publishedAt = AudioThreadEpoch::GetCompletedBuffers();
+      //the publisher's retired list is behind a lock, so the old data goes on our own lock-free list instead,
+      //for the next CollectGarbage() to hand over
+      Content* old = mContent.Swap(std::move(content)).release();
+      if (old != nullptr)
+      {
+         old->mRetiredAt = publishedAt;
+         old->mNextRetired = mRetiredOnAudioThread.load();
+         while (!mRetiredOnAudioThread.compare_exchange_weak(old->mNextRetired, old))
+         {
+         }
+      }
+      return;
+   }
+
+   mContent.Publish(std::move(content));
+   CollectGarbage();
+}
+
+//non-audio threads
+void Sample::CollectGarbage()
+{
+   for (Content* retired = mRetiredOnAudioThread.exchange(nullptr); retired != nullptr;)
+   {
+      Content* next = retired->mNextRetired;
+      mContent.Retire(std::unique_ptr<Content>(retired), retired->mRetiredAt);
+      retired = next;
+   }
+
+   //someone holding onto Data() gets to keep it until a later pass
+   if (mDataMutex.try_lock())
+   {
+      mContent.CollectGarbage();
+      mDataMutex.unlock();
+   }
+}
+
+//static
+void Sample::CollectAllGarbage()
+{
+   LiveSamples& liveSamples = GetLiveSamples();
+   std::lock_guard<std::mutex> lock(liveSamples.mMutex);
+   for (auto* sample : liveSamples.mSamples)
+      sample->CollectGarbage();
 }
 
 bool Sample::Read(const char* path, bool mono, ReadType readType)
 {
+   PROFILER(Sample_Read);
+
+   stopTimer();
+   mSamplesLeftToRead = 0;
    mReadPath = path;
    ofStringReplace(mReadPath, GetPathSeparator(), "/");
    std::vector<std::string> tokens = ofSplitString(mReadPath, "/");
@@ -49,36 +169,65 @@ bool Sample::Read(const char* path, bool mono, ReadType readType)
 
    juce::File file(ofToDataPath(mReadPath));
    delete mReader;
+   mReader = nullptr;
+
+   //decoded before, by us or anyone else
+   auto cached = SampleCache::Get().Acquire(file, mono);
+   if (cached != nullptr && readType == ReadType::Stream && int64_t(cached->GetNumSamples()) * cached->GetNumChannels() * sizeof(float) > GetMemoryLimit())
+      cached.reset(); //still stream it, so it keeps saving as a path
+   if (cached != nullptr)
+   {
+      auto content = std::make_unique<Content>(0, 1);
+      AdoptMapping(content.get(), std::move(cached));
+      int numSamples = content->mNumSamples;
+      Publish(std::move(content));
+      SetPlayPosition(numSamples);
+      return true;
+   }
+
    mReader = TheSynth->GetAudioFormatManager().createReaderFor(file);
 
    if (mReader != nullptr)
    {
-      mData.Resize((int)mReader->lengthInSamples);
-      if (mono)
-         mData.SetNumActiveChannels(1);
-      else
-         mData.SetNumActiveChannels(mReader->numChannels);
-      mData.Clear();
+      int numSamples = (int)mReader->lengthInSamples;
+      int sampleRate = (int)mReader->sampleRate; //OpenStream() hands mReader over to the stream
+      std::unique_ptr<Content> content;
+      if (readType == ReadType::Stream)
+         content = std::make_unique<Content>(0, 1);
+      if (content == nullptr || !OpenStream(content.get(), mono))
+         content = std::make_unique<Content>(numSamples, mono ? 1 : (int)mReader->numChannels);
+      content->mNumSamples = numSamples;
+      content->mOriginalSampleRate = sampleRate;
+      content->mSampleRateRatio = float(content->mOriginalSampleRate) / gSampleRate;
+
+      if (content->mStream == nullptr)
+      {
+         content->mData->Clear();
+         mReadBuffer = std::make_unique<juce::AudioSampleBuffer>(mReader->numChannels, std::min(numSamples, kReadChunkSize));
 
-      mNumSamples = (int)mReader->lengthInSamples;
-      mOffset = mNumSamples;
-      mOriginalSampleRate = mReader->sampleRate;
-      mSampleRateRatio = float(mOriginalSampleRate) / gSampleRate;
+         if (readType == ReadType::Async)
+         {
+            //published straight away and filled in by the timer, so it can start playing while it loads
+            mSamplesLeftToRead = numSamples;
+            Publish(std::move(content));
+            SetPlayPosition(numSamples);
+            startTimer(100);
+            return true;
+         }
 
-      mReadBuffer = std::make_unique<juce::AudioSampleBuffer>();
-      mReadBuffer->setSize(mReader->numChannels, mNumSamples);
+         for (int pos = 0; pos < numSamples; pos += kReadChunkSize)
+            ReadChunk(content.get(), pos, std::min(kReadChunkSize, numSamples - pos));
+         mReadBuffer.reset();
 
-      if (readType == ReadType::Sync)
-      {
-         mReader->read(mReadBuffer.get(), 0, mNumSamples, 0, true, true);
-         FinishRead();
-      }
-      else if (readType == ReadType::Async)
-      {
-         mSamplesLeftToRead = mNumSamples;
-         startTimer(100);
+         //trade our copy for a mapping of the cached one, which the next load of this file will share.
+         //async loads are left alone, they can already be playing by the time they finish
+         auto stored = SampleCache::Get().Store(file, mono, content->mData.get(), numSamples, content->mOriginalSampleRate);
+         if (stored != nullptr)
+            AdoptMapping(content.get(), std::move(stored));
       }
 
+      Publish(std::move(content));
+      SetPlayPosition(numSamples);
       return true;
    }
    else
@@ -89,73 +238,198 @@ bool Sample::Read(const char* path, bool mono, ReadType readType)
    return false;
 }
 
-void Sample::FinishRead()
+//reads [start, start + length) of the file through mReadBuffer into the same place in the content's data
+void Sample::ReadChunk(Content* content, int start, int length)
 {
-   if (mData.NumActiveChannels() == 1 && mReadBuffer->getNumChannels() > 1)
+   ChannelBuffer* data = content->mData.get();
+   mReader->read(mReadBuffer.get(), 0, length, start, true, true);
+   if (data->NumActiveChannels() == 1 && mReadBuffer->getNumChannels() > 1)
    {
-      BufferCopy(mData.GetChannel(0), mReadBuffer->getReadPointer(0), mReadBuffer->getNumSamples()); //put first channel in
+      float* dest = data->GetChannel(0) + start;
+      BufferCopy(dest, mReadBuffer->getReadPointer(0), length); //put first channel in
       for (int ch = 1; ch < mReadBuffer->getNumChannels(); ++ch)
-         Add(mData.GetChannel(0), mReadBuffer->getReadPointer(ch), mReadBuffer->getNumSamples()); //add the other channels
-      Mult(mData.GetChannel(0), 1.0f / mReadBuffer->getNumChannels(), mReadBuffer->getNumSamples()); //normalize volume
+         Add(dest, mReadBuffer->getReadPointer(ch), length); //add the other channels
+      Mult(dest, 1.0f / mReadBuffer->getNumChannels(), length); //normalize volume
    }
    else
    {
-      for (int ch = 0; ch < mReadBuffer->getNumChannels(); ++ch)
-         BufferCopy(mData.GetChannel(ch), mReadBuffer->getReadPointer(ch), mReadBuffer->getNumSamples());
+      for (int ch = 0; ch < data->NumActiveChannels(); ++ch)
+         BufferCopy(data->GetChannel(ch) + start, mReadBuffer->getReadPointer(ch), length);
    }
 }
 
+int64_t Sample::GetMemoryLimit() const
+{
+   return mMemoryLimit >= 0 ? mMemoryLimit : int64_t(UserPrefs.sample_memory_limit_mb.Get()) * 1024 * 1024;
+}
+
+//keeps the first couple of seconds in the content's data and hands the reader over to a SampleStream for the rest.
+//returns false if the file is small enough to just load
+bool Sample::OpenStream(Content* content, bool mono)
+{
+   int numSamples = (int)mReader->lengthInSamples;
+   int numChannels = mono ? 1 : std::min((int)mReader->numChannels, ChannelBuffer::kMaxNumChannels);
+   int64_t limit = GetMemoryLimit();
+   int64_t bytesPerFrame = sizeof(float) * numChannels;
+   if (int64_t(numSamples) * bytesPerFrame <= limit)
+      return false;
+
+   //a fifth of the budget for the head, the rest for the window, up to a few seconds each
+   int64_t budgetFrames = limit / bytesPerFrame;
+   int headLength = (int)std::min<int64_t>(budgetFrames / 5, int64_t(kStreamHeadSeconds * mReader->sampleRate));
+   headLength = std::min(std::max(headLength, kMinStreamHeadLength), numSamples);
+   int capacity = (int)std::min<int64_t>(budgetFrames - headLength, int64_t(kStreamWindowSeconds * mReader->sampleRate));
+
+   content->mData = std::make_unique<ChannelBuffer>(headLength);
+   content->mData->SetNumActiveChannels(numChannels);
+   content->mData->Clear();
+   mReadBuffer = std::make_unique<juce::AudioSampleBuffer>(mReader->numChannels, std::min(headLength, kReadChunkSize));
+   for (int pos = 0; pos < headLength; pos += kReadChunkSize)
+      ReadChunk(content, pos, std::min(kReadChunkSize, headLength - pos));
+   mReadBuffer.reset();
+
+   content->mStream = std::make_unique<SampleStream>(std::unique_ptr<juce::AudioFormatReader>(mReader), mono, headLength, capacity);
+   mReader = nullptr;
+   return true;
+}
+
+//points the content's data at the mapping. the pages are copy-on-write, so anything that edits Data() afterwards is safe
+void Sample::AdoptMapping(Content* content, std::unique_ptr<SampleCache::Mapping> mapping)
+{
+   content->mNumSamples = mapping->GetNumSamples();
+   content->mOriginalSampleRate = mapping->GetSampleRate();
+   content->mSampleRateRatio = float(content->mOriginalSampleRate) / gSampleRate;
+   content->mData = std::make_unique<ChannelBuffer>(content->mNumSamples);
+   content->mData->SetNumActiveChannels(mapping->GetNumChannels());
+   for (int ch = 0; ch < mapping->GetNumChannels(); ++ch)
+      content->mData->SetChannelPointer(mapping->GetChannel(ch), ch, false);
+   content->mCached = std::move(mapping);
+}
+
+bool Sample::IsSampleLoading()
+{
+   const Content* content = mContent.Get();
+   return mSamplesLeftToRead > 0 || (content->mStream != nullptr && !content->mStream->IsOverviewDone());
+}
+
+float Sample::GetSampleLoadProgress()
+{
+   const Content* content = mContent.Get();
+   if (content->mStream != nullptr)
+      return content->mStream->GetOverviewProgress();
+   return (content->mNumSamples > 0) ? (1 - (float(mSamplesLeftToRead) / content->mNumSamples)) : 1;
+}
+
+void Sample::ReadFrames(int start, int length, ChannelBuffer* dest)
+{
+   const Content* content = mContent.Get();
+   if (content->mStream != nullptr)
+   {
+      content->mStream->ReadFrames(start, length, dest);
+      return;
+   }
+
+   for (int ch = 0; ch < dest->NumActiveChannels(); ++ch)
+      BufferCopy(dest->GetChannel(ch), content->mData->GetChannel(MIN(ch, content->mData->NumActiveChannels() - 1)) + start, length);
+}
+
+ChannelBuffer* Sample::GetDrawData(int& framesPerPoint)
+{
+   const Content* content = mContent.Get();
+   if (content->mStream != nullptr)
+   {
+      framesPerPoint = SampleStream::kOverviewStep;
+      return content->mStream->GetOverview();
+   }
+   framesPerPoint = 1;
+   return content->mData.get();
+}
+
 //juce::Timer
 void Sample::timerCallback()
 {
+   //fills in the content Read() already published
+   Content* content = const_cast<Content*>(mContent.Get());
    int samplesToRead = 44100 * 10;
    if (samplesToRead > mSamplesLeftToRead)
       samplesToRead = mSamplesLeftToRead;
-   int startSample = mNumSamples - mSamplesLeftToRead;
-   mReader->read(mReadBuffer.get(), startSample, samplesToRead, startSample, true, true);
+   int startSample = content->mNumSamples - mSamplesLeftToRead;
+   for (int pos = 0; pos < samplesToRead; pos += kReadChunkSize)
+      ReadChunk(content, startSample + pos, std::min(kReadChunkSize, samplesToRead - pos));
    mSamplesLeftToRead -= samplesToRead;
 
    if (mSamplesLeftToRead <= 0)
    {
-      FinishRead();
+      mReadBuffer.reset();
       stopTimer();
    }
 }
 
 void Sample::Create(int length)
 {
-   mData.Resize(length);
-   mData.SetNumActiveChannels(1);
-   Setup(length);
+   stopTimer();
+   mSamplesLeftToRead = 0;
+   auto content = std::make_unique<Content>(length, 1);
+   content->mData->Clear();
+   Publish(std::move(content));
+   Setup();
 }
 
 void Sample::Create(ChannelBuffer* data)
 {
+   stopTimer();
+   mSamplesLeftToRead = 0;
    int channels = data->NumActiveChannels();
    int length = data->BufferSize();
-   mData.Resize(length);
-   mData.SetNumActiveChannels(channels);
+   auto content = std::make_unique<Content>(length, channels);
    for (int ch = 0; ch < channels; ++ch)
-      BufferCopy(mData.GetChannel(ch), data->GetChannel(ch), length);
-   Setup(length);
+      BufferCopy(content->mData->GetChannel(ch), data->GetChannel(ch), length);
+   Publish(std::move(content));
+   Setup();
 }
 
-void Sample::Setup(int length)
+void Sample::Setup()
 {
-   mNumSamples = length;
-   mRate = 1;
-   mOffset = length;
-   mOriginalSampleRate = gSampleRate;
-   mSampleRateRatio = 1;
-   mStopPoint = -1;
+   SetRate(1);
+   SetPlayPosition(LengthInSamples());
+   ClearStopPoint();
    mName = "newsample";
    mReadPath = "";
 }
 
 bool Sample::Write(const char* path /*=nullptr*/)
 {
+   const Content* content = mContent.Get();
    const std::string writeTo = path ? path : mReadPath;
-   WriteDataToFile(writeTo, &mData, mNumSamples);
+   if (content->mStream != nullptr)
+   {
+      if (writeTo == mReadPath)
+         return false; //we'd be reading from the file we're writing over
+
+      //a chunk at a time, so it never has to all be in memory
+      auto wavFormat = std::make_unique<juce::WavAudioFormat>();
+      juce::File outputFile(ofToDataPath(writeTo));
+      outputFile.create();
+      auto outputTo = outputFile.createOutputStream();
+      if (outputTo == nullptr)
+         return false;
+      auto writer = std::unique_ptr<juce::AudioFormatWriter>(
+      wavFormat->createWriterFor(outputTo.release(), gSampleRate, NumChannels(), 16, {}, 0));
+      ChannelBuffer chunk(kReadChunkSize);
+      chunk.SetNumActiveChannels(NumChannels());
+      std::vector<const float*> channels(NumChannels());
+      for (int pos = 0; pos < content->mNumSamples; pos += kReadChunkSize)
+      {
+         int length = std::min(kReadChunkSize, content->mNumSamples - pos);
+         content->mStream->ReadFrames(pos, length, &chunk);
+         for (int ch = 0; ch < NumChannels(); ++ch)
+            channels[ch] = chunk.GetChannel(ch);
+         writer->writeFromFloatArrays(channels.data(), NumChannels(), length);
+      }
+      return true;
+   }
+
+   WriteDataToFile(writeTo, content->mData.get(), content->mNumSamples);
    return true;
 }
 
@@ -189,72 +463,225 @@ bool Sample::WriteDataToFile(const std::string& path, ChannelBuffer* data, int n
 
 void Sample::Play(double startTime, float rate /*=1*/, int offset /*=0*/, int stopPoint /*=-1*/)
 {
-   mPlayMutex.lock();
-   mStartTime = startTime;
-   mOffset = offset;
-   mRate = rate;
-   if (stopPoint != -1)
-      SetStopPoint(stopPoint);
-   else
-      ClearStopPoint();
-   mPlayMutex.unlock();
+   PlayCommand command;
+   command.mType = PlayCommand::Type::Play;
+   command.mStartTime = startTime;
+   command.mOffset = offset;
+   command.mRate = rate;
+   command.mStopPoint = stopPoint;
+   Post(command);
+}
+
+void Sample::SetRate(float rate)
+{
+   PlayCommand command;
+   command.mType = PlayCommand::Type::SetRate;
+   command.mRate = rate;
+   Post(command);
+}
+
+void Sample::SetPlayPosition(double sample)
+{
+   PlayCommand command;
+   command.mType = PlayCommand::Type::SetPosition;
+   command.mOffset = sample;
+   Post(command);
+}
+
+void Sample::SetStopPoint(int stopPoint)
+{
+   PlayCommand command;
+   command.mType = PlayCommand::Type::SetStopPoint;
+   command.mStopPoint = stopPoint;
+   Post(command);
+}
+
+//the audio thread applies its own changes straight away, after anything that was queued ahead of them.
+//everyone else queues them up for the next ConsumeData()
+void Sample::Post(const PlayCommand& command)
+{
+   if (IsAudioThread())
+   {
+      ApplyPendingCommands();
+      Apply(command);
+      return;
+   }
+
+   std::lock_guard<std::mutex> lock(mPlayCommandsMutex);
+   if (command.mType == PlayCommand::Type::Play)
+      ++mNumPendingPlays;
+   mPlayCommands.produce(command);
+}
+
+void Sample::ApplyPendingCommands()
+{
+   PlayCommand command;
+   while (mPlayCommands.consume(command))
+   {
+      Apply(command);
+      if (command.mType == PlayCommand::Type::Play)
+         --mNumPendingPlays;
+   }
+}
+
+void Sample::Apply(const PlayCommand& command)
+{
+   switch (command.mType)
+   {
+      case PlayCommand::Type::Play:
+         mStartTime = command.mStartTime;
+         mOffset = command.mOffset;
+         mRate = command.mRate;
+         mStopPoint = command.mStopPoint;
+         break;
+      case PlayCommand::Type::SetPosition:
+         mOffset = command.mOffset;
+         break;
+      case PlayCommand::Type::SetRate:
+         mRate = command.mRate;
+         break;
+      case PlayCommand::Type::SetStopPoint:
+         mStopPoint = command.mStopPoint;
+         break;
+   }
 }
 
 bool Sample::ConsumeData(double time, ChannelBuffer* out, int size, bool replace)
 {
    assert(size <= out->BufferSize());
 
-   mPlayMutex.lock();
-   float end = mNumSamples;
+   ApplyPendingCommands();
+
+   const Content* content = mContent.Get();
+   SampleStream* stream = content->mStream.get();
+   ChannelBuffer* data = content->mData.get();
+   int numSamples = content->mNumSamples;
+   double step = mRate * content->mSampleRateRatio;
+
+   float end = numSamples;
    if (mStopPoint != -1)
       end = mStopPoint;
 
-   if (mLooping && mOffset >= mNumSamples)
-      mOffset -= mNumSamples;
+   if (mLooping && mOffset >= numSamples)
+      mOffset -= numSamples;
 
    if (mOffset >= end || mOffset != mOffset)
-   {
-      mPlayMutex.unlock();
       return false;
+
+   SampleStream::Window window;
+   int missedFrame = -1;
+   if (stream != nullptr)
+   {
+      window = stream->GetWindow();
+      //back in the head after a loop or a restart, so that covers us while the window moves to just past it
+      int headLength = data->BufferSize();
+      if (mOffset < headLength && (window.mStart > headLength || window.mEnd < headLength))
+         stream->RequestSeek(headLength);
    }
 
-   LockDataMutex(true);
-   for (int i = 0; i < size; ++i)
+   if (stream != nullptr)
    {
-      if (time < mStartTime)
+      for (int i = 0; i < size; ++i)
       {
-         if (replace)
+         if (time < mStartTime)
+         {
+            if (replace)
+            {
+               for (int ch = 0; ch < out->NumActiveChannels(); ++ch)
+                  out->GetChannel(ch)[i] = 0;
+            }
+         }
+         else
          {
             for (int ch = 0; ch < out->NumActiveChannels(); ++ch)
-               out->GetChannel(ch)[i] = 0;
+            {
+               int dataChannel = MIN(ch, data->NumActiveChannels() - 1);
+
+               float sample = 0;
+               if (mOffset < end || mLooping)
+                  sample = GetStreamedSample(content, mOffset, dataChannel, window, missedFrame) * mVolume;
+
+               if (replace)
+                  out->GetChannel(ch)[i] = sample;
+               else
+                  out->GetChannel(ch)[i] += sample;
+            }
+
+            mOffset += step;
          }
+         time += gInvSampleRateMs;
       }
-      else
+   }
+   else
+   {
+      //silent until mStartTime, then a block read up to the end, then silent again
+      int startFrame = 0;
+      while (startFrame < size && time + startFrame * gInvSampleRateMs < mStartTime)
+         ++startFrame;
+      int numFrames = size - startFrame;
+      int numPlayed = numFrames;
+      if (!mLooping && step > 0)
+         numPlayed = (int)std::min<double>(numFrames, ceil((end - mOffset) / step));
+
+      float* dest[ChannelBuffer::kMaxNumChannels];
+      const float* source[ChannelBuffer::kMaxNumChannels];
+      int numChannels = out->NumActiveChannels();
+      for (int ch = 0; ch < numChannels; ++ch)
       {
-         for (int ch = 0; ch < out->NumActiveChannels(); ++ch)
+         dest[ch] = out->GetChannel(ch);
+         if (replace)
          {
-            int dataChannel = MIN(ch, mData.NumActiveChannels() - 1);
-
-            float sample = 0;
-            if (mOffset < end || mLooping)
-               sample = GetInterpolatedSample(mOffset, mData.GetChannel(dataChannel), mNumSamples) * mVolume;
-
-            if (replace)
-               out->GetChannel(ch)[i] = sample;
-            else
-               out->GetChannel(ch)[i] += sample;
+            std::fill(dest[ch], dest[ch] + startFrame, 0.0f);
+            std::fill(dest[ch] + startFrame + numPlayed, dest[ch] + size, 0.0f);
          }
-
-         mOffset += mRate * mSampleRateRatio;
+         dest[ch] += startFrame;
       }
-      time += gInvSampleRateMs;
+      for (int ch = 0; ch < data->NumActiveChannels(); ++ch)
+         source[ch] = data->GetChannel(ch);
+
+      Resampler::Read(source, data->NumActiveChannels(), numSamples, mOffset, step, dest, numChannels, numPlayed, mInterpolationQuality, mVolume, !replace, mLooping);
+      mOffset += step * numFrames;
+   }
+
+   if (stream != nullptr)
+   {
+      //the window only moves forwards, so playing backwards keeps missing and asking for it to be moved back a chunk
+      bool forwards = step >= 0;
+      if (missedFrame != -1)
+         stream->RequestSeek(forwards ? missedFrame : missedFrame - stream->GetCapacity() / 2);
+      else if (forwards)
+         stream->Release(int(DoubleWrap(mOffset, numSamples)) - 1);
    }
-   LockDataMutex(false);
-   mPlayMutex.unlock();
 
    return true;
 }
 
+//like GetInterpolatedSample(), with frames past the head coming from the stream's window.
+//a frame that isn't there yet plays as silence and gets reported through missedFrame
+float Sample::GetStreamedSample(const Content* content, double offset, int channel, const SampleStream::Window& window, int& missedFrame)
+{
+   int numSamples = content->mNumSamples;
+   offset = DoubleWrap(offset, numSamples);
+   int pos = int(offset);
+   int posNext = (pos + 1) % numSamples;
+
+   const float* head = content->mData->GetChannel(channel);
+   int headLength = content->mData->BufferSize();
+   auto getFrame = [&](int frame)
+   {
+      if (frame < headLength)
+         return head[frame];
+      if (window.Contains(frame))
+         return content->mStream->GetSample(channel, frame);
+      if (missedFrame == -1)
+         missedFrame = frame;
+      return 0.0f;
+   };
+
+   float a = offset - pos;
+   return (1 - a) * getFrame(pos) + a * getFrame(posNext); //interpolate
+}
+
 void Sample::PadBack(int amount)
 {
    //TODO(Ryan)
@@ -300,36 +727,55 @@ void Sample::ShiftWrap(int numSamplesToShift)
 
 void Sample::CopyFrom(Sample* sample)
 {
-   mNumSamples = sample->mNumSamples;
-   if (mData.BufferSize() != sample->mData.BufferSize())
-      mData.Resize(sample->mNumSamples);
-   mData.CopyFrom(&sample->mData);
+   const Content* source = sample->mContent.Get();
+   if (source->mStream != nullptr)
+   {
+      //open our own stream of the same file rather than copying it into memory
+      mMemoryLimit = sample->mMemoryLimit;
+      Read(sample->mReadPath.c_str(), sample->NumChannels() == 1, ReadType::Stream);
+   }
+   else
+   {
+      stopTimer();
+      mSamplesLeftToRead = 0;
+      auto content = std::make_unique<Content>(source->mNumSamples, source->mData->NumActiveChannels());
+      content->mData->CopyFrom(source->mData.get());
+      for (int ch = 0; ch < content->mData->NumActiveChannels(); ++ch)
+         content->mData->GetChannel(ch); //CopyFrom() leaves silent channels unallocated
+      content->mOriginalSampleRate = source->mOriginalSampleRate;
+      content->mSampleRateRatio = source->mSampleRateRatio;
+      Publish(std::move(content));
+   }
    mNumBars = sample->mNumBars;
    mLooping = sample->mLooping;
-   mRate = sample->mRate;
-   mOriginalSampleRate = sample->mOriginalSampleRate;
-   mSampleRateRatio = sample->mSampleRateRatio;
-   mStopPoint = sample->mStopPoint;
+   SetRate(sample->mRate);
+   SetStopPoint(sample->mStopPoint);
    mName = sample->mName;
    mReadPath = sample->mReadPath;
 }
 
 namespace
 {
-   const int kSaveStateRev = 1;
+   const int kSaveStateRev = 3;
 }
 
 void Sample::SaveState(FileStreamOut& out)
 {
+   const Content* content = mContent.Get();
+
    out << kSaveStateRev;
 
-   out << mNumSamples;
-   if (mNumSamples > 0)
-      mData.Save(out, mNumSamples);
+   //a stream is saved as its path and reopened on load, rather than pulling the whole file into the save
+   bool streaming = content->mStream != nullptr;
+   out << streaming;
+   out << (streaming && content->mStream->IsMono());
+   out << (streaming ? 0 : content->mNumSamples);
+   if (!streaming && content->mNumSamples > 0)
+      content->mData->Save(out, content->mNumSamples);
    out << mNumBars;
    out << mLooping;
    out << mRate;
-   out << mOriginalSampleRate;
+   out << content->mOriginalSampleRate;
    out << mStopPoint;
    out << mName;
    out << mReadPath;
@@ -340,35 +786,56 @@ void Sample::LoadState(FileStreamIn& in)
    int rev;
    in >> rev;
 
-   in >> mNumSamples;
-   if (mNumSamples > 0)
+   bool streaming = false;
+   if (rev >= 2)
+      in >> streaming;
+   bool mono = false;
+   if (rev >= 3)
+      in >> mono;
+
+   stopTimer();
+   mSamplesLeftToRead = 0;
+   auto content = std::make_unique<Content>(0, 1);
+   in >> content->mNumSamples;
+   if (content->mNumSamples > 0)
    {
       int readLength;
-      mData.Load(in, readLength, ChannelBuffer::LoadMode::kSetBufferSize);
-      assert(readLength == mNumSamples);
-      /*for (int ch=0; ch<mData.NumActiveChannels(); ++ch)
-      {
-         float* channelBuffer = mData.GetChannel(ch);
-         for (int i=0; i<mData.BufferSize(); ++i)
-         {
-            assert(channelBuffer[i] >= -1 && channelBuffer[i] <= 1);
-         }
-      }*/
+      content->mData->Load(in, readLength, ChannelBuffer::LoadMode::kSetBufferSize);
+      assert(readLength == content->mNumSamples);
+      for (int ch = 0; ch < content->mData->NumActiveChannels(); ++ch)
+         content->mData->GetChannel(ch);
    }
    in >> mNumBars;
    in >> mLooping;
-   in >> mRate;
+   float rate;
+   in >> rate;
    if (rev == 0)
    {
-      in >> mSampleRateRatio;
-      mOriginalSampleRate = gSampleRate * mSampleRateRatio;
+      in >> content->mSampleRateRatio;
+      content->mOriginalSampleRate = gSampleRate * content->mSampleRateRatio;
    }
    else
    {
-      in >> mOriginalSampleRate;
-      mSampleRateRatio = float(mOriginalSampleRate) / gSampleRate;
+      in >> content->mOriginalSampleRate;
+      content->mSampleRateRatio = float(content->mOriginalSampleRate) / gSampleRate;
    }
-   in >> mStopPoint;
+   int stopPoint;
+   in >> stopPoint;
    in >> mName;
    in >> mReadPath;
+
+   if (streaming)
+   {
+      std::string name = mName;
+      Read(mReadPath.c_str(), mono, ReadType::Stream);
+      mName = name;
+   }
+   else
+   {
+      int length = content->mNumSamples;
+      Publish(std::move(content));
+      SetPlayPosition(length);
+   }
+   SetRate(rate);
+   SetStopPoint(stopPoint);
 }
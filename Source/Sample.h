@@ -28,6 +28,12 @@
 
 #include "OpenFrameworksPort.h"
 #include "ChannelBuffer.h"
+#include "LockFreeQueue.h"
+#include "Resampler.h"
+#include "SampleCache.h"
+#include "SampleStream.h"
+#include "SnapshotPublisher.h"
+#include <atomic>
 #include <limits>
 
 #include "juce_events/juce_events.h"
@@ -43,13 +49,16 @@ namespace juce
    using AudioSampleBuffer = AudioBuffer<float>;
 }
 
+//ConsumeData() never blocks. loading or replacing the data publishes it whole for the audio thread to pick up, and play
+//changes made off the audio thread are queued for its next ConsumeData(), so neither waits on the other
 class Sample : public juce::Timer
 {
 public:
    enum class ReadType
    {
       Sync,
-      Async
+      Async,
+      Stream //plays from disk if the decoded file would be bigger than the memory limit, otherwise same as Sync
    };
 
    Sample();
@@ -58,64 +67,118 @@ public:
    bool Write(const char* path = nullptr); //no path = use read filename
    bool ConsumeData(double time, ChannelBuffer* out, int size, bool replace);
    void Play(double time, float rate, int offset, int stopPoint = -1);
-   void SetRate(float rate) { mRate = rate; }
+   void SetRate(float rate);
    std::string Name() const { return mName; }
    void SetName(std::string name) { mName = name; }
-   int LengthInSamples() const { return mNumSamples; }
-   int NumChannels() const { return mData.NumActiveChannels(); }
-   ChannelBuffer* Data() { return &mData; }
+   int LengthInSamples() const { return mContent.Get()->mNumSamples; }
+   int NumChannels() const { return mContent.Get()->mData->NumActiveChannels(); }
+   ChannelBuffer* Data() { return mContent.Get()->mData.get(); } //only the first few seconds when streaming, see ReadFrames()
+   bool IsStreaming() const { return mContent.Get()->mStream != nullptr; }
+   void ReadFrames(int start, int length, ChannelBuffer* dest); //works whether or not the sample is streaming
+   ChannelBuffer* GetDrawData(int& framesPerPoint); //a cheap overview for streams, otherwise Data()
+   void SetMemoryLimit(int64_t bytes) { mMemoryLimit = bytes; } //below zero uses the sample_memory_limit_mb pref
    double GetPlayPosition() const { return mOffset; }
-   void SetPlayPosition(double sample) { mOffset = sample; }
-   float GetSampleRateRatio() const { return mSampleRateRatio; }
-   void Reset() { mOffset = mNumSamples; }
-   void SetStopPoint(int stopPoint) { mStopPoint = stopPoint; }
-   void ClearStopPoint() { mStopPoint = -1; }
+   void SetPlayPosition(double sample);
+   float GetSampleRateRatio() const { return mContent.Get()->mSampleRateRatio; }
+   void Reset() { SetPlayPosition(LengthInSamples()); }
+   void SetStopPoint(int stopPoint);
+   void ClearStopPoint() { SetStopPoint(-1); }
    void PadBack(int amount);
    void ClipTo(int start, int end);
    void ShiftWrap(int numSamples);
    std::string GetReadPath() const { return mReadPath; }
    static bool WriteDataToFile(const std::string& path, float** data, int numSamples, int channels = 1);
    static bool WriteDataToFile(const std::string& path, ChannelBuffer* data, int numSamples);
-   bool IsPlaying() { return mOffset < mNumSamples; }
-   void LockDataMutex(bool lock) { lock ? mDataMutex.lock() : mDataMutex.unlock(); }
+   bool IsPlaying() { return mNumPendingPlays > 0 || mOffset < LengthInSamples(); }
+   void LockDataMutex(bool lock) { lock ? mDataMutex.lock() : mDataMutex.unlock(); } //for holding onto Data() off the audio thread, which never takes this
    void Create(int length);
    void Create(ChannelBuffer* data);
    void SetLooping(bool looping) { mLooping = looping; }
    void SetNumBars(int numBars) { mNumBars = numBars; }
    int GetNumBars() const { return mNumBars; }
    void SetVolume(float vol) { mVolume = vol; }
+   void SetInterpolationQuality(Resampler::Quality quality) { mInterpolationQuality = quality; } //defaults to the sample_interpolation pref
    void CopyFrom(Sample* sample);
-   bool IsSampleLoading() { return mSamplesLeftToRead > 0; }
-   float GetSampleLoadProgress() { return (mNumSamples > 0) ? (1 - (float(mSamplesLeftToRead) / mNumSamples)) : 1; }
+   bool IsSampleLoading();
+   float GetSampleLoadProgress();
 
    void SaveState(FileStreamOut& out);
    void LoadState(FileStreamIn& in);
 
+   //main thread, from ModularSynth::Poll(). frees replaced data that the audio thread is done with, for every sample
+   static void CollectAllGarbage();
+
 private:
-   void Setup(int length);
-   void FinishRead();
+   //everything loaded from a file or handed to Create(), swapped as a whole so the audio thread never sees half of it.
+   //the samples themselves can still be edited in place through Data()
+   struct Content
+   {
+      Content(int length, int numChannels);
+      ~Content();
+
+      std::unique_ptr<ChannelBuffer> mData;
+      int mNumSamples{ 0 };
+      int mOriginalSampleRate{ gSampleRate };
+      float mSampleRateRatio{ 1 };
+      std::unique_ptr<SampleStream> mStream;
+      std::unique_ptr<SampleCache::Mapping> mCached; //when set, mData's channels point into it
+      Content* mNextRetired{ nullptr }; //for mRetiredOnAudioThread
+      uint64_t mRetiredAt{ 0 };
+   };
+
+   struct PlayCommand
+   {
+      enum class Type
+      {
+         Play,
+         SetPosition,
+         SetRate,
+         SetStopPoint
+      };
+
+      Type mType{ Type::Play };
+      double mStartTime{ 0 };
+      double mOffset{ 0 };
+      float mRate{ 1 };
+      int mStopPoint{ -1 };
+   };
+
+   void Publish(std::unique_ptr<Content> content);
+   void CollectGarbage();
+   void Setup();
+   void ReadChunk(Content* content, int start, int length);
+   int64_t GetMemoryLimit() const;
+   bool OpenStream(Content* content, bool mono);
+   void AdoptMapping(Content* content, std::unique_ptr<SampleCache::Mapping> mapping);
+   float GetStreamedSample(const Content* content, double offset, int channel, const SampleStream::Window& window, int& missedFrame);
+   void Post(const PlayCommand& command);
+   void ApplyPendingCommands();
+   void Apply(const PlayCommand& command);
    //juce::Timer
    void timerCallback();
 
-   ChannelBuffer mData{ 0 };
-   int mNumSamples{ 0 };
+   SnapshotPublisher<Content> mContent;
+   std::atomic<Content*> mRetiredOnAudioThread{ nullptr }; //replaced by a Publish() on the audio thread, not yet retired
    double mStartTime{ 0 };
    double mOffset{ std::numeric_limits<double>::max() };
    float mRate{ 1 };
-   int mOriginalSampleRate{ gSampleRate };
-   float mSampleRateRatio{ 1 };
    int mStopPoint{ -1 };
    std::string mName{ "" };
    std::string mReadPath{ "" };
    ofMutex mDataMutex;
-   ofMutex mPlayMutex;
    bool mLooping{ false };
    int mNumBars{ -1 };
    float mVolume{ 1 };
+   Resampler::Quality mInterpolationQuality{ Resampler::Quality::Sinc16 };
+
+   LockFreeQueue<PlayCommand> mPlayCommands;
+   std::mutex mPlayCommandsMutex; //one producer at a time, never taken by the audio thread
+   std::atomic<int> mNumPendingPlays{ 0 }; //so IsPlaying() is true as soon as Play() returns
 
    juce::AudioFormatReader* mReader{};
-   std::unique_ptr<juce::AudioSampleBuffer> mReadBuffer;
+   std::unique_ptr<juce::AudioSampleBuffer> mReadBuffer; //one chunk at a time, so a load never holds two copies of the file
    int mSamplesLeftToRead{ 0 };
+   int64_t mMemoryLimit{ -1 };
 };
 
 #endif /* defined(__modularSynth__Sample__) */
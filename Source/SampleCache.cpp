@@ -0,0 +1,297 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SampleCache.cpp
+//  Bespoke
+//
+//
+
+#include "SampleCache.h"
+#include "ChannelBuffer.h"
+#include "OpenFrameworksPort.h"
+#include "UserPrefs.h"
+
+#include "juce_core/juce_core.h"
+
+#if JUCE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+   const char kMagic[4] = { 'B', 'S', 'C', 'F' };
+   const int kVersion = 1;
+   const int kHeaderSize = 4096; //a page, so the audio starts page aligned
+
+   struct Header
+   {
+      char mMagic[4];
+      int32_t mVersion;
+      int32_t mNumChannels;
+      int32_t mNumSamples;
+      int32_t mSampleRate;
+      int32_t mKeyLength; //the key follows the header, to catch hash collisions
+   };
+
+   int64_t GetCacheLimit()
+   {
+      return int64_t(UserPrefs.sample_cache_mb.Get()) * 1024 * 1024;
+   }
+
+   juce::File GetCacheDir()
+   {
+      return juce::File(ofToDataPath("internal/samplecache"));
+   }
+
+   //anything that changes the decoded audio has to be in here
+   std::string MakeKey(const juce::File& file, bool mono)
+   {
+      return file.getFullPathName().toStdString() + "|" + std::to_string(file.getLastModificationTime().toMilliseconds()) + "|" + std::to_string(file.getSize()) + (mono ? "|mono" : "|");
+   }
+
+   juce::File GetCacheFile(const std::string& key)
+   {
+      return GetCacheDir().getChildFile(juce::String::toHexString(juce::String::fromUTF8(key.c_str()).hashCode64()) + ".f32");
+   }
+
+   int64_t GetFileSize(int numChannels, int numSamples)
+   {
+      return kHeaderSize + int64_t(numChannels) * numSamples * sizeof(float);
+   }
+
+   //maps the whole file readable and writable, but private: writes copy the page they land on and never reach the file
+   void* MapPrivately(const juce::File& file, size_t size)
+   {
+#if JUCE_WINDOWS
+      HANDLE handle = CreateFileW(file.getFullPathName().toWideCharPointer(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (handle == INVALID_HANDLE_VALUE)
+         return nullptr;
+      void* address = nullptr;
+      HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+      if (mapping != nullptr)
+      {
+         address = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size);
+         CloseHandle(mapping);
+      }
+      CloseHandle(handle);
+      return address;
+#else
+      int fd = open(file.getFullPathName().toRawUTF8(), O_RDONLY);
+      if (fd < 0)
+         return nullptr;
+      void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      close(fd);
+      return address != MAP_FAILED ? address : nullptr;
+#endif
+   }
+
+   void Unmap(void* address, size_t size)
+   {
+#if JUCE_WINDOWS
+      juce::ignoreUnused(size);
+      UnmapViewOfFile(address);
+#else
+      munmap(address, size);
+#endif
+   }
+}
+
+SampleCache::Mapping::~Mapping()
+{
+   if (mAddress != nullptr)
+      Unmap(mAddress, mSize);
+}
+
+//static
+SampleCache& SampleCache::Get()
+{
+   static SampleCache sCache;
+   return sCache;
+}
+
+std::unique_ptr<SampleCache::Mapping> SampleCache::Acquire(const juce::File& file, bool mono)
+{
+   if (GetCacheLimit() <= 0 || !file.existsAsFile())
+      return nullptr;
+
+   std::shared_ptr<Entry> entry;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      entry = OpenEntry(MakeKey(file, mono));
+   }
+   if (entry == nullptr)
+      return nullptr;
+   return Map(entry);
+}
+
+std::unique_ptr<SampleCache::Mapping> SampleCache::Store(const juce::File& file, bool mono, ChannelBuffer* data, int numSamples, int sampleRate)
+{
+   int64_t limit = GetCacheLimit();
+   int numChannels = data->NumActiveChannels();
+   std::string key = MakeKey(file, mono);
+   if (numSamples <= 0 || GetFileSize(numChannels, numSamples) > limit || sizeof(Header) + key.size() > (size_t)kHeaderSize)
+      return nullptr;
+
+   GetCacheDir().createDirectory();
+   juce::File cacheFile = GetCacheFile(key);
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      Prune(limit - GetFileSize(numChannels, numSamples));
+   }
+
+   //written to the side and moved into place, so nobody can map it half written
+   juce::TemporaryFile temp(cacheFile);
+   {
+      juce::FileOutputStream out(temp.getFile());
+      if (out.failedToOpen())
+         return nullptr;
+
+      std::vector<char> headerBytes(kHeaderSize, 0);
+      Header header;
+      std::memcpy(header.mMagic, kMagic, sizeof(kMagic));
+      header.mVersion = kVersion;
+      header.mNumChannels = numChannels;
+      header.mNumSamples = numSamples;
+      header.mSampleRate = sampleRate;
+      header.mKeyLength = (int32_t)key.size();
+      std::memcpy(headerBytes.data(), &header, sizeof(header));
+      std::memcpy(headerBytes.data() + sizeof(header), key.data(), key.size());
+      out.write(headerBytes.data(), headerBytes.size());
+      for (int ch = 0; ch < numChannels; ++ch)
+         out.write(data->GetChannel(ch), sizeof(float) * numSamples);
+      out.flush();
+      if (out.getStatus().failed())
+         return nullptr;
+   }
+
+   std::shared_ptr<Entry> entry;
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!temp.overwriteTargetFileWithTemporary())
+         return nullptr;
+      entry = OpenEntry(key);
+   }
+   if (entry == nullptr)
+      return nullptr;
+   return Map(entry);
+}
+
+//call with mMutex held
+std::shared_ptr<SampleCache::Entry> SampleCache::OpenEntry(const std::string& key)
+{
+   auto iter = mEntries.find(key);
+   if (iter != mEntries.end())
+   {
+      if (auto entry = iter->second.lock())
+         return entry;
+      mEntries.erase(iter);
+   }
+
+   juce::File cacheFile = GetCacheFile(key);
+   juce::FileInputStream in(cacheFile);
+   if (in.failedToOpen())
+      return nullptr;
+
+   std::vector<char> headerBytes(kHeaderSize, 0);
+   if (in.read(headerBytes.data(), kHeaderSize) != kHeaderSize)
+      return nullptr;
+   Header header;
+   std::memcpy(&header, headerBytes.data(), sizeof(header));
+   if (std::memcmp(header.mMagic, kMagic, sizeof(kMagic)) != 0 || header.mVersion != kVersion ||
+       header.mKeyLength != (int)key.size() || key.compare(0, key.size(), headerBytes.data() + sizeof(header), key.size()) != 0 ||
+       header.mNumChannels < 1 || header.mNumChannels > ChannelBuffer::kMaxNumChannels || header.mNumSamples <= 0 ||
+       cacheFile.getSize() != GetFileSize(header.mNumChannels, header.mNumSamples))
+      return nullptr;
+
+   auto entry = std::make_shared<Entry>();
+   entry->mKey = key;
+   entry->mCachePath = cacheFile.getFullPathName().toStdString();
+   entry->mNumChannels = header.mNumChannels;
+   entry->mNumSamples = header.mNumSamples;
+   entry->mSampleRate = header.mSampleRate;
+   mEntries[key] = entry;
+
+   cacheFile.setLastModificationTime(juce::Time::getCurrentTime()); //for Prune(), which drops the least recently used first
+   return entry;
+}
+
+std::unique_ptr<SampleCache::Mapping> SampleCache::Map(const std::shared_ptr<Entry>& entry)
+{
+   auto mapping = std::unique_ptr<Mapping>(new Mapping());
+   mapping->mSize = (size_t)GetFileSize(entry->mNumChannels, entry->mNumSamples);
+   mapping->mAddress = MapPrivately(juce::File(entry->mCachePath), mapping->mSize);
+   if (mapping->mAddress == nullptr)
+      return nullptr;
+   mapping->mEntry = entry;
+   mapping->mData = reinterpret_cast<float*>(static_cast<char*>(mapping->mAddress) + kHeaderSize);
+   mapping->mNumChannels = entry->mNumChannels;
+   mapping->mNumSamples = entry->mNumSamples;
+   mapping->mSampleRate = entry->mSampleRate;
+   return mapping;
+}
+
+//deletes the least recently used files that nothing has mapped until the cache fits in maxBytes. call with mMutex held
+void SampleCache::Prune(int64_t maxBytes)
+{
+   std::vector<std::string> inUse;
+   for (auto iter = mEntries.begin(); iter != mEntries.end();)
+   {
+      if (auto entry = iter->second.lock())
+      {
+         inUse.push_back(entry->mCachePath);
+         ++iter;
+      }
+      else
+      {
+         iter = mEntries.erase(iter);
+      }
+   }
+
+   juce::Array<juce::File> files = GetCacheDir().findChildFiles(juce::File::findFiles, false, "*.f32");
+   int64_t total = 0;
+   for (const auto& file : files)
+      total += file.getSize();
+   if (total <= maxBytes)
+      return;
+
+   std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+             {
+                return a.getLastModificationTime() < b.getLastModificationTime();
+             });
+   for (const auto& file : files)
+   {
+      if (total <= maxBytes)
+         break;
+      if (std::find(inUse.begin(), inUse.end(), file.getFullPathName().toStdString()) != inUse.end())
+         continue;
+      int64_t size = file.getSize();
+      if (file.deleteFile())
+         total -= size;
+   }
+}
@@ -0,0 +1,94 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SampleCache.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class ChannelBuffer;
+
+namespace juce
+{
+   class File;
+}
+
+//process-wide cache of decoded sample files, keyed by path, modification time, size, and whether they were mixed down to mono.
+//the decoded audio is written once to a file under internal/samplecache, and every Sample that loads the same file maps it
+//instead of decoding it again. the pages are shared between them, and with the os file cache across sessions.
+//each mapping is private and copy-on-write, so a Sample that edits its data only ever gets its own copy of the pages it touched
+class SampleCache
+{
+   struct Entry;
+
+public:
+   //one Sample's view of a cached file. the entry stays in use (and on disk) until every mapping of it is gone
+   class Mapping
+   {
+   public:
+      ~Mapping();
+      float* GetChannel(int channel) const { return mData + size_t(channel) * mNumSamples; }
+      int GetNumChannels() const { return mNumChannels; }
+      int GetNumSamples() const { return mNumSamples; }
+      int GetSampleRate() const { return mSampleRate; }
+
+   private:
+      friend class SampleCache;
+      Mapping() = default;
+
+      std::shared_ptr<Entry> mEntry;
+      void* mAddress{ nullptr };
+      size_t mSize{ 0 };
+      float* mData{ nullptr };
+      int mNumChannels{ 0 };
+      int mNumSamples{ 0 };
+      int mSampleRate{ 0 };
+   };
+
+   static SampleCache& Get();
+
+   //nullptr if the file hasn't been cached since it last changed, or caching is turned off
+   std::unique_ptr<Mapping> Acquire(const juce::File& file, bool mono);
+   //writes decoded data to the cache and maps it back. nullptr if it couldn't be cached
+   std::unique_ptr<Mapping> Store(const juce::File& file, bool mono, ChannelBuffer* data, int numSamples, int sampleRate);
+
+private:
+   struct Entry
+   {
+      std::string mKey;
+      std::string mCachePath;
+      int mNumChannels{ 0 };
+      int mNumSamples{ 0 };
+      int mSampleRate{ 0 };
+   };
+
+   SampleCache() = default;
+   std::shared_ptr<Entry> OpenEntry(const std::string& key);
+   std::unique_ptr<Mapping> Map(const std::shared_ptr<Entry>& entry);
+   void Prune(int64_t maxBytes);
+
+   std::mutex mMutex;
+   std::unordered_map<std::string, std::weak_ptr<Entry> > mEntries;
+};
@@ -36,6 +36,7 @@
 #include "Scale.h"
 #include "UIControlMacros.h"
 #include "UserPrefs.h"
+#include "Resampler.h"
 
 #include "juce_gui_basics/juce_gui_basics.h"
 #include "juce_audio_formats/juce_audio_formats.h"
@@ -50,7 +51,7 @@ namespace
 
 SamplePlayer::SamplePlayer()
 : IAudioProcessor(gBufferSize)
-, mNoteInputBuffer(this)
+, mNoteInputBuffer(this, this)
 {
    mYoutubeSearch[0] = 0;
 }
@@ -410,6 +411,13 @@ void SamplePlayer::PlayNote(double time, int pitch, int velocity, int voiceIdx /
 
 void SamplePlayer::OnPulse(double time, float velocity, int flags)
 {
+   //PlayCuePoint() moves the playhead right away, so wait for the buffer the pulse lands in
+   if (!NoteInputBuffer::IsTimeWithinFrame(time) && GetTarget() && mSample)
+   {
+      mNoteInputBuffer.QueuePulse(time, velocity, flags);
+      return;
+   }
+
    if (mSample != nullptr)
       PlayCuePoint(time, -1, velocity * 127, 1, 0);
 }
@@ -478,7 +486,7 @@ void SamplePlayer::AutoSlice(int slices)
 void SamplePlayer::FilesDropped(std::vector<std::string> files, int x, int y)
 {
    Sample* sample = new Sample();
-   sample->Read(files[0].c_str());
+   sample->Read(files[0].c_str(), false, Sample::ReadType::Stream);
    UpdateSample(sample, true);
 }
 
@@ -564,12 +572,7 @@ void SamplePlayer::ButtonClicked(ClickButton* button, double time)
       Sample* sample = new Sample();
       sample->Create(GetZoomEndSample() - GetZoomStartSample());
       sample->Data()->SetNumActiveChannels(mSample->NumChannels());
-      for (int ch = 0; ch < mSample->NumChannels(); ++ch)
-      {
-         float* sampleData = sample->Data()->GetChannel(ch);
-         for (int i = 0; i < sample->LengthInSamples(); ++i)
-            sampleData[i] = mSample->Data()->GetChannel(ch)[i + GetZoomStartSample()];
-      }
+      mSample->ReadFrames(GetZoomStartSample(), sample->LengthInSamples(), sample->Data());
       sample->SetName(mSample->Name());
       UpdateSample(sample, true);
    }
@@ -755,7 +758,7 @@ void SamplePlayer::LoadFile()
 
       Sample* sample = new Sample();
       if (file.existsAsFile())
-         sample->Read(file.getFullPathName().toStdString().c_str());
+         sample->Read(file.getFullPathName().toStdString().c_str(), false, Sample::ReadType::Stream);
       UpdateSample(sample, true);
    }
 }
@@ -767,7 +770,7 @@ void SamplePlayer::SaveFile()
    if (chooser.browseForFileToSave(true))
    {
       auto file = chooser.getResult();
-      Sample::WriteDataToFile(file.getFullPathName().toStdString().c_str(), mSample->Data(), mSample->LengthInSamples());
+      mSample->Write(file.getFullPathName().toStdString().c_str());
    }
 }
 
@@ -816,25 +819,24 @@ ChannelBuffer* SamplePlayer::GetCueSampleData(int cueIndex)
       lengthSeconds = 1;
    int startSamples = startSeconds * gSampleRate * mSample->GetSampleRateRatio();
    int lengthSamplesSrc = lengthSeconds * gSampleRate * mSample->GetSampleRateRatio();
-   if (startSamples >= mSample->Data()->BufferSize())
-      startSamples = mSample->Data()->BufferSize() - 1;
-   if (startSamples + lengthSamplesSrc >= mSample->Data()->BufferSize())
-      lengthSamplesSrc = mSample->Data()->BufferSize() - 1 - startSamples;
+   if (startSamples >= mSample->LengthInSamples())
+      startSamples = mSample->LengthInSamples() - 1;
+   if (startSamples + lengthSamplesSrc >= mSample->LengthInSamples())
+      lengthSamplesSrc = mSample->LengthInSamples() - 1 - startSamples;
    int lengthSamplesDest = lengthSamplesSrc / speed / mSample->GetSampleRateRatio();
    ChannelBuffer* data = new ChannelBuffer(lengthSamplesDest);
-   data->SetNumActiveChannels(mSample->Data()->NumActiveChannels());
-   /*for (int ch = 0; ch < data->NumActiveChannels(); ++ch)
-   {
-      BufferCopy(data->GetChannel(ch), mSample->Data()->GetChannel(ch) + startSamples, lengthSamplesSrc);
-   }*/
+   data->SetNumActiveChannels(mSample->NumChannels());
+
+   //pull the source range out first, since a streaming sample only has its head in memory
+   ChannelBuffer source(lengthSamplesSrc);
+   source.SetNumActiveChannels(mSample->NumChannels());
+   mSample->ReadFrames(startSamples, lengthSamplesSrc, &source);
 
    for (int ch = 0; ch < data->NumActiveChannels(); ++ch)
    {
-      for (int i = 0; i < lengthSamplesDest; ++i)
-      {
-         float offset = i * speed * mSample->GetSampleRateRatio();
-         data->GetChannel(ch)[i] = GetInterpolatedSample(offset, mSample->Data()->GetChannel(ch) + startSamples, lengthSamplesSrc);
-      }
+      const float* sourceChannel = source.GetChannel(ch);
+      float* destChannel = data->GetChannel(ch);
+      Resampler::Read(&sourceChannel, 1, lengthSamplesSrc, 0, speed * mSample->GetSampleRateRatio(), &destChannel, 1, lengthSamplesDest, Resampler::Quality::Sinc32, 1, false, false);
    }
 
    return data;
@@ -1062,14 +1064,16 @@ void SamplePlayer::DrawModule()
       if (mIsLoadingSample && !mSample->IsSampleLoading())
       {
          mIsLoadingSample = false;
-         mDrawBuffer.Resize(mSample->LengthInSamples());
-         mDrawBuffer.CopyFrom(mSample->Data());
+         ChannelBuffer* drawData = mSample->GetDrawData(mDrawFramesPerPoint);
+         mDrawBuffer.Resize(drawData->BufferSize());
+         mDrawBuffer.CopyFrom(drawData);
       }
 
       int playPosition = mSample->GetPlayPosition();
       if (mAdsr.Value(gTime) == 0)
          playPosition = -1;
-      DrawAudioBuffer(sampleWidth, mHeight - 65, &mDrawBuffer, GetZoomStartSample(), GetZoomEndSample(), playPosition);
+      float framesPerPoint = mDrawFramesPerPoint;
+      DrawAudioBuffer(sampleWidth, mHeight - 65, &mDrawBuffer, GetZoomStartSample() / framesPerPoint, GetZoomEndSample() / framesPerPoint, playPosition >= 0 ? playPosition / framesPerPoint : -1);
 
       ofPushStyle();
       ofFill();
@@ -172,6 +172,7 @@ private:
    float mOscWheelSpeed{ 0 };
 
    ChannelBuffer mDrawBuffer{ 0 };
+   int mDrawFramesPerPoint{ 1 }; //streaming samples only have an overview to draw
 
    NoteInputBuffer mNoteInputBuffer;
    ::ADSR mAdsr{ 10, 1, 1, 10 };
@@ -0,0 +1,243 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SampleStream.cpp
+//  Bespoke
+//
+//
+
+#include "SampleStream.h"
+#include "ChannelBuffer.h"
+
+#include "juce_audio_formats/juce_audio_formats.h"
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <thread>
+
+namespace
+{
+   const int kReadChunkSize = 8192;
+}
+
+//one thread services every open stream: first keeping windows filled, and with whatever time is left over, building overviews
+class SampleStreamReader
+{
+public:
+   static SampleStreamReader& Get()
+   {
+      static SampleStreamReader sReader;
+      return sReader;
+   }
+
+   void Add(SampleStream* stream)
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStreams.push_back(stream);
+      if (!mThread.joinable())
+         mThread = std::thread(&SampleStreamReader::Run, this);
+      mCondition.notify_all();
+   }
+
+   //once this returns the thread is done with the stream
+   void Remove(SampleStream* stream)
+   {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStreams.erase(std::remove(mStreams.begin(), mStreams.end(), stream), mStreams.end());
+   }
+
+private:
+   ~SampleStreamReader()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mMutex);
+         mExit = true;
+      }
+      mCondition.notify_all();
+      if (mThread.joinable())
+         mThread.join();
+   }
+
+   void Run()
+   {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while (!mExit)
+      {
+         bool didWork = false;
+         for (auto* stream : mStreams)
+            didWork = stream->FillWindow() || didWork;
+
+         if (!didWork)
+         {
+            for (auto* stream : mStreams)
+            {
+               if (stream->ExtendOverview())
+               {
+                  didWork = true;
+                  break;
+               }
+            }
+         }
+
+         //the audio thread doesn't signal anything, so poll often enough to serve a seek within a buffer or two
+         if (!didWork)
+            mCondition.wait_for(lock, std::chrono::milliseconds(2));
+      }
+   }
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::vector<SampleStream*> mStreams;
+   std::thread mThread;
+   bool mExit{ false };
+};
+
+SampleStream::SampleStream(std::unique_ptr<juce::AudioFormatReader> reader, bool mono, int headLength, int capacity)
+: mReader(std::move(reader))
+, mMono(mono)
+{
+   mLength = (int)mReader->lengthInSamples;
+   mNumChannels = mono ? 1 : std::min((int)mReader->numChannels, ChannelBuffer::kMaxNumChannels);
+   mHeadLength = std::min(headLength, mLength);
+   mCapacity = std::max(capacity, kReadChunkSize);
+   mRing.assign(mNumChannels, std::vector<float>(mCapacity, 0));
+   mReadBuffer = std::make_unique<juce::AudioSampleBuffer>((int)mReader->numChannels, kReadChunkSize);
+   mStart = mHeadLength;
+   mEnd = mHeadLength;
+
+   mOverview = std::make_unique<ChannelBuffer>(std::max(1, (mLength + kOverviewStep - 1) / kOverviewStep));
+   mOverview->SetNumActiveChannels(mNumChannels);
+   mOverview->Clear();
+
+   SampleStreamReader::Get().Add(this);
+}
+
+SampleStream::~SampleStream()
+{
+   SampleStreamReader::Get().Remove(this);
+}
+
+SampleStream::Window SampleStream::GetWindow() const
+{
+   Window window;
+   if (mSeeksRequested.load() != mSeeksServed.load(std::memory_order_acquire))
+      return window;
+   window.mStart = mStart.load(std::memory_order_relaxed);
+   window.mEnd = mEnd.load(std::memory_order_acquire);
+   return window;
+}
+
+void SampleStream::Release(int frame)
+{
+   if (mSeeksRequested.load() != mSeeksServed.load(std::memory_order_acquire))
+      return;
+   frame = std::min(frame, mEnd.load(std::memory_order_acquire));
+   if (frame > mStart.load(std::memory_order_relaxed))
+      mStart.store(frame, std::memory_order_release);
+}
+
+void SampleStream::RequestSeek(int frame)
+{
+   if (mSeeksRequested.load() != mSeeksServed.load(std::memory_order_acquire))
+      return; //one at a time, the next miss will ask again
+   mSeekTarget.store(std::max(mHeadLength, std::min(frame, mLength)), std::memory_order_relaxed);
+   mSeeksRequested.fetch_add(1, std::memory_order_release);
+}
+
+bool SampleStream::FillWindow()
+{
+   int requested = mSeeksRequested.load(std::memory_order_acquire);
+   if (requested != mSeeksServed.load(std::memory_order_relaxed))
+   {
+      //the audio thread leaves the window alone until this is published
+      int target = mSeekTarget.load(std::memory_order_relaxed);
+      mStart.store(target, std::memory_order_relaxed);
+      mEnd.store(target, std::memory_order_relaxed);
+      mSeeksServed.store(requested, std::memory_order_release);
+   }
+
+   int start = mStart.load(std::memory_order_acquire);
+   int end = mEnd.load(std::memory_order_relaxed);
+   int length = std::min({ kReadChunkSize, start + mCapacity - end, mLength - end });
+   if (length <= 0)
+      return false;
+
+   std::lock_guard<std::mutex> lock(mReaderMutex);
+   ReadFromFile(end, length);
+   for (int ch = 0; ch < mNumChannels; ++ch)
+   {
+      const float* source = mReadBuffer->getReadPointer(ch);
+      float* ring = mRing[ch].data();
+      for (int i = 0; i < length; ++i)
+         ring[(end + i) % mCapacity] = source[i];
+   }
+   mEnd.store(end + length, std::memory_order_release);
+   return true;
+}
+
+bool SampleStream::ExtendOverview()
+{
+   int done = mOverviewFramesDone;
+   if (done >= mLength)
+      return false;
+
+   std::lock_guard<std::mutex> lock(mReaderMutex);
+   int length = std::min(kReadChunkSize, mLength - done);
+   ReadFromFile(done, length);
+   for (int ch = 0; ch < mNumChannels; ++ch)
+   {
+      const float* source = mReadBuffer->getReadPointer(ch);
+      float* overview = mOverview->GetChannel(ch);
+      for (int i = 0; i < length; ++i)
+      {
+         float& point = overview[(done + i) / kOverviewStep];
+         if (fabsf(source[i]) > fabsf(point))
+            point = source[i];
+      }
+   }
+   mOverviewFramesDone = done + length;
+   return true;
+}
+
+//into mReadBuffer, already mixed down to mNumChannels. needs mReaderMutex
+void SampleStream::ReadFromFile(int start, int length)
+{
+   mReader->read(mReadBuffer.get(), 0, length, start, true, true);
+   if (mMono && mReadBuffer->getNumChannels() > 1)
+   {
+      for (int ch = 1; ch < mReadBuffer->getNumChannels(); ++ch)
+         mReadBuffer->addFrom(0, 0, *mReadBuffer, ch, 0, length);
+      mReadBuffer->applyGain(0, 0, length, 1.0f / mReadBuffer->getNumChannels());
+   }
+}
+
+void SampleStream::ReadFrames(int start, int length, ChannelBuffer* dest)
+{
+   std::lock_guard<std::mutex> lock(mReaderMutex);
+   for (int pos = 0; pos < length; pos += kReadChunkSize)
+   {
+      int chunk = std::min(kReadChunkSize, length - pos);
+      ReadFromFile(start + pos, chunk);
+      for (int ch = 0; ch < dest->NumActiveChannels(); ++ch)
+      {
+         const float* source = mReadBuffer->getReadPointer(std::min(ch, mNumChannels - 1));
+         std::copy(source, source + chunk, dest->GetChannel(ch) + pos);
+      }
+   }
+}
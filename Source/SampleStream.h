@@ -0,0 +1,106 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SampleStream.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ChannelBuffer;
+
+namespace juce
+{
+   class AudioFormatReader;
+   template <typename T>
+   class AudioBuffer;
+   using AudioSampleBuffer = AudioBuffer<float>;
+}
+
+//plays a file straight from disk, keeping only a window of it in memory. a shared reader thread keeps the window filled
+//ahead of wherever the audio thread last read from. the audio thread only touches atomics and the ring, so it never waits on
+//the disk: anything it asks for that isn't there yet comes back as a miss, and it asks for the window to be moved.
+//the window starts at or after headLength, because Sample keeps the start of the file in memory for instant starts and loops
+class SampleStream
+{
+public:
+   //frames [mStart, mEnd) can be read with GetSample() until the next Release() or RequestSeek()
+   struct Window
+   {
+      int mStart{ 0 };
+      int mEnd{ 0 };
+      bool Contains(int frame) const { return frame >= mStart && frame < mEnd; }
+   };
+
+   static const int kOverviewStep = 256;
+
+   SampleStream(std::unique_ptr<juce::AudioFormatReader> reader, bool mono, int headLength, int capacity);
+   ~SampleStream();
+
+   int GetLength() const { return mLength; }
+   int GetNumChannels() const { return mNumChannels; }
+   bool IsMono() const { return mMono; }
+   int GetCapacity() const { return mCapacity; }
+
+   //audio thread
+   Window GetWindow() const; //empty while a seek is pending
+   float GetSample(int channel, int frame) const { return mRing[channel][frame % mCapacity]; }
+   void Release(int frame); //frames before this won't be read again, so the reader can reuse their space
+   void RequestSeek(int frame);
+
+   //any other thread. reads straight from the file, without going through the window
+   void ReadFrames(int start, int length, ChannelBuffer* dest);
+
+   //one point per kOverviewStep frames, holding the sample furthest from zero in that stretch, for drawing
+   ChannelBuffer* GetOverview() { return mOverview.get(); }
+   float GetOverviewProgress() const { return float(mOverviewFramesDone) / std::max(mLength, 1); }
+   bool IsOverviewDone() const { return mOverviewFramesDone >= mLength; }
+
+private:
+   friend class SampleStreamReader;
+
+   bool FillWindow(); //reader thread. these return true if they did any work
+   bool ExtendOverview();
+   void ReadFromFile(int start, int length);
+
+   std::unique_ptr<juce::AudioFormatReader> mReader;
+   std::unique_ptr<juce::AudioSampleBuffer> mReadBuffer;
+   std::mutex mReaderMutex; //the reader thread and ReadFrames() callers, never the audio thread
+   bool mMono{ false };
+   int mLength{ 0 };
+   int mNumChannels{ 1 };
+   int mHeadLength{ 0 };
+   int mCapacity{ 1 };
+   std::vector<std::vector<float> > mRing;
+
+   std::atomic<int> mStart{ 0 }; //moved by the audio thread, except while the reader is serving a seek
+   std::atomic<int> mEnd{ 0 }; //moved by the reader thread
+   std::atomic<int> mSeekTarget{ 0 };
+   std::atomic<int> mSeeksRequested{ 0 };
+   std::atomic<int> mSeeksServed{ 0 };
+
+   std::unique_ptr<ChannelBuffer> mOverview;
+   std::atomic<int> mOverviewFramesDone{ 0 };
+};
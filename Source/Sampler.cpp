@@ -93,6 +93,7 @@ void Sampler::Process(double time)
 
    mNoteInputBuffer.Process(time);
 
+   ComputeSliderBlocks();
    ComputeSliders(0);
    SyncBuffers();
 
@@ -35,6 +35,7 @@
 SignalGenerator::SignalGenerator()
 {
    mWriteBuffer = new float[gBufferSize];
+   mRenderBuffer = new float[gBufferSize * 4];
 
    mOsc.Start(0, 1);
 }
@@ -97,6 +98,7 @@ void SignalGenerator::CreateUIControls()
 SignalGenerator::~SignalGenerator()
 {
    delete[] mWriteBuffer;
+   delete[] mRenderBuffer;
 }
 
 void SignalGenerator::Process(double time)
@@ -112,7 +114,12 @@ void SignalGenerator::Process(double time)
    float* out = target->GetBuffer()->GetChannel(0);
    assert(bufferSize == gBufferSize);
 
-   Clear(mWriteBuffer, gBufferSize);
+   float* phases = mRenderBuffer;
+   float* phaseIncs = phases + gBufferSize;
+   float* gains = phaseIncs + gBufferSize;
+   float* envelope = gains + gBufferSize;
+   mOsc.GetADSR()->FillBuffer(time, gInvSampleRateMs, envelope, bufferSize);
+
    float syncPhaseInc = GetPhaseInc(mSyncFreq);
    for (int pos = 0; pos < bufferSize; ++pos)
    {
@@ -154,12 +161,24 @@ void SignalGenerator::Process(double time)
       mSyncPhase += syncPhaseInc;
 
       if (mSync)
-         mWriteBuffer[pos] += mOsc.Audio(time, mSyncPhase) * volSq;
+      {
+         phases[pos] = mSyncPhase;
+         phaseIncs[pos] = syncPhaseInc;
+      }
       else
-         mWriteBuffer[pos] += mOsc.Audio(time, mPhase + mPhaseOffset * FTWO_PI) * volSq;
+      {
+         phases[pos] = mPhase + mPhaseOffset * FTWO_PI;
+         phaseIncs[pos] = phaseInc;
+      }
+      gains[pos] = volSq;
 
       time += gInvSampleRateMs;
    }
+
+   //the oscillator shape is the expensive part, so it gets done in one pass over the whole buffer
+   mOsc.mOsc.Render(phases, phaseIncs, mWriteBuffer, bufferSize);
+   for (int pos = 0; pos < bufferSize; ++pos)
+      mWriteBuffer[pos] = mWriteBuffer[pos] * envelope[pos] * gains[pos];
    GetVizBuffer()->WriteChunk(mWriteBuffer, bufferSize, 0);
 
    Add(out, mWriteBuffer, bufferSize);
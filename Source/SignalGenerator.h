@@ -55,6 +55,7 @@ public:
 
    //IAudioSource
    void Process(double time) override;
+   bool CanProcessInParallel() override { return true; }
    void SetEnabled(bool enabled) override;
 
    //INoteReceiver
@@ -127,6 +128,7 @@ private:
    double mResetPhaseAtMs{ -9999 };
 
    float* mWriteBuffer{ nullptr };
+   float* mRenderBuffer{ nullptr }; //phases, phase increments, gains and envelope for the current buffer
 };
 
 #endif /* defined(__Bespoke__SignalGenerator__) */
@@ -0,0 +1,156 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SimdVec.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define BESPOKE_SIMD_SSE 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define BESPOKE_SIMD_NEON 1
+#endif
+
+//four float lanes, on sse2 or neon where we have them and plain arrays otherwise.
+//masks come out of the comparisons and are only meant to be fed to VecSelect()
+//VecTranspose() treats its four arguments as the rows of a 4x4 matrix
+namespace Simd
+{
+   const int kNumLanes = 4;
+
+#if BESPOKE_SIMD_SSE
+   typedef __m128 Vec;
+   typedef __m128 VecMask;
+   inline Vec VecSet(float value) { return _mm_set1_ps(value); }
+   inline Vec VecLoad(const float* src) { return _mm_loadu_ps(src); }
+   inline void VecStore(float* dest, Vec value) { _mm_storeu_ps(dest, value); }
+   inline Vec VecAdd(Vec a, Vec b) { return _mm_add_ps(a, b); }
+   inline Vec VecSub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+   inline Vec VecMul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+   inline Vec VecDiv(Vec a, Vec b) { return _mm_div_ps(a, b); }
+   inline Vec VecMin(Vec a, Vec b) { return _mm_min_ps(a, b); }
+   inline Vec VecMax(Vec a, Vec b) { return _mm_max_ps(a, b); }
+   inline Vec VecTruncate(Vec a) { return _mm_cvtepi32_ps(_mm_cvttps_epi32(a)); }
+   inline VecMask VecLess(Vec a, Vec b) { return _mm_cmplt_ps(a, b); }
+   inline VecMask VecGreater(Vec a, Vec b) { return _mm_cmpgt_ps(a, b); }
+   inline Vec VecSelect(VecMask mask, Vec ifTrue, Vec ifFalse) { return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse)); }
+   inline Vec VecReverse(Vec a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)); }
+   inline void VecTranspose(Vec& a, Vec& b, Vec& c, Vec& d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+#elif BESPOKE_SIMD_NEON
+   typedef float32x4_t Vec;
+   typedef uint32x4_t VecMask;
+   inline Vec VecSet(float value) { return vdupq_n_f32(value); }
+   inline Vec VecLoad(const float* src) { return vld1q_f32(src); }
+   inline void VecStore(float* dest, Vec value) { vst1q_f32(dest, value); }
+   inline Vec VecAdd(Vec a, Vec b) { return vaddq_f32(a, b); }
+   inline Vec VecSub(Vec a, Vec b) { return vsubq_f32(a, b); }
+   inline Vec VecMul(Vec a, Vec b) { return vmulq_f32(a, b); }
+   inline Vec VecDiv(Vec a, Vec b) { return vdivq_f32(a, b); }
+   inline Vec VecMin(Vec a, Vec b) { return vminq_f32(a, b); }
+   inline Vec VecMax(Vec a, Vec b) { return vmaxq_f32(a, b); }
+   inline Vec VecTruncate(Vec a) { return vcvtq_f32_s32(vcvtq_s32_f32(a)); }
+   inline VecMask VecLess(Vec a, Vec b) { return vcltq_f32(a, b); }
+   inline VecMask VecGreater(Vec a, Vec b) { return vcgtq_f32(a, b); }
+   inline Vec VecSelect(VecMask mask, Vec ifTrue, Vec ifFalse) { return vbslq_f32(mask, ifTrue, ifFalse); }
+   inline Vec VecReverse(Vec a)
+   {
+      Vec pairsSwapped = vrev64q_f32(a);
+      return vcombine_f32(vget_high_f32(pairsSwapped), vget_low_f32(pairsSwapped));
+   }
+   inline void VecTranspose(Vec& a, Vec& b, Vec& c, Vec& d)
+   {
+      float32x4x2_t ab = vtrnq_f32(a, b);
+      float32x4x2_t cd = vtrnq_f32(c, d);
+      a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+      b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+      c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+      d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+   }
+#else
+   struct Vec
+   {
+      float mLane[kNumLanes];
+   };
+   struct VecMask
+   {
+      bool mLane[kNumLanes];
+   };
+
+   template <typename F>
+   inline Vec VecApply(Vec a, Vec b, F&& f)
+   {
+      Vec ret;
+      for (int i = 0; i < kNumLanes; ++i)
+         ret.mLane[i] = f(a.mLane[i], b.mLane[i]);
+      return ret;
+   }
+
+   inline Vec VecSet(float value) { return { { value, value, value, value } }; }
+   inline Vec VecLoad(const float* src) { return { { src[0], src[1], src[2], src[3] } }; }
+   inline void VecStore(float* dest, Vec value) { std::copy(value.mLane, value.mLane + kNumLanes, dest); }
+   inline Vec VecAdd(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return x + y; }); }
+   inline Vec VecSub(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return x - y; }); }
+   inline Vec VecMul(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return x * y; }); }
+   inline Vec VecDiv(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return x / y; }); }
+   inline Vec VecMin(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return std::min(x, y); }); }
+   inline Vec VecMax(Vec a, Vec b) { return VecApply(a, b, [](float x, float y) { return std::max(x, y); }); }
+   inline Vec VecTruncate(Vec a) { return VecApply(a, a, [](float x, float) { return float(int(x)); }); }
+   inline VecMask VecLess(Vec a, Vec b) { return { { a.mLane[0] < b.mLane[0], a.mLane[1] < b.mLane[1], a.mLane[2] < b.mLane[2], a.mLane[3] < b.mLane[3] } }; }
+   inline VecMask VecGreater(Vec a, Vec b) { return VecLess(b, a); }
+   inline Vec VecSelect(VecMask mask, Vec ifTrue, Vec ifFalse)
+   {
+      Vec ret;
+      for (int i = 0; i < kNumLanes; ++i)
+         ret.mLane[i] = mask.mLane[i] ? ifTrue.mLane[i] : ifFalse.mLane[i];
+      return ret;
+   }
+   inline Vec VecReverse(Vec a) { return { { a.mLane[3], a.mLane[2], a.mLane[1], a.mLane[0] } }; }
+   inline void VecTranspose(Vec& a, Vec& b, Vec& c, Vec& d)
+   {
+      Vec rows[kNumLanes] = { a, b, c, d };
+      Vec* out[kNumLanes] = { &a, &b, &c, &d };
+      for (int i = 0; i < kNumLanes; ++i)
+      {
+         for (int j = 0; j < kNumLanes; ++j)
+            out[i]->mLane[j] = rows[j].mLane[i];
+      }
+   }
+#endif
+
+   //x - floor(x), for x within int range
+   inline Vec VecFrac(Vec x)
+   {
+      Vec frac = VecSub(x, VecTruncate(x));
+      return VecSelect(VecLess(frac, VecSet(0)), VecAdd(frac, VecSet(1)), frac);
+   }
+
+   //adds the lanes together
+   inline float VecSum(Vec a)
+   {
+      float lanes[kNumLanes];
+      VecStore(lanes, a);
+      return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   }
+}
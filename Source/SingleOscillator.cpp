@@ -162,6 +162,7 @@ void SingleOscillator::Process(double time)
 
    mNoteInputBuffer.Process(time);
 
+   ComputeSliderBlocks();
    ComputeSliders(0);
 
    int bufferSize = target->GetBuffer()->BufferSize();
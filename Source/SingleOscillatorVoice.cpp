@@ -29,6 +29,7 @@
 #include "Scale.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "SimdVec.h"
 
 SingleOscillatorVoice::SingleOscillatorVoice(IDrawableModule* owner)
 : mOwner(owner)
@@ -39,6 +40,11 @@ SingleOscillatorVoice::~SingleOscillatorVoice()
 {
 }
 
+void SingleOscillatorVoice::SetMaxBufferSize(int bufferSize)
+{
+   mEnvelopeBuffer.assign(bufferSize * 2, 0);
+}
+
 bool SingleOscillatorVoice::IsDone(double time)
 {
    return mAdsr.IsDone(time);
@@ -65,12 +71,20 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out, int oversam
    if (mVoiceParams->mLiteCPUMode)
       DoParameterUpdate(0, pitch, freq, vol);
 
-   for (int pos = 0; pos < out->BufferSize(); ++pos)
+   int bufferSize = out->BufferSize();
+   assert((int)mEnvelopeBuffer.size() >= bufferSize * 2);
+   float* adsrBuffer = mEnvelopeBuffer.data();
+   float* filterAdsrBuffer = adsrBuffer + bufferSize;
+   mAdsr.FillBuffer(time, gInvSampleRateMs, adsrBuffer, bufferSize);
+   if (mUseFilter)
+      mFilterAdsr.FillBuffer(time, gInvSampleRateMs, filterAdsrBuffer, bufferSize);
+
+   for (int pos = 0; pos < bufferSize; ++pos)
    {
       if (!mVoiceParams->mLiteCPUMode)
          DoParameterUpdate(pos, pitch, freq, vol);
 
-      float adsrVal = mAdsr.Value(time);
+      float adsrVal = adsrBuffer[pos];
 
       float summedLeft = 0;
       float summedRight = 0;
@@ -103,9 +117,9 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out, int oversam
          {
             //PROFILER(SingleOscillatorVoice_GetOscValue);
             if (mVoiceParams->mSync)
-               sample = mOscData[u].mOsc.Value(mOscData[u].mSyncPhase) * adsrVal * vol;
+               sample = mOscData[u].mOsc.Value(mOscData[u].mSyncPhase, syncPhaseInc) * adsrVal * vol;
             else
-               sample = mOscData[u].mOsc.Value(mOscData[u].mPhase + mVoiceParams->mPhaseOffset * (1 + (float(u) / mVoiceParams->mUnison))) * adsrVal * vol;
+               sample = mOscData[u].mOsc.Value(mOscData[u].mPhase + mVoiceParams->mPhaseOffset * (1 + (float(u) / mVoiceParams->mUnison)), mOscData[u].mCurrentPhaseInc) * adsrVal * vol;
          }
 
          if (u >= 2)
@@ -136,7 +150,7 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out, int oversam
       if (mUseFilter)
       {
          //PROFILER(SingleOscillatorVoice_filter);
-         float f = ofLerp(mVoiceParams->mFilterCutoffMin, mVoiceParams->mFilterCutoffMax, mFilterAdsr.Value(time)) * (1 - GetModWheel(pos) * .9f);
+         float f = ofLerp(mVoiceParams->mFilterCutoffMin, mVoiceParams->mFilterCutoffMax, filterAdsrBuffer[pos]) * (1 - GetModWheel(pos) * .9f);
          float q = mVoiceParams->mFilterQ;
          if (f != mFilterLeft.mF || q != mFilterLeft.mQ)
             mFilterLeft.SetFilterParams(f, q);
@@ -160,7 +174,171 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out, int oversam
             out->GetChannel(1)[pos] += summedRight;
          }
       }
-      time += gInvSampleRateMs;
+   }
+
+   return true;
+}
+
+//renders up to four voices side by side. their oscillator state is gathered into lanes for the block and written back after,
+//so voices can move between this and Process() from one block to the next
+bool SingleOscillatorVoice::ProcessBatch(IMidiVoice* const* voices, int numVoices, double time, ChannelBuffer* out, int oversampling)
+{
+   using namespace Simd;
+
+   if (numVoices > kNumLanes || mVoiceParams->mSync)
+      return false;
+
+   SingleOscillatorVoice* lanes[kNumLanes];
+   int numLanes = 0;
+   for (int i = 0; i < numVoices; ++i)
+   {
+      auto* voice = static_cast<SingleOscillatorVoice*>(voices[i]);
+      if (voice->mUseFilter || voice->mVoiceParams != mVoiceParams)
+         return false; //the filters still run a voice at a time
+      if (!voice->IsDone(time))
+         lanes[numLanes++] = voice;
+   }
+   if (numLanes < 2)
+   {
+      for (int i = 0; i < numLanes; ++i)
+         lanes[i]->Process(time, out, oversampling);
+      return true;
+   }
+
+   PROFILER(SingleOscillatorVoice_batch);
+
+   int unison = std::min(mVoiceParams->mUnison, kMaxUnison);
+   bool mono = (out->NumActiveChannels() == 1);
+   int bufferSize = out->BufferSize();
+   float syncPhaseInc = GetPhaseInc(mVoiceParams->mSyncFreq);
+
+   //lanes without a voice stay silent: zero volume, zero envelope
+   alignas(16) float phases[kMaxUnison][kNumLanes]{};
+   alignas(16) float syncPhases[kMaxUnison][kNumLanes]{};
+   alignas(16) float phaseIncs[kMaxUnison][kNumLanes]{};
+   alignas(16) float detuneGains[kMaxUnison][kNumLanes]{};
+   alignas(16) float unisonPans[kMaxUnison][kNumLanes]{};
+   alignas(16) float voicePans[kNumLanes]{};
+   alignas(16) float vols[kNumLanes]{};
+   alignas(16) float envelopes[kNumLanes]{};
+   alignas(16) float shapePhases[kNumLanes]{};
+   alignas(16) float shapes[kNumLanes]{};
+   alignas(16) float lefts[kNumLanes]{};
+   alignas(16) float rights[kNumLanes]{};
+   const float* adsrBuffers[kNumLanes];
+
+   for (int lane = 0; lane < numLanes; ++lane)
+   {
+      SingleOscillatorVoice* voice = lanes[lane];
+      assert((int)voice->mEnvelopeBuffer.size() >= bufferSize * 2);
+      voice->mAdsr.FillBuffer(time, gInvSampleRateMs, voice->mEnvelopeBuffer.data(), bufferSize);
+      adsrBuffers[lane] = voice->mEnvelopeBuffer.data();
+      voicePans[lane] = voice->GetPan();
+
+      for (int u = 0; u < unison; ++u)
+      {
+         phases[u][lane] = voice->mOscData[u].mPhase;
+         syncPhases[u][lane] = voice->mOscData[u].mSyncPhase;
+         detuneGains[u][lane] = u >= 2 ? 1 - (voice->mOscData[u].mDetuneFactor * .5f) : 1;
+         if (mVoiceParams->mUnison == 1)
+            unisonPans[u][lane] = 0;
+         else if (u == 0)
+            unisonPans[u][lane] = -1;
+         else if (u == 1)
+            unisonPans[u][lane] = 1;
+         else
+            unisonPans[u][lane] = voice->mOscData[u].mDetuneFactor;
+      }
+   }
+   for (int lane = numLanes; lane < kNumLanes; ++lane)
+      adsrBuffers[lane] = gZeroBuffer;
+
+   for (int u = 0; u < unison; ++u)
+      mOscData[u].mOsc.SetType(mVoiceParams->mOscType);
+
+   float pitch;
+   float freq;
+   auto updateLanes = [&](int samplesIn)
+   {
+      if (mOwner)
+         mOwner->ComputeSliders(samplesIn);
+      for (int lane = 0; lane < numLanes; ++lane)
+      {
+         lanes[lane]->UpdatePhaseIncs(samplesIn, pitch, freq, vols[lane]);
+         for (int u = 0; u < unison; ++u)
+            phaseIncs[u][lane] = lanes[lane]->mOscData[u].mCurrentPhaseInc;
+      }
+   };
+
+   if (mVoiceParams->mLiteCPUMode)
+      updateLanes(0);
+
+   const Vec wrap = VecSet(FTWO_PI * 2);
+   const Vec zero = VecSet(0);
+   const Vec one = VecSet(1);
+   const Vec minusOne = VecSet(-1);
+
+   for (int pos = 0; pos < bufferSize; ++pos)
+   {
+      if (!mVoiceParams->mLiteCPUMode)
+         updateLanes(pos);
+
+      for (int lane = 0; lane < kNumLanes; ++lane)
+         envelopes[lane] = adsrBuffers[lane][pos];
+      Vec gain = VecMul(VecLoad(envelopes), VecLoad(vols));
+      Vec unisonWidth = VecSet(mVoiceParams->mUnisonWidth);
+
+      Vec left = zero;
+      Vec right = zero;
+      for (int u = 0; u < unison; ++u)
+      {
+         //the lanes share one set of oscillator settings, so the first voice's oscillator shapes them all
+         Oscillator& osc = mOscData[u].mOsc;
+         osc.SetPulseWidth(mVoiceParams->mPulseWidth);
+         osc.SetShuffle(mVoiceParams->mShuffle);
+         osc.SetSoften(mVoiceParams->mSoften);
+
+         Vec phaseInc = VecLoad(phaseIncs[u]);
+         Vec phase = VecAdd(VecLoad(phases[u]), phaseInc);
+         VecMask wrapped = VecGreater(phase, wrap);
+         phase = VecSelect(wrapped, VecSub(phase, wrap), phase);
+         Vec syncPhase = VecAdd(VecSelect(wrapped, zero, VecLoad(syncPhases[u])), VecSet(syncPhaseInc));
+         VecStore(phases[u], phase);
+         VecStore(syncPhases[u], syncPhase);
+
+         VecStore(shapePhases, VecAdd(phase, VecSet(mVoiceParams->mPhaseOffset * (1 + (float(u) / mVoiceParams->mUnison)))));
+         osc.Render(shapePhases, phaseIncs[u], shapes, kNumLanes);
+         Vec sample = VecMul(VecMul(VecLoad(shapes), gain), VecLoad(detuneGains[u]));
+
+         if (mono)
+         {
+            left = VecAdd(left, sample);
+         }
+         else
+         {
+            Vec pan = VecAdd(VecLoad(voicePans), VecMul(VecLoad(unisonPans[u]), unisonWidth));
+            pan = VecMin(VecMax(pan, minusOne), one);
+            left = VecAdd(left, VecMul(sample, VecSub(one, pan)));
+            right = VecAdd(right, VecMul(sample, VecAdd(pan, one)));
+         }
+      }
+
+      VecStore(lefts, left);
+      out->GetChannel(0)[pos] += lefts[0] + lefts[1] + lefts[2] + lefts[3];
+      if (!mono)
+      {
+         VecStore(rights, right);
+         out->GetChannel(1)[pos] += rights[0] + rights[1] + rights[2] + rights[3];
+      }
+   }
+
+   for (int lane = 0; lane < numLanes; ++lane)
+   {
+      for (int u = 0; u < unison; ++u)
+      {
+         lanes[lane]->mOscData[u].mPhase = phases[u][lane];
+         lanes[lane]->mOscData[u].mSyncPhase = syncPhases[u][lane];
+      }
    }
 
    return true;
@@ -174,6 +352,14 @@ void SingleOscillatorVoice::DoParameterUpdate(int samplesIn,
    if (mOwner)
       mOwner->ComputeSliders(samplesIn);
 
+   UpdatePhaseIncs(samplesIn, pitch, freq, vol);
+}
+
+void SingleOscillatorVoice::UpdatePhaseIncs(int samplesIn,
+                                            float& pitch,
+                                            float& freq,
+                                            float& vol)
+{
    pitch = GetPitch(samplesIn);
    freq = TheScale->PitchToFreq(pitch) * mVoiceParams->mMult;
    vol = mVoiceParams->mVol * .4f / mVoiceParams->mUnison;
@@ -76,7 +76,9 @@ public:
    void Stop(double time) override;
    void ClearVoice() override;
    bool Process(double time, ChannelBuffer* out, int oversampling) override;
+   bool ProcessBatch(IMidiVoice* const* voices, int numVoices, double time, ChannelBuffer* out, int oversampling) override;
    void SetVoiceParams(IVoiceParams* params) override;
+   void SetMaxBufferSize(int bufferSize) override;
    bool IsDone(double time) override;
 
    static float GetADSRScale(float velocity, float velToEnvelope);
@@ -88,6 +90,10 @@ private:
                           float& pitch,
                           float& freq,
                           float& vol);
+   void UpdatePhaseIncs(int samplesIn,
+                        float& pitch,
+                        float& freq,
+                        float& vol);
 
    struct OscData
    {
@@ -102,6 +108,7 @@ private:
    OscillatorVoiceParams* mVoiceParams{ nullptr };
 
    ::ADSR mFilterAdsr;
+   std::vector<float> mEnvelopeBuffer; //amp and filter envelopes for the current block
    BiquadFilter mFilterLeft;
    BiquadFilter mFilterRight;
    bool mUseFilter{ false };
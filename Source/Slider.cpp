@@ -601,6 +601,9 @@ void FloatSlider::DoCompute(int samplesIn /*= 0*/)
    if (mLastComputeTime == gTime && mLastComputeSamplesIn == samplesIn)
       return; //we've just calculated this, no need to do it again! earlying out avoids wasted work and circular modulation loops
 
+   if (mComputingBlock)
+      return; //circular modulation loop back into ComputeBlock()
+
    if (mLFOControl && mLFOControl->Active() && mLFOControl->InLowResMode() && samplesIn != 0)
       return; //only do the math on Compute(0) for low res mode
 
@@ -638,6 +641,55 @@ void FloatSlider::DoCompute(int samplesIn /*= 0*/)
       mOwner->FloatSliderUpdated(this, oldVal, gTime + samplesIn * gInvSampleRateMs);
 }
 
+const float* FloatSlider::ComputeBlock()
+{
+   mComputeHasBeenCalledOnce = true;
+
+   bool modulated = mModulator != nullptr && mModulator->Active();
+   if (!modulated && !mIsSmoothing)
+      return nullptr;
+
+   if (!IsAudioThread() || (mLFOControl && mLFOControl->Active() && mLFOControl->InLowResMode()))
+   {
+      DoCompute(0);
+      return nullptr;
+   }
+
+   //several voices can ask for the same slider's block
+   if (mLastComputeBlockTime == gTime)
+      return mLastComputeCacheValue;
+
+   float oldVal = *mVar;
+   float* values = mLastComputeCacheValue;
+
+   mComputingBlock = true;
+   if (modulated)
+   {
+      mModulator->FillBuffer(values, gBufferSize);
+      if (mIsSmoothing)
+         mSmoothTarget = values[gBufferSize - 1];
+   }
+   if (mIsSmoothing)
+   {
+      for (int i = 0; i < gBufferSize; ++i)
+         values[i] = mRamp.Value(gTime + i * gInvSampleRateMs);
+   }
+   mComputingBlock = false;
+
+   //fill in the cache, so anything that still calls Compute(samplesIn) this buffer gets the same values
+   for (int i = 0; i < gBufferSize; ++i)
+      mLastComputeCacheTime[i] = gTime;
+   mLastComputeBlockTime = gTime;
+   mLastComputeTime = gTime;
+   mLastComputeSamplesIn = gBufferSize - 1;
+
+   *mVar = values[gBufferSize - 1];
+   if (oldVal != *mVar)
+      mOwner->FloatSliderUpdated(this, oldVal, gTime + (gBufferSize - 1) * gInvSampleRateMs);
+
+   return values;
+}
+
 float* FloatSlider::GetModifyValue()
 {
    if (!TheSynth->IsLoadingModule() && mModulator && mModulator->Active() && mModulator->CanAdjustRange())
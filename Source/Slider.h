@@ -65,6 +65,10 @@ public:
       if (mIsSmoothing || mModulator != nullptr)
          DoCompute(samplesIn);
    }
+   //computes the whole buffer's values at once, rather than going through the modulator a sample at a time.
+   //returns nullptr when the value holds for the whole buffer (nothing modulating or smoothing it), read *var then.
+   //this only notifies the owner once, with the last value.
+   const float* ComputeBlock();
    void DisplayLFOControl();
    void DisableLFO();
    FloatSliderLFOControl* GetLFO() { return mLFOControl; }
@@ -185,6 +189,8 @@ private:
    int mLastComputeSamplesIn{ 0 };
    double* mLastComputeCacheTime;
    float* mLastComputeCacheValue;
+   double mLastComputeBlockTime{ -1 };
+   bool mComputingBlock{ false };
 
    float mLastDisplayedValue{ std::numeric_limits<float>::max() };
 
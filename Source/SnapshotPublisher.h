@@ -0,0 +1,127 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  SnapshotPublisher.h
+//  Bespoke
+//
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//tracks whether the audio thread is in the middle of a buffer, so that data it might still be reading can be
+//freed once it has moved on. ModularSynth::AudioOut() brackets every buffer with BeginBuffer()/EndBuffer().
+class AudioThreadEpoch
+{
+public:
+   static void BeginBuffer() { sInBuffer.store(true); }
+   static void EndBuffer()
+   {
+      sCompletedBuffers.fetch_add(1);
+      sInBuffer.store(false);
+   }
+   static uint64_t GetCompletedBuffers() { return sCompletedBuffers.load(); }
+
+   //true once the audio thread can no longer be looking at anything that was unpublished when GetCompletedBuffers() returned completedBuffers
+   static bool HasMovedPast(uint64_t completedBuffers) { return !sInBuffer.load() || sCompletedBuffers.load() > completedBuffers; }
+
+   //for non-audio threads only. blocks for at most one audio buffer, the audio thread never waits on this
+   static void WaitUntilMovedPast(uint64_t completedBuffers)
+   {
+      while (!HasMovedPast(completedBuffers))
+         std::this_thread::sleep_for(std::chrono::microseconds(200));
+   }
+
+private:
+   inline static std::atomic<bool> sInBuffer{ false };
+   inline static std::atomic<uint64_t> sCompletedBuffers{ 0 };
+};
+
+//holds an immutable T that the audio thread reads without locking.
+//writers build a complete new T and publish it with a single atomic exchange. the replaced T is kept alive
+//until the audio thread has finished any buffer that might have been using it, and is then deleted by
+//CollectGarbage() on a non-audio thread.
+template <class T>
+class SnapshotPublisher
+{
+public:
+   ~SnapshotPublisher()
+   {
+      delete mCurrent.load();
+      for (auto& retired : mRetired)
+         delete retired.first;
+   }
+
+   //audio thread, between AudioThreadEpoch::BeginBuffer() and EndBuffer()
+   const T* Get() const { return mCurrent.load(std::memory_order_acquire); }
+
+   //non-audio threads
+   void Publish(std::unique_ptr<T> snapshot)
+   {
+      T* old = mCurrent.exchange(snapshot.release(), std::memory_order_acq_rel);
+      if (old != nullptr)
+      {
+         std::lock_guard<std::mutex> lock(mRetiredMutex);
+         mRetired.push_back(std::make_pair(old, AudioThreadEpoch::GetCompletedBuffers()));
+      }
+   }
+
+   //audio thread, which can't take mRetiredMutex. hands back the replaced T, which stays in use until the audio
+   //thread finishes this buffer, for the caller to Retire() later from a non-audio thread
+   std::unique_ptr<T> Swap(std::unique_ptr<T> snapshot)
+   {
+      return std::unique_ptr<T>(mCurrent.exchange(snapshot.release(), std::memory_order_acq_rel));
+   }
+
+   //non-audio threads. queues a T that was replaced when GetCompletedBuffers() returned completedBuffers
+   void Retire(std::unique_ptr<T> snapshot, uint64_t completedBuffers)
+   {
+      std::lock_guard<std::mutex> lock(mRetiredMutex);
+      mRetired.push_back(std::make_pair(snapshot.release(), completedBuffers));
+   }
+
+   void CollectGarbage()
+   {
+      std::lock_guard<std::mutex> lock(mRetiredMutex);
+      for (auto iter = mRetired.begin(); iter != mRetired.end();)
+      {
+         if (AudioThreadEpoch::HasMovedPast(iter->second))
+         {
+            delete iter->first;
+            iter = mRetired.erase(iter);
+         }
+         else
+         {
+            ++iter;
+         }
+      }
+   }
+
+private:
+   std::atomic<T*> mCurrent{ nullptr };
+   std::mutex mRetiredMutex; //only ever taken by non-audio threads
+   std::vector<std::pair<T*, uint64_t> > mRetired;
+};
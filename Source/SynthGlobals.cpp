@@ -39,6 +39,7 @@
 #include "IPulseReceiver.h"
 #include "exprtk/exprtk.hpp"
 #include "UserPrefs.h"
+#include "AudioGraphExecutor.h"
 
 #include "juce_audio_formats/juce_audio_formats.h"
 #include "juce_gui_basics/juce_gui_basics.h"
@@ -68,8 +69,8 @@ RetinaTrueTypeFont gFontFixedWidth;
 float gModuleDrawAlpha = 255;
 float gNullBuffer[kWorkBufferSize];
 float gZeroBuffer[kWorkBufferSize];
-float gWorkBuffer[kWorkBufferSize];
-ChannelBuffer gWorkChannelBuffer(kWorkBufferSize);
+thread_local float gWorkBuffer[kWorkBufferSize];
+thread_local ChannelBuffer gWorkChannelBuffer(kWorkBufferSize);
 IDrawableModule* gHoveredModule = nullptr;
 IUIControl* gHoveredUIControl = nullptr;
 IUIControl* gHotBindUIControl[10];
@@ -79,7 +80,7 @@ bool gShowDevModules = false;
 float gCornerRoundness = 1;
 
 std::random_device gRandomDevice;
-bespoke::core::Xoshiro256ss gRandom(gRandomDevice);
+thread_local bespoke::core::Xoshiro256ss gRandom(gRandomDevice);
 std::uniform_real_distribution<float> gRandom01(0.0f, 1.f);
 std::uniform_real_distribution<float> gRandomBipolarDist(-1.f, 1.f);
 
@@ -422,9 +423,10 @@ void AssertIfDenormal(float input)
 
 float GetInterpolatedSample(double offset, const float* buffer, int bufferSize)
 {
-   offset = DoubleWrap(offset, bufferSize);
+   if (offset < 0 || offset >= bufferSize)
+      offset = DoubleWrap(offset, bufferSize);
    int pos = int(offset);
-   int posNext = int(offset + 1) % bufferSize;
+   int posNext = pos + 1 < bufferSize ? pos + 1 : 0;
 
    float sample = buffer[pos];
    float nextSample = buffer[posNext];
@@ -772,7 +774,7 @@ double NextBufferTime(bool includeLookahead)
 
 bool IsAudioThread()
 {
-   return std::this_thread::get_id() == ModularSynth::GetAudioThreadID();
+   return std::this_thread::get_id() == ModularSynth::GetAudioThreadID() || AudioGraphExecutor::IsWorkerThread();
 }
 
 float GetLeftPanGain(float pan)
@@ -104,8 +104,8 @@ extern RetinaTrueTypeFont gFontFixedWidth;
 extern float gModuleDrawAlpha;
 extern float gNullBuffer[kWorkBufferSize];
 extern float gZeroBuffer[kWorkBufferSize];
-extern float gWorkBuffer[kWorkBufferSize]; //scratch buffer for doing work in
-extern ChannelBuffer gWorkChannelBuffer;
+extern thread_local float gWorkBuffer[kWorkBufferSize]; //scratch buffer for doing work in, one per audio thread
+extern thread_local ChannelBuffer gWorkChannelBuffer;
 extern IDrawableModule* gHoveredModule;
 extern IUIControl* gHoveredUIControl;
 extern IUIControl* gHotBindUIControl[10];
@@ -116,7 +116,7 @@ extern float gCornerRoundness;
 
 extern std::random_device gRandomDevice;
 
-extern bespoke::core::Xoshiro256ss gRandom;
+extern thread_local bespoke::core::Xoshiro256ss gRandom;
 extern std::uniform_real_distribution<float> gRandom01;
 extern std::uniform_real_distribution<float> gRandomBipolarDist;
 
@@ -370,6 +370,17 @@ void TitleBar::DrawModule()
    mSaveStateAsButton->Draw();
    mLoadStateButton->Draw();
    mWriteAudioButton->Draw();
+   float saveOutputProgress = TheSynth->GetSaveOutputProgress();
+   if (saveOutputProgress >= 0)
+   {
+      //fills up the button while the record buffer is written out
+      ofRectangle rect = mWriteAudioButton->GetRect(K(local));
+      ofPushStyle();
+      ofFill();
+      ofSetColor(255, 255, 255, 80);
+      ofRect(rect.x, rect.y, rect.width * saveOutputProgress, rect.height, 0);
+      ofPopStyle();
+   }
    mLoadLayoutDropdown->Draw();
    mResetLayoutButton->Draw();
    if (TheSynth->IsAudioPaused())
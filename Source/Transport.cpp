@@ -28,6 +28,10 @@
 #include "ModularSynth.h"
 #include "ChaosEngine.h"
 #include "FillSaveDropdown.h"
+#include "SnapshotPublisher.h"
+
+#include <algorithm>
+#include <limits>
 
 Transport* TheTransport = nullptr;
 
@@ -43,6 +47,27 @@ Transport::Transport()
    SetName("transport");
 
    SetRandomTempo();
+
+   //so the audio thread doesn't have to allocate as listeners come and go
+   mListeners.reserve(1024);
+   mSchedule.reserve(1024);
+   mAudioPollers.reserve(1024);
+}
+
+Transport::~Transport()
+{
+   //audio has stopped by the time the transport goes away
+   ApplyPendingChanges();
+   for (auto* info : mListeners)
+      delete info;
+   for (PendingChange* applied = mAppliedChanges.exchange(nullptr); applied != nullptr;)
+   {
+      PendingChange* next = applied->mNext;
+      DeleteChange(applied);
+      applied = next;
+   }
+   for (auto* change : mRetiredChanges)
+      DeleteChange(change);
 }
 
 void Transport::SetRandomTempo()
@@ -116,6 +141,9 @@ void Transport::KeyPressed(int key, bool isRepeat)
 
 void Transport::Advance(double ms)
 {
+   if (mMeasureTime != mLastAdvancedMeasureTime) //something moved the playhead since the last buffer
+      mScheduleInvalid = true;
+
    if (mNudgeFactor != 0)
    {
       const float kNudgePower = .05f;
@@ -140,6 +168,7 @@ void Transport::Advance(double ms)
       if (mQueuedMeasure != -1)
       {
          SetMeasure(mQueuedMeasure);
+         mScheduleInvalid = true;
          if (mLoopStartMeasure != -1)
             mQueuedMeasure = mLoopStartMeasure;
          else
@@ -151,8 +180,10 @@ void Transport::Advance(double ms)
       TheChaosEngine->AudioUpdate();
 
    UpdateListeners(ms);
+   mLastAdvancedMeasureTime = mMeasureTime;
 
-   for (std::list<IAudioPoller*>::iterator i = mAudioPollers.begin(); i != mAudioPollers.end(); ++i)
+   ApplyPendingChanges();
+   for (auto i = mAudioPollers.rbegin(); i != mAudioPollers.rend(); ++i)
    {
       IAudioPoller* poller = *i;
       poller->OnTransportAdvanced(amount);
@@ -313,33 +344,30 @@ TransportListenerInfo* Transport::AddListener(ITimeListener* listener, NoteInter
    }
    else
    {
-      mListeners.push_front(TransportListenerInfo(listener, interval, offsetInfo, useEventLookahead));
+      info = new TransportListenerInfo(listener, interval, offsetInfo, useEventLookahead);
+      listener->mTransportListenerInfo = info;
+      listener->mTransportListenerGeneration = mListenerGeneration;
+      QueueChange(PendingChange::Type::AddListener, info, nullptr);
    }
 
-   return GetListenerInfo(listener);
+   return info;
 }
 
 TransportListenerInfo* Transport::GetListenerInfo(ITimeListener* listener)
 {
-   for (std::list<TransportListenerInfo>::iterator i = mListeners.begin(); i != mListeners.end(); ++i)
-   {
-      TransportListenerInfo& info = *i;
-      if (info.mListener == listener)
-         return &info;
-   }
-   return nullptr;
+   if (listener->mTransportListenerGeneration != mListenerGeneration)
+      return nullptr; //handed out before ClearListenersAndPollers()
+   return listener->mTransportListenerInfo;
 }
 
 void Transport::RemoveListener(ITimeListener* listener)
 {
-   for (std::list<TransportListenerInfo>::iterator i = mListeners.begin(); i != mListeners.end();)
-   {
-      TransportListenerInfo& info = *i;
-      if (info.mListener == listener)
-         i = mListeners.erase(i);
-      else
-         ++i;
-   }
+   TransportListenerInfo* info = GetListenerInfo(listener);
+   if (info == nullptr)
+      return;
+
+   listener->mTransportListenerInfo = nullptr;
+   QueueChange(PendingChange::Type::RemoveListener, info, nullptr);
 }
 
 void Transport::AddAudioPoller(IAudioPoller* poller)
@@ -351,19 +379,122 @@ void Transport::AddAudioPoller(IAudioPoller* poller)
       assert(module->IsInitialized());
 #endif
 
-   if (!ListContains(poller, mAudioPollers))
-      mAudioPollers.push_front(poller);
+   QueueChange(PendingChange::Type::AddAudioPoller, nullptr, poller);
 }
 
 void Transport::RemoveAudioPoller(IAudioPoller* poller)
 {
-   mAudioPollers.remove(poller);
+   if (poller != nullptr)
+      QueueChange(PendingChange::Type::RemoveAudioPoller, nullptr, poller);
 }
 
 void Transport::ClearListenersAndPollers()
 {
-   mListeners.clear();
-   mAudioPollers.clear();
+   ++mListenerGeneration;
+   QueueChange(PendingChange::Type::Clear, nullptr, nullptr);
+}
+
+void Transport::QueueChange(PendingChange::Type type, TransportListenerInfo* info, IAudioPoller* poller)
+{
+   PendingChange* change = new PendingChange();
+   change->mType = type;
+   change->mInfo = info;
+   change->mPoller = poller;
+   change->mNext = mPendingChanges.load();
+   while (!mPendingChanges.compare_exchange_weak(change->mNext, change))
+   {
+   }
+}
+
+void Transport::ApplyPendingChanges()
+{
+   //the stack has the newest change on top, flip it so they get applied in the order they were made
+   PendingChange* oldestFirst = nullptr;
+   for (PendingChange* pending = mPendingChanges.exchange(nullptr); pending != nullptr;)
+   {
+      PendingChange* next = pending->mNext;
+      pending->mNext = oldestFirst;
+      oldestFirst = pending;
+      pending = next;
+   }
+
+   while (oldestFirst != nullptr)
+   {
+      PendingChange* change = oldestFirst;
+      oldestFirst = change->mNext;
+
+      switch (change->mType)
+      {
+         case PendingChange::Type::AddListener:
+            mListeners.push_back(change->mInfo);
+            mScheduleDirty = true;
+            break;
+         case PendingChange::Type::RemoveListener:
+            RemoveFromVector(change->mInfo, mListeners);
+            change->mRetiredInfos = change->mInfo;
+            mScheduleDirty = true;
+            break;
+         case PendingChange::Type::AddAudioPoller:
+            if (!VectorContains(change->mPoller, mAudioPollers))
+               mAudioPollers.push_back(change->mPoller);
+            break;
+         case PendingChange::Type::RemoveAudioPoller:
+            RemoveFromVector(change->mPoller, mAudioPollers);
+            break;
+         case PendingChange::Type::Clear:
+            for (auto* info : mListeners)
+            {
+               info->mNextRetired = change->mRetiredInfos;
+               change->mRetiredInfos = info;
+            }
+            mListeners.clear();
+            mAudioPollers.clear();
+            mScheduleDirty = true;
+            break;
+      }
+
+      //mSchedule might still point at a removed listener until it's rebuilt, so don't free anything here
+      change->mAppliedAt = AudioThreadEpoch::GetCompletedBuffers();
+      change->mNext = mAppliedChanges.load();
+      while (!mAppliedChanges.compare_exchange_weak(change->mNext, change))
+      {
+      }
+   }
+}
+
+void Transport::CollectGarbage()
+{
+   for (PendingChange* applied = mAppliedChanges.exchange(nullptr); applied != nullptr;)
+   {
+      PendingChange* next = applied->mNext;
+      mRetiredChanges.push_back(applied);
+      applied = next;
+   }
+
+   for (auto iter = mRetiredChanges.begin(); iter != mRetiredChanges.end();)
+   {
+      if (AudioThreadEpoch::HasMovedPast((*iter)->mAppliedAt))
+      {
+         DeleteChange(*iter);
+         iter = mRetiredChanges.erase(iter);
+      }
+      else
+      {
+         ++iter;
+      }
+   }
+}
+
+//static
+void Transport::DeleteChange(PendingChange* change)
+{
+   for (TransportListenerInfo* info = change->mRetiredInfos; info != nullptr;)
+   {
+      TransportListenerInfo* next = info->mNextRetired;
+      delete info;
+      info = next;
+   }
+   delete change;
 }
 
 int Transport::GetQuantized(double time, const TransportListenerInfo* listenerInfo, double* remainderMs /*=nullptr*/)
@@ -635,62 +766,221 @@ double Transport::GetMeasureFraction(NoteInterval interval)
 
 void Transport::UpdateListeners(double jumpMs)
 {
-   std::list<int> priorities;
-   for (const auto& info : mListeners)
+   //rather than asking every listener for its quantized step every buffer, each listener remembers the earliest
+   //measure time its step could change again, and is skipped until the transport gets there. that keeps the cost
+   //of big patches down to the listeners that actually have something due.
+   if (!IsScheduleGridUnchanged())
    {
-      if (info.mListener != nullptr && !ListContains(info.mListener->mTransportPriority, priorities))
-         priorities.push_back(info.mListener->mTransportPriority);
+      mScheduleInvalid = true;
+      mScheduledTimeSigTop = mTimeSigTop;
+      mScheduledTimeSigBottom = mTimeSigBottom;
+      mScheduledSwing = mSwing;
+      mScheduledSwingInterval = mSwingInterval;
    }
 
-   priorities.sort();
+   ++mUpdateCount;
+   const double msPerBar = MsPerBar();
+   const double kUnscheduled = std::numeric_limits<double>::lowest();
 
-   for (const auto& priority : priorities)
+   bool restart = true;
+   while (restart)
    {
-      for (const auto& info : mListeners)
+      restart = false;
+      ApplyPendingChanges();
+      if (mScheduleDirty)
+      {
+         mScheduleDirty = false;
+         RebuildSchedule();
+      }
+
+      for (TransportListenerInfo* info : mSchedule)
       {
-         if (info.mListener != nullptr &&
-             info.mListener->mTransportPriority == priority &&
-             info.mInterval != kInterval_None &&
-             info.mInterval != kInterval_Free)
+         if (info->mLastUpdate == mUpdateCount)
+            continue; //already handled before a listener was added or removed mid-update
+         info->mLastUpdate = mUpdateCount;
+
+         if (info->mListener == nullptr ||
+             info->mInterval == kInterval_None ||
+             info->mInterval == kInterval_Free)
+            continue;
+
+         if (info->mListener->mTransportPriority != info->mScheduledPriority)
+            mScheduleDirty = true; //resort, but still handle it this time around
+
+         double lookaheadMs = jumpMs;
+         if (info->mUseEventLookahead)
+            lookaheadMs = MAX(lookaheadMs, GetEventLookaheadMs());
+
+         double checkTime = gTime + lookaheadMs;
+
+         double offsetMeasures = info->mOffsetInfo.mOffsetIsInMs ? info->mOffsetInfo.mOffset / msPerBar : info->mOffsetInfo.mOffset;
+         if (mScheduleInvalid ||
+             info->mInterval != info->mScheduledInterval ||
+             offsetMeasures != info->mScheduledOffsetMeasures ||
+             info->mCustomDivisor != info->mScheduledCustomDivisor)
          {
-            double lookaheadMs = jumpMs;
-            if (info.mUseEventLookahead)
-               lookaheadMs = MAX(lookaheadMs, GetEventLookaheadMs());
-
-            double checkTime = gTime + lookaheadMs;
-
-            double remainderMs;
-            int oldStep = GetQuantized(checkTime - jumpMs, &info);
-            int newStep = GetQuantized(checkTime, &info, &remainderMs);
-            bool oldJumped = IsPastQueuedMeasureJump(checkTime - jumpMs);
-            bool newJumped = IsPastQueuedMeasureJump(checkTime);
-            if (oldStep != newStep ||
-                oldJumped != newJumped)
+            info->mNextDueMeasure = kUnscheduled;
+            info->mScheduledInterval = info->mInterval;
+            info->mScheduledOffsetMeasures = offsetMeasures;
+            info->mScheduledCustomDivisor = info->mCustomDivisor;
+         }
+
+         //same as GetMeasureTimeInternal(checkTime + offsetMs)
+         double endMeasure = mMeasureTime + lookaheadMs / msPerBar + offsetMeasures;
+         //past a queued jump GetQuantized() remaps the measure time, so the schedule doesn't apply there
+         bool pastQueuedJump = mQueuedMeasure != -1 && MAX(endMeasure, endMeasure - offsetMeasures) >= mJumpFromMeasure;
+         if (!pastQueuedJump && endMeasure < info->mNextDueMeasure)
+            continue;
+
+         double remainderMs;
+         int oldStep = GetQuantized(checkTime - jumpMs, info);
+         int newStep = GetQuantized(checkTime, info, &remainderMs);
+         bool oldJumped = IsPastQueuedMeasureJump(checkTime - jumpMs);
+         bool newJumped = IsPastQueuedMeasureJump(checkTime);
+         if (oldStep != newStep ||
+             oldJumped != newJumped)
+         {
+            if (pastQueuedJump)
+               info->mNextDueMeasure = kUnscheduled;
+            else
+               info->mNextDueMeasure = GetEarliestNextStepMeasure(*info, endMeasure - jumpMs / msPerBar, endMeasure);
+
+            double time = checkTime - remainderMs + .0001; //TODO(Ryan) investigate this fudge number. I would think that subtracting remainderMs from checkTime would give me a number that gives me the same GetQuantized() result with a zero remainder, but sometimes it is just short of the correct quantization
+            /*ofLog() << oldStep << " " << newStep << " " << remainderMs << " " << jumpMs << " " << checkTime << " " << time << " " << GetQuantized(checkTime, info.mInterval) << " " << GetQuantized(time, info.mInterval);
+            if (GetQuantized(checkTime + offsetMs, info.mInterval) != GetQuantized(time + offsetMs, info.mInterval))
             {
-               double time = checkTime - remainderMs + .0001; //TODO(Ryan) investigate this fudge number. I would think that subtracting remainderMs from checkTime would give me a number that gives me the same GetQuantized() result with a zero remainder, but sometimes it is just short of the correct quantization
-               /*ofLog() << oldStep << " " << newStep << " " << remainderMs << " " << jumpMs << " " << checkTime << " " << time << " " << GetQuantized(checkTime, info.mInterval) << " " << GetQuantized(time, info.mInterval);
-               if (GetQuantized(checkTime + offsetMs, info.mInterval) != GetQuantized(time + offsetMs, info.mInterval))
-               {
-                  double aboveRemainderMs;
-                  GetQuantized(checkTime + offsetMs, info.mInterval, &aboveRemainderMs);
-                  double remainderShouldBeZeroMs;
-                  GetQuantized(time + offsetMs, info.mInterval, &remainderShouldBeZeroMs);
-                  ofLog() << remainderShouldBeZeroMs;
-               }*/
-               //assert(GetQuantized(checkTime + offsetMs, info.mInterval) == GetQuantized(time + offsetMs, info.mInterval));
-               info.mListener->OnTimeEvent(time);
-            }
+               double aboveRemainderMs;
+               GetQuantized(checkTime + offsetMs, info.mInterval, &aboveRemainderMs);
+               double remainderShouldBeZeroMs;
+               GetQuantized(time + offsetMs, info.mInterval, &remainderShouldBeZeroMs);
+               ofLog() << remainderShouldBeZeroMs;
+            }*/
+            //assert(GetQuantized(checkTime + offsetMs, info.mInterval) == GetQuantized(time + offsetMs, info.mInterval));
+            info->mListener->OnTimeEvent(time);
+         }
+
+         if (mScheduleDirty || mPendingChanges.load() != nullptr)
+         {
+            //the listener added or removed something, pick that up before going on
+            restart = true;
+            break;
          }
       }
    }
+
+   mScheduleInvalid = false;
+}
+
+void Transport::RebuildSchedule()
+{
+   //only allocates when we have more listeners than ever before
+   mSchedule.clear();
+   int order = 0;
+   for (auto i = mListeners.rbegin(); i != mListeners.rend(); ++i)
+   {
+      TransportListenerInfo* info = *i;
+      info->mScheduleOrder = order++;
+      info->mScheduledPriority = info->mListener != nullptr ? info->mListener->mTransportPriority : 0;
+      mSchedule.push_back(info);
+   }
+
+   //listeners with the same priority go newest first, like they always have
+   std::sort(mSchedule.begin(), mSchedule.end(), [](const TransportListenerInfo* a, const TransportListenerInfo* b)
+             {
+                if (a->mScheduledPriority != b->mScheduledPriority)
+                   return a->mScheduledPriority < b->mScheduledPriority;
+                return a->mScheduleOrder < b->mScheduleOrder;
+             });
+}
+
+bool Transport::IsScheduleGridUnchanged() const
+{
+   //tempo isn't part of this: the schedule is kept in measures, and ms offsets are checked per listener
+   return mTimeSigTop == mScheduledTimeSigTop &&
+          mTimeSigBottom == mScheduledTimeSigBottom &&
+          mSwing == mScheduledSwing &&
+          mSwingInterval == mScheduledSwingInterval;
+}
+
+//a listener's step just changed somewhere after startMeasure (its offset included). this finds the earliest
+//measure time its step could change again, by taking the shortest a step can get once swing is applied.
+double Transport::GetEarliestNextStepMeasure(const TransportListenerInfo& info, double startMeasure, double endMeasure)
+{
+   const double kUnscheduled = std::numeric_limits<double>::lowest();
+
+   if (startMeasure < 0)
+      return kUnscheduled; //GetMeasurePos() goes negative before the first measure, don't try to reason about that
+
+   double swingDenominator = (double)mSwing * mSwing - mSwing;
+   if (swingDenominator == 0)
+      return kUnscheduled;
+   double swingTerm = fabs((.5 - mSwing) / swingDenominator); //see SwingBeat()
+   if (swingTerm >= 1)
+      return kUnscheduled; //swing stops being monotonic
+   double maxSwingSlope = 1 + swingTerm;
+   double timeSigRatio = double(mTimeSigTop) / mTimeSigBottom;
+
+   double minStep;
+   bool wrapsEachMeasure = true; //steps that restart at each measure can change early at the barline
+   bool barlineShiftsGrid = false; //dotted steps don't line up with the barline, so the next one could be right after it
+   switch (info.mInterval)
+   {
+      case kInterval_1n:
+      case kInterval_2:
+      case kInterval_3:
+      case kInterval_4:
+      case kInterval_8:
+      case kInterval_16:
+      case kInterval_32:
+      case kInterval_64:
+         minStep = GetMeasureFraction(info.mInterval);
+         wrapsEachMeasure = false;
+         break;
+      case kInterval_2n:
+      case kInterval_2nt:
+      case kInterval_4n:
+      case kInterval_4nt:
+      case kInterval_8n:
+      case kInterval_8nt:
+      case kInterval_16n:
+      case kInterval_16nt:
+      case kInterval_32n:
+      case kInterval_32nt:
+      case kInterval_64n:
+         minStep = 1.0 / (timeSigRatio * CountInStandardMeasure(info.mInterval) * maxSwingSlope);
+         break;
+      case kInterval_4nd:
+      case kInterval_8nd:
+      case kInterval_16nd:
+         minStep = GetMeasureFraction(info.mInterval) / (timeSigRatio * maxSwingSlope);
+         barlineShiftsGrid = true;
+         break;
+      case kInterval_CustomDivisor:
+         if (info.mCustomDivisor <= 0)
+            return kUnscheduled;
+         minStep = 1.0 / (info.mCustomDivisor * maxSwingSlope);
+         break;
+      default:
+         return kUnscheduled;
+   }
+
+   if (barlineShiftsGrid && floor(endMeasure) > floor(startMeasure))
+      return kUnscheduled;
+
+   double nextStep = startMeasure + minStep;
+   if (wrapsEachMeasure)
+      nextStep = MIN(nextStep, floor(endMeasure) + 1);
+
+   const double kRoundingMargin = .000001; //don't let rounding differences with GetQuantized() make us late
+   return nextStep - kRoundingMargin;
 }
 
 void Transport::OnDrumEvent(NoteInterval drumEvent)
 {
-   for (const auto& info : mListeners)
+   for (const auto* info : mListeners)
    {
-      if (info.mInterval == drumEvent)
-         info.mListener->OnTimeEvent(0); //TODO(Ryan) calc sample offset
+      if (info->mInterval == drumEvent)
+         info->mListener->OnTimeEvent(0); //TODO(Ryan) calc sample offset
    }
 }
 
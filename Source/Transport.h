@@ -26,7 +26,10 @@
 #ifndef __modularSynth__Transport__
 #define __modularSynth__Transport__
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 #include "IDrawableModule.h"
 #include "Slider.h"
 #include "ClickButton.h"
@@ -34,12 +37,19 @@
 #include "Checkbox.h"
 #include "IAudioPoller.h"
 
+struct TransportListenerInfo;
+
 class ITimeListener
 {
 public:
    virtual ~ITimeListener() {}
    virtual void OnTimeEvent(double time) = 0;
    int mTransportPriority{ 100 };
+
+private:
+   friend class Transport;
+   TransportListenerInfo* mTransportListenerInfo{ nullptr }; //what Transport::AddListener() handed out
+   unsigned int mTransportListenerGeneration{ 0 }; //mTransportListenerInfo is stale if this doesn't match the transport's
 };
 
 enum NoteInterval
@@ -95,12 +105,27 @@ struct TransportListenerInfo
    OffsetInfo mOffsetInfo;
    bool mUseEventLookahead{ false };
    int mCustomDivisor{ 8 };
+
+private:
+   friend class Transport;
+
+   //scheduling state, owned by Transport::UpdateListeners(). modules change the fields above whenever they like,
+   //so the schedule remembers what it was computed from and starts over for this listener if they differ
+   double mNextDueMeasure{ 0 }; //earliest (offset) measure time that our step could change again
+   NoteInterval mScheduledInterval{ NoteInterval::kInterval_None };
+   double mScheduledOffsetMeasures{ 0 };
+   int mScheduledCustomDivisor{ 0 };
+   int mScheduledPriority{ 0 };
+   int mScheduleOrder{ 0 };
+   unsigned int mLastUpdate{ 0 };
+   TransportListenerInfo* mNextRetired{ nullptr };
 };
 
 class Transport : public IDrawableModule, public IButtonListener, public IFloatSliderListener, public IDropdownListener
 {
 public:
    Transport();
+   ~Transport() override;
 
    void CreateUIControls() override;
    void Poll() override;
@@ -124,6 +149,7 @@ public:
    void AddAudioPoller(IAudioPoller* poller);
    void RemoveAudioPoller(IAudioPoller* poller);
    void ClearListenersAndPollers();
+   void CollectGarbage();
    double GetDuration(NoteInterval interval);
    int GetQuantized(double time, const TransportListenerInfo* listenerInfo, double* remainderMs = nullptr);
    double GetMeasurePos(double time) const { return fmod(GetMeasureTime(time), 1); }
@@ -181,7 +207,35 @@ public:
    bool IsEnabled() const override { return true; }
 
 private:
+   //listeners and pollers get added and removed from any thread, but only the audio thread walks them. changes are
+   //pushed onto a lock-free stack, applied by Advance(), and freed by CollectGarbage() once the audio thread is done.
+   //a removal takes effect from the audio thread's next buffer, so whoever deletes a listener has to wait that long
+   struct PendingChange
+   {
+      enum class Type
+      {
+         AddListener,
+         RemoveListener,
+         AddAudioPoller,
+         RemoveAudioPoller,
+         Clear
+      };
+
+      Type mType{ Type::Clear };
+      TransportListenerInfo* mInfo{ nullptr };
+      IAudioPoller* mPoller{ nullptr };
+      TransportListenerInfo* mRetiredInfos{ nullptr }; //deleted along with this change
+      uint64_t mAppliedAt{ 0 };
+      PendingChange* mNext{ nullptr };
+   };
+
+   void QueueChange(PendingChange::Type type, TransportListenerInfo* info, IAudioPoller* poller);
+   void ApplyPendingChanges();
+   static void DeleteChange(PendingChange* change);
    void UpdateListeners(double jumpMs);
+   void RebuildSchedule();
+   bool IsScheduleGridUnchanged() const;
+   double GetEarliestNextStepMeasure(const TransportListenerInfo& info, double startMeasure, double endMeasure);
    double Swing(double measurePos);
    double SwingBeat(double pos);
    void Nudge(double amount);
@@ -223,8 +277,21 @@ private:
    bool mWantSetRandomTempo{ false };
    float mNudgeFactor{ 0 };
 
-   std::list<TransportListenerInfo> mListeners;
-   std::list<IAudioPoller*> mAudioPollers;
+   std::vector<TransportListenerInfo*> mListeners; //audio thread only, oldest first
+   std::vector<TransportListenerInfo*> mSchedule; //mListeners in the order they get OnTimeEvent(), sorted by priority
+   bool mScheduleDirty{ true }; //listeners were added or removed
+   bool mScheduleInvalid{ true }; //the playhead jumped, so every listener needs to be checked again
+   unsigned int mUpdateCount{ 0 };
+   double mLastAdvancedMeasureTime{ 0 };
+   int mScheduledTimeSigTop{ 0 };
+   int mScheduledTimeSigBottom{ 0 };
+   float mScheduledSwing{ 0 };
+   int mScheduledSwingInterval{ 0 };
+   std::vector<IAudioPoller*> mAudioPollers; //audio thread only, oldest first
+   std::atomic<PendingChange*> mPendingChanges{ nullptr }; //newest first
+   std::atomic<PendingChange*> mAppliedChanges{ nullptr };
+   std::vector<PendingChange*> mRetiredChanges; //main thread, waiting for the audio thread to finish with them
+   std::atomic<unsigned int> mListenerGeneration{ 0 }; //bumped by ClearListenersAndPollers()
 };
 
 extern Transport* TheTransport;
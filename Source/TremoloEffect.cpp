@@ -71,16 +71,17 @@ void TremoloEffect::ProcessAudio(double time, ChannelBuffer* buffer)
    if (!mEnabled)
       return;
 
-   float bufferSize = buffer->BufferSize();
+   int bufferSize = buffer->BufferSize();
 
    ComputeSliders(0);
 
    if (mAmount > 0)
    {
+      mLFO.FillBuffer(gWorkBuffer, bufferSize, kAntiPopWindowSize / 2);
       for (int i = 0; i < bufferSize; ++i)
       {
          //smooth out LFO a bit to avoid pops with square/saw LFOs
-         mWindow[mWindowPos] = mLFO.Value(i + kAntiPopWindowSize / 2);
+         mWindow[mWindowPos] = gWorkBuffer[i];
          mWindowPos = (mWindowPos + 1) % kAntiPopWindowSize;
          float lfoVal = 0;
          for (int j = 0; j < kAntiPopWindowSize; ++j)
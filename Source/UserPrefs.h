@@ -295,7 +295,11 @@ public:
    UserPrefDropdownString audio_input_device{ "audio_input_device", "none", 350, UserPrefCategory::General };
    UserPrefDropdownInt samplerate{ "samplerate", 48000, 100, UserPrefCategory::General };
    UserPrefDropdownInt buffersize{ "buffersize", 256, 100, UserPrefCategory::General };
+   UserPrefTextEntryInt internal_buffersize{ "internal_buffersize", 0, 0, 4096, 4, UserPrefCategory::General };
    UserPrefDropdownInt oversampling{ "oversampling", 1, 100, UserPrefCategory::General };
+   UserPrefDropdownString oversampling_quality{ "oversampling_quality", "balanced", 100, UserPrefCategory::General };
+   UserPrefBool batch_voices{ "batch_voices", true, UserPrefCategory::General };
+   UserPrefTextEntryInt audio_threads{ "audio_threads", 1, 1, 64, 2, UserPrefCategory::General };
    UserPrefTextEntryInt width{ "width", 1700, 100, 10000, 5, UserPrefCategory::General };
    UserPrefTextEntryInt height{ "height", 1100, 100, 10000, 5, UserPrefCategory::General };
    UserPrefBool set_manual_window_position{ "set_manual_window_position", false, UserPrefCategory::General };
@@ -313,6 +317,11 @@ public:
    UserPrefBool show_minimap{ "show_minimap", false, UserPrefCategory::General };
    UserPrefBool immediate_paste{ "immediate_paste", false, UserPrefCategory::General };
    UserPrefTextEntryFloat record_buffer_length_minutes{ "record_buffer_length_minutes", 30, 1, 120, 5, UserPrefCategory::General };
+   UserPrefDropdownString record_buffer_format{ "record_buffer_format", "wav", 70, UserPrefCategory::General };
+   UserPrefDropdownString record_buffer_bit_depth{ "record_buffer_bit_depth", "16", 70, UserPrefCategory::General };
+   UserPrefTextEntryInt sample_memory_limit_mb{ "sample_memory_limit_mb", 512, 1, 65536, 5, UserPrefCategory::General };
+   UserPrefDropdownString sample_interpolation{ "sample_interpolation", "sinc 16", 100, UserPrefCategory::General };
+   UserPrefTextEntryInt sample_cache_mb{ "sample_cache_mb", 4096, 0, 1048576, 7, UserPrefCategory::General };
 #if !BESPOKE_LINUX
    UserPrefBool vst_always_on_top{ "vst_always_on_top", true, UserPrefCategory::General };
 #endif
@@ -30,6 +30,9 @@
 #include "SynthGlobals.h"
 #include "UserPrefs.h"
 #include "PatchCable.h"
+#include "Oversampler.h"
+#include "Resampler.h"
+#include "RecordingStream.h"
 
 #include "juce_audio_devices/juce_audio_devices.h"
 #include "juce_gui_basics/juce_gui_basics.h"
@@ -67,6 +70,24 @@ void UserPrefsEditor::CreateUIControls()
          UserPrefs.oversampling.GetIndex() = oversample;
    }
 
+   UserPrefs.oversampling_quality.GetIndex() = (int)Oversampler::Quality::Balanced;
+   for (int i = 0; i < (int)Oversampler::Quality::Count; ++i)
+   {
+      std::string label = Oversampler::GetQualityName((Oversampler::Quality)i);
+      UserPrefs.oversampling_quality.GetDropdown()->AddLabel(label, i);
+      if (label == UserPrefs.oversampling_quality.Get())
+         UserPrefs.oversampling_quality.GetIndex() = i;
+   }
+
+   UserPrefs.sample_interpolation.GetIndex() = (int)Resampler::Quality::Sinc16;
+   for (int i = 0; i < (int)Resampler::Quality::Count; ++i)
+   {
+      std::string label = Resampler::GetQualityName((Resampler::Quality)i);
+      UserPrefs.sample_interpolation.GetDropdown()->AddLabel(label, i);
+      if (label == UserPrefs.sample_interpolation.Get())
+         UserPrefs.sample_interpolation.GetIndex() = i;
+   }
+
    UserPrefs.cable_drop_behavior.GetIndex() = 0;
    UserPrefs.cable_drop_behavior.GetDropdown()->AddLabel("show quickspawn", (int)CableDropBehavior::ShowQuickspawn);
    UserPrefs.cable_drop_behavior.GetDropdown()->AddLabel("do nothing", (int)CableDropBehavior::DoNothing);
@@ -76,6 +97,26 @@ void UserPrefsEditor::CreateUIControls()
       if (UserPrefs.cable_drop_behavior.GetDropdown()->GetElement(i).mLabel == UserPrefs.cable_drop_behavior.Get())
          UserPrefs.cable_drop_behavior.GetIndex() = i;
    }
+
+   UserPrefs.record_buffer_format.GetIndex() = (int)RecordingStream::Format::Wav;
+   UserPrefs.record_buffer_format.GetDropdown()->AddLabel("wav", (int)RecordingStream::Format::Wav);
+   UserPrefs.record_buffer_format.GetDropdown()->AddLabel("flac", (int)RecordingStream::Format::Flac);
+   for (int i = 0; i < UserPrefs.record_buffer_format.GetDropdown()->GetNumValues(); ++i)
+   {
+      if (UserPrefs.record_buffer_format.GetDropdown()->GetElement(i).mLabel == UserPrefs.record_buffer_format.Get())
+         UserPrefs.record_buffer_format.GetIndex() = i;
+   }
+
+   //ModularSynth::SaveOutput() goes by the index
+   UserPrefs.record_buffer_bit_depth.GetIndex() = 0;
+   UserPrefs.record_buffer_bit_depth.GetDropdown()->AddLabel("16", 0);
+   UserPrefs.record_buffer_bit_depth.GetDropdown()->AddLabel("24", 1);
+   UserPrefs.record_buffer_bit_depth.GetDropdown()->AddLabel("32 float", 2);
+   for (int i = 0; i < UserPrefs.record_buffer_bit_depth.GetDropdown()->GetNumValues(); ++i)
+   {
+      if (UserPrefs.record_buffer_bit_depth.GetDropdown()->GetElement(i).mLabel == UserPrefs.record_buffer_bit_depth.Get())
+         UserPrefs.record_buffer_bit_depth.GetIndex() = i;
+   }
 }
 
 void UserPrefsEditor::Show()
@@ -233,7 +274,7 @@ void UserPrefsEditor::UpdateDropdowns(std::vector<DropdownList*> toUpdate)
       for (auto bufferSize : selectedDevice->getAvailableBufferSizes())
       {
          UserPrefs.buffersize.GetDropdown()->AddLabel(ofToString(bufferSize), i);
-         if (bufferSize == gBufferSize / UserPrefs.oversampling.Get())
+         if (bufferSize == UserPrefs.buffersize.Get())
             UserPrefs.buffersize.GetIndex() = i;
          ++i;
       }
@@ -261,6 +302,8 @@ void UserPrefsEditor::DrawModule()
          hide = !selectedDeviceType->hasSeparateInputsAndOutputs();
       if (pref == &UserPrefs.position_x || pref == &UserPrefs.position_y)
          hide = !UserPrefs.set_manual_window_position.Get();
+      if (pref == &UserPrefs.oversampling_quality)
+         hide = UserPrefs.oversampling.GetIndex() <= 1;
 
       pref->GetControl()->SetShowing(onPage && !hide);
 
@@ -326,6 +369,11 @@ void UserPrefsEditor::DrawModule()
       DrawRightLabel(UserPrefs.position_x.GetControl(), "(currently: " + ofToString(pos.x) + ")", ofColor::white);
    }
 
+   if (UserPrefs.oversampling.GetIndex() > 1 && UserPrefs.oversampling_quality.GetIndex() != -1)
+   {
+      DrawRightLabel(UserPrefs.oversampling_quality.GetControl(), "(adds ~" + ofToString(GetOversamplingLatency(), 1) + " samples of latency to output and input)", ofColor::white);
+   }
+   DrawRightLabel(UserPrefs.audio_threads.GetControl(), "(cpu cores: " + ofToString(juce::SystemStats::getNumCpus()) + ")", ofColor::white);
    DrawRightLabel(UserPrefs.zoom.GetControl(), "(currently: " + ofToString(gDrawScale) + ")", ofColor::white);
    DrawRightLabel(UserPrefs.recordings_path.GetControl(), "(default: " + UserPrefs.recordings_path.GetDefault() + ")", ofColor::white);
    DrawRightLabel(UserPrefs.tooltips.GetControl(), "(default: " + UserPrefs.tooltips.GetDefault() + ")", ofColor::white);
@@ -337,6 +385,22 @@ void UserPrefsEditor::DrawModule()
       DrawRightLabel(mCancelButton, "*requires restart before taking effect", ofColor::magenta, 4);
 }
 
+float UserPrefsEditor::GetOversamplingLatency()
+{
+   //setting up an oversampler designs its filters, so only do it when the prefs it depends on change
+   int amount = UserPrefs.oversampling.GetIndex();
+   int quality = UserPrefs.oversampling_quality.GetIndex();
+   if (amount != mOversamplingLatencyAmount || quality != mOversamplingLatencyQuality)
+   {
+      Oversampler oversampler;
+      oversampler.Setup(amount, 1, (Oversampler::Quality)quality);
+      mOversamplingLatency = oversampler.GetLatency();
+      mOversamplingLatencyAmount = amount;
+      mOversamplingLatencyQuality = quality;
+   }
+   return mOversamplingLatency;
+}
+
 void UserPrefsEditor::DrawRightLabel(IUIControl* control, std::string text, ofColor color, float offsetX)
 {
    if (control->IsShowing())
@@ -362,10 +426,14 @@ bool UserPrefsEditor::PrefRequiresRestart(UserPref* pref) const
           pref == &UserPrefs.audio_input_device ||
           pref == &UserPrefs.samplerate ||
           pref == &UserPrefs.buffersize ||
+          pref == &UserPrefs.internal_buffersize ||
           pref == &UserPrefs.oversampling ||
+          pref == &UserPrefs.oversampling_quality ||
+          pref == &UserPrefs.audio_threads ||
           pref == &UserPrefs.max_output_channels ||
           pref == &UserPrefs.max_input_channels ||
           pref == &UserPrefs.record_buffer_length_minutes ||
+          pref == &UserPrefs.sample_interpolation ||
           pref == &UserPrefs.show_minimap;
 }
 
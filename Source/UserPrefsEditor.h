@@ -82,6 +82,7 @@ private:
    void CleanUpSave(std::string& json);
    bool PrefRequiresRestart(UserPref* pref) const;
    void Save();
+   float GetOversamplingLatency();
 
    UserPrefCategory mCategory{ UserPrefCategory::General };
    RadioButton* mCategorySelector{ nullptr };
@@ -90,4 +91,8 @@ private:
 
    float mWidth{ 1150 };
    float mHeight{ 50 };
+
+   int mOversamplingLatencyAmount{ -1 };
+   int mOversamplingLatencyQuality{ -1 };
+   float mOversamplingLatency{ 0 };
 };
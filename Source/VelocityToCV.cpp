@@ -32,6 +32,8 @@
 #include "PatchCableSource.h"
 #include "ModulationChain.h"
 
+#include <algorithm>
+
 VelocityToCV::VelocityToCV()
 {
 }
@@ -80,6 +82,11 @@ float VelocityToCV::Value(int samplesIn)
    return ofMap(mVelocity, 0, 127, GetMin(), GetMax(), K(clamped));
 }
 
+void VelocityToCV::FillBuffer(float* values, int numSamples)
+{
+   std::fill(values, values + numSamples, Value(0)); //velocity only changes on note events
+}
+
 void VelocityToCV::SaveLayout(ofxJSONElement& moduleInfo)
 {
 }
@@ -54,6 +54,7 @@ public:
 
    //IModulator
    virtual float Value(int samplesIn = 0) override;
+   void FillBuffer(float* values, int numSamples) override;
    virtual bool Active() const override { return mEnabled; }
 
    //IPatchable
@@ -27,14 +27,15 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 
+namespace
+{
+   //where the output level sat with 256 sample buffers, back when it overlap-added a 1024 point frame every buffer
+   const float kOutputLevel = 1024 * 1.5f * .0001f;
+}
+
 Vocoder::Vocoder()
 : IAudioProcessor(gBufferSize)
 {
-   // Generate a window with a single raised cosine from N/4 to 3N/4
-   mWindower = new float[VOCODER_WINDOW_SIZE];
-   for (int i = 0; i < VOCODER_WINDOW_SIZE; ++i)
-      mWindower[i] = -.5 * cos(FTWO_PI * i / VOCODER_WINDOW_SIZE) + .5;
-
    mCarrierInputBuffer = new float[GetBuffer()->BufferSize()];
    Clear(mCarrierInputBuffer, GetBuffer()->BufferSize());
 
@@ -54,13 +55,21 @@ void Vocoder::CreateUIControls()
    mWhisperSlider = new FloatSlider(this, "whisper", 5, 119, 100, 15, &mWhisper, 0, 1);
    mPhaseOffsetSlider = new FloatSlider(this, "phase off", 5, 137, 100, 15, &mPhaseOffset, 0, FTWO_PI);
    mCutSlider = new IntSlider(this, "cut", 5, 155, 100, 15, &mCut, 0, 100);
+   mWindowSizeSelector = new DropdownList(this, "window", 5, 173, &mWindowSize);
+   mOverlapSelector = new DropdownList(this, "overlap", 70, 173, &mOverlap);
+   mHelperThreadCheckbox = new Checkbox(this, "thread", 120, 173, &mUseHelperThread);
+
+   for (int size = 256; size <= 4096; size *= 2)
+      mWindowSizeSelector->AddLabel(ofToString(size), size);
+   mOverlapSelector->AddLabel("2", 2);
+   mOverlapSelector->AddLabel("4", 4);
+   mOverlapSelector->AddLabel("8", 8);
 
    mGate.CreateUIControls();
 }
 
 Vocoder::~Vocoder()
 {
-   delete[] mWindower;
    delete[] mCarrierInputBuffer;
 }
 
@@ -106,49 +115,55 @@ void Vocoder::Process(double time)
 
    mGate.ProcessAudio(time, GetBuffer());
 
-   mRollingInputBuffer.WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
-
-   //copy rolling input buffer into working buffer and window it
-   mRollingInputBuffer.ReadChunk(mFFTData.mTimeDomain, VOCODER_WINDOW_SIZE, 0, 0);
-   Mult(mFFTData.mTimeDomain, mWindower, VOCODER_WINDOW_SIZE);
-   Mult(mFFTData.mTimeDomain, inputPreampSq, VOCODER_WINDOW_SIZE);
+   float* input = GetBuffer()->GetChannel(0);
+   float* carrier = gWorkBuffer;
+   float* wet = gWorkBuffer + bufferSize;
 
-   mFFT.Forward(mFFTData.mTimeDomain,
-                mFFTData.mRealValues,
-                mFFTData.mImaginaryValues);
+   Mult(input, inputPreampSq, bufferSize);
 
    if (!fricative)
    {
-      mRollingCarrierBuffer.WriteChunk(mCarrierInputBuffer, bufferSize, 0);
+      BufferCopy(carrier, mCarrierInputBuffer, bufferSize);
    }
    else
    {
       //use noise as carrier signal if it's a fricative
       //but make the noise the same-ish volume as input carrier
       for (int i = 0; i < bufferSize; ++i)
-         mRollingCarrierBuffer.Write(mCarrierInputBuffer[gRandom() % bufferSize] * 2, 0);
+         carrier[i] = mCarrierInputBuffer[gRandom() % bufferSize] * 2;
    }
+   Mult(carrier, carrierPreampSq, bufferSize);
+
+   const float* inputs[] = { input, carrier };
+   mSTFT.Process(inputs, wet, bufferSize);
 
-   //copy rolling carrier buffer into working buffer and window it
-   mRollingCarrierBuffer.ReadChunk(mCarrierFFTData.mTimeDomain, VOCODER_WINDOW_SIZE, 0, 0);
-   Mult(mCarrierFFTData.mTimeDomain, mWindower, VOCODER_WINDOW_SIZE);
-   Mult(mCarrierFFTData.mTimeDomain, carrierPreampSq, VOCODER_WINDOW_SIZE);
+   for (int i = 0; i < bufferSize; ++i)
+      input[i] = input[i] * (1 - mDryWet) + wet[i] * kOutputLevel * volSq * mDryWet;
+
+   Add(target->GetBuffer()->GetChannel(0), input, bufferSize);
 
-   mFFT.Forward(mCarrierFFTData.mTimeDomain,
-                mCarrierFFTData.mRealValues,
-                mCarrierFFTData.mImaginaryValues);
+   GetVizBuffer()->WriteChunk(input, bufferSize, 0);
+
+   GetBuffer()->Reset();
+}
+
+//runs once a hop, possibly on the stft's helper thread
+void Vocoder::ProcessSpectralFrame(FFTData* const* frames, int numInputs)
+{
+   FFTData* modulator = frames[0];
+   const FFTData* carrier = frames[1];
 
-   for (int i = 0; i < FFT_FREQDOMAIN_SIZE; ++i)
+   for (int i = 0; i < modulator->mFreqDomainSize; ++i)
    {
-      float real = mFFTData.mRealValues[i];
-      float imag = mFFTData.mImaginaryValues[i];
+      float real = modulator->mRealValues[i];
+      float imag = modulator->mImaginaryValues[i];
 
       //cartesian to polar
       float amp = 2. * sqrtf(real * real + imag * imag);
       //float phase = atan2(imag,real);
 
-      float carrierReal = mCarrierFFTData.mRealValues[i];
-      float carrierImag = mCarrierFFTData.mImaginaryValues[i];
+      float carrierReal = carrier->mRealValues[i];
+      float carrierImag = carrier->mImaginaryValues[i];
 
       //cartesian to polar
       float carrierAmp = 2. * sqrtf(carrierReal * carrierReal + carrierImag * carrierImag);
@@ -158,7 +173,6 @@ void Vocoder::Process(double time)
       float phase = carrierPhase;
 
       phase += ofRandom(mWhisper * FTWO_PI);
-      mPhaseOffsetSlider->Compute();
       phase = FloatWrap(phase + mPhaseOffset, FTWO_PI);
 
       if (i < mCut) //cut out superbass
@@ -168,31 +182,9 @@ void Vocoder::Process(double time)
       real = amp * cos(phase);
       imag = amp * sin(phase);
 
-      mFFTData.mRealValues[i] = real;
-      mFFTData.mImaginaryValues[i] = imag;
+      modulator->mRealValues[i] = real;
+      modulator->mImaginaryValues[i] = imag;
    }
-
-   mFFT.Inverse(mFFTData.mRealValues,
-                mFFTData.mImaginaryValues,
-                mFFTData.mTimeDomain);
-
-   for (int i = 0; i < bufferSize; ++i)
-      mRollingOutputBuffer.Write(0, 0);
-
-   //copy rolling input buffer into working buffer and window it
-   for (int i = 0; i < VOCODER_WINDOW_SIZE; ++i)
-      mRollingOutputBuffer.Accum(VOCODER_WINDOW_SIZE - i - 1, mFFTData.mTimeDomain[i] * mWindower[i] * .0001f, 0);
-
-   Mult(GetBuffer()->GetChannel(0), (1 - mDryWet) * inputPreampSq, GetBuffer()->BufferSize());
-
-   for (int i = 0; i < bufferSize; ++i)
-      GetBuffer()->GetChannel(0)[i] += mRollingOutputBuffer.GetSample(VOCODER_WINDOW_SIZE - i - 1, 0) * volSq * mDryWet;
-
-   Add(target->GetBuffer()->GetChannel(0), GetBuffer()->GetChannel(0), bufferSize);
-
-   GetVizBuffer()->WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
-
-   GetBuffer()->Reset();
 }
 
 void Vocoder::DrawModule()
@@ -216,6 +208,9 @@ void Vocoder::DrawModule()
    mWhisperSlider->Draw();
    mPhaseOffsetSlider->Draw();
    mCutSlider->Draw();
+   mWindowSizeSelector->Draw();
+   mOverlapSelector->Draw();
+   mHelperThreadCheckbox->Draw();
 
    if (mFricDetected)
    {
@@ -230,12 +225,20 @@ void Vocoder::DrawModule()
    mGate.Draw();
 }
 
+void Vocoder::DropdownUpdated(DropdownList* list, int oldVal, double time)
+{
+   if (list == mWindowSizeSelector || list == mOverlapSelector)
+      mSTFT.SetUp(mWindowSize, mOverlap);
+}
+
 void Vocoder::CheckboxUpdated(Checkbox* checkbox, double time)
 {
    if (checkbox == mEnabledCheckbox)
    {
       mGate.SetEnabled(mEnabled);
    }
+   if (checkbox == mHelperThreadCheckbox)
+      mSTFT.SetUseHelperThread(mUseHelperThread);
 }
 
 void Vocoder::LoadLayout(const ofxJSONElement& moduleInfo)
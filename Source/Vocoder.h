@@ -30,17 +30,14 @@
 #include "IAudioProcessor.h"
 #include "IDrawableModule.h"
 #include "Checkbox.h"
-#include "FFT.h"
-#include "RollingBuffer.h"
+#include "STFT.h"
 #include "Slider.h"
+#include "DropdownList.h"
 #include "GateEffect.h"
 #include "BiquadFilterEffect.h"
 #include "VocoderCarrierInput.h"
 
-#define VOCODER_WINDOW_SIZE 1024
-#define FFT_FREQDOMAIN_SIZE VOCODER_WINDOW_SIZE / 2 + 1
-
-class Vocoder : public IAudioProcessor, public IDrawableModule, public IFloatSliderListener, public VocoderBase, public IIntSliderListener
+class Vocoder : public IAudioProcessor, public IDrawableModule, public IFloatSliderListener, public VocoderBase, public IIntSliderListener, public IDropdownListener, public ISpectralFrameProcessor
 {
 public:
    Vocoder();
@@ -65,6 +62,10 @@ public:
    void CheckboxUpdated(Checkbox* checkbox, double time) override;
    void FloatSliderUpdated(FloatSlider* slider, float oldVal, double time) override {}
    void IntSliderUpdated(IntSlider* slider, int oldVal, double time) override {}
+   void DropdownUpdated(DropdownList* list, int oldVal, double time) override;
+
+   //ISpectralFrameProcessor
+   void ProcessSpectralFrame(FFTData* const* frames, int numInputs) override;
 
    virtual void LoadLayout(const ofxJSONElement& moduleInfo) override;
    virtual void SetUpFromSaveData() override;
@@ -77,21 +78,10 @@ private:
    void GetModuleDimensions(float& w, float& h) override
    {
       w = 235;
-      h = 170;
+      h = 190;
    }
 
-   FFTData mFFTData{ VOCODER_WINDOW_SIZE, FFT_FREQDOMAIN_SIZE };
-
-   float* mWindower{ nullptr };
-
-
-   ::FFT mFFT{ VOCODER_WINDOW_SIZE };
-   RollingBuffer mRollingInputBuffer{ VOCODER_WINDOW_SIZE };
-   RollingBuffer mRollingOutputBuffer{ VOCODER_WINDOW_SIZE };
-
    float* mCarrierInputBuffer{ nullptr };
-   RollingBuffer mRollingCarrierBuffer{ VOCODER_WINDOW_SIZE };
-   FFTData mCarrierFFTData{ VOCODER_WINDOW_SIZE, FFT_FREQDOMAIN_SIZE };
 
    float mInputPreamp{ 1 };
    float mCarrierPreamp{ 1 };
@@ -115,6 +105,15 @@ private:
    GateEffect mGate;
 
    bool mCarrierDataSet{ false };
+
+   int mWindowSize{ 1024 };
+   DropdownList* mWindowSizeSelector{ nullptr };
+   int mOverlap{ 4 };
+   DropdownList* mOverlapSelector{ nullptr };
+   bool mUseHelperThread{ false };
+   Checkbox* mHelperThreadCheckbox{ nullptr };
+
+   STFT mSTFT{ this, 2, mWindowSize, mOverlap }; //last, so it's gone before anything a helper thread frame might be using
 };
 
 
@@ -0,0 +1,464 @@
+/**
+    bespoke synth, a software modular synthesizer
+    Copyright (C) 2022 Ryan Challinor (contact: awwbees@gmail.com)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+//
+//  DspBenchmarks.cpp
+//  Bespoke
+//
+//
+
+//microbenchmarks for the dsp kernels and voices, built as the BespokeBenchmarks target (-DBESPOKE_BUILD_BENCHMARKS=ON).
+//everything runs on the calling thread without a window or an audio device, and the results are written as json:
+//
+//usage: BespokeBenchmarks [--out results.json] [--filter substring] [--samplerate rate] [--seconds per case]
+//
+//"ns_per_sample" is the median over several batches, per voice for the voice cases. "voices_per_core" is how many
+//voices one core could render in realtime at the given sample rate.
+
+#include "ModularSynth.h"
+#include "SynthGlobals.h"
+#include "UserPrefs.h"
+#include "ChannelBuffer.h"
+#include "Oscillator.h"
+#include "BiquadFilter.h"
+#include "FFT.h"
+#include "Convolver.h"
+#include "Resampler.h"
+#include "ADSR.h"
+#include "FMVoice.h"
+#include "KarplusStrongVoice.h"
+#include "SampleVoice.h"
+#include "SingleOscillatorVoice.h"
+#include "ofxJSONElement.h"
+
+#include "juce_audio_devices/juce_audio_devices.h"
+#include "juce_audio_formats/juce_audio_formats.h"
+#include "juce_data_structures/juce_data_structures.h"
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+//VSTScanner expects the app to provide this, see Main.cpp
+juce::ApplicationProperties& getAppProperties()
+{
+   static juce::ApplicationProperties sAppProperties;
+   return sAppProperties;
+}
+
+namespace
+{
+   const int kBufferSizes[] = { 64, 256, 1024 };
+   const int kFFTSizes[] = { 256, 512, 1024, 2048, 4096, 8192 };
+   const int kVoiceCounts[] = { 1, 8, 32 };
+   const int kBatches = 9;
+
+   struct Options
+   {
+      std::string mOutputPath;
+      std::string mFilter;
+      int mSampleRate{ 48000 };
+      double mSecondsPerCase{ .2 };
+   };
+
+   struct Result
+   {
+      std::string mName;
+      int mBufferSize{ 0 };
+      int mVoices{ 0 }; //0 for the kernels that don't involve voices
+      double mNsPerSample{ 0 };
+      double mNsPerSampleMin{ 0 };
+      long long mIterations{ 0 };
+   };
+
+   volatile float sSink = 0; //so the optimizer can't throw away the work
+
+   float Consume(const float* buffer, int size)
+   {
+      float sum = 0;
+      for (int i = 0; i < size; ++i)
+         sum += buffer[i];
+      return sum;
+   }
+
+   class BenchmarkRunner
+   {
+   public:
+      explicit BenchmarkRunner(const Options& options)
+      : mOptions(options)
+      {}
+
+      //process() handles numSamples samples (of every voice) per call
+      void Run(const std::string& name, int bufferSize, int voices, int numSamples, const std::function<void()>& process)
+      {
+         if (!mOptions.mFilter.empty() && name.find(mOptions.mFilter) == std::string::npos)
+            return;
+
+         for (int i = 0; i < 8; ++i)
+            process();
+
+         std::vector<double> batchNsPerSample;
+         long long iterations = 0;
+         const double batchSeconds = mOptions.mSecondsPerCase / kBatches;
+         for (int batch = 0; batch < kBatches; ++batch)
+         {
+            long long batchIterations = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed;
+            do
+            {
+               process();
+               ++batchIterations;
+               elapsed = std::chrono::steady_clock::now() - start;
+            } while (elapsed.count() < batchSeconds);
+            batchNsPerSample.push_back(elapsed.count() * 1e9 / (double(batchIterations) * numSamples * std::max(1, voices)));
+            iterations += batchIterations;
+         }
+         std::sort(batchNsPerSample.begin(), batchNsPerSample.end());
+
+         Result result;
+         result.mName = name;
+         result.mBufferSize = bufferSize;
+         result.mVoices = voices;
+         result.mNsPerSample = batchNsPerSample[kBatches / 2];
+         result.mNsPerSampleMin = batchNsPerSample[0];
+         result.mIterations = iterations;
+         mResults.push_back(result);
+
+         std::cerr << name << " buffer " << bufferSize;
+         if (voices > 0)
+            std::cerr << " voices " << voices;
+         std::cerr << ": " << result.mNsPerSample << " ns/sample" << std::endl;
+      }
+
+      std::string GetJson() const
+      {
+         ofxJSONElement root;
+         root["samplerate"] = mOptions.mSampleRate;
+         root["seconds_per_case"] = mOptions.mSecondsPerCase;
+         root["results"] = Json::Value(Json::arrayValue);
+         for (const auto& result : mResults)
+         {
+            Json::Value entry;
+            entry["name"] = result.mName;
+            entry["buffersize"] = result.mBufferSize;
+            entry["ns_per_sample"] = result.mNsPerSample;
+            entry["ns_per_sample_min"] = result.mNsPerSampleMin;
+            entry["iterations"] = (Json::Int64)result.mIterations;
+            if (result.mVoices > 0)
+            {
+               entry["voices"] = result.mVoices;
+               entry["voices_per_core"] = 1e9 / (result.mNsPerSample * mOptions.mSampleRate);
+            }
+            root["results"].append(entry);
+         }
+         return root.getRawString(true);
+      }
+
+   private:
+      const Options& mOptions;
+      std::vector<Result> mResults;
+   };
+
+   void RunKernelBenchmarks(BenchmarkRunner& runner)
+   {
+      std::vector<float> buffer(kWorkBufferSize);
+
+      const std::pair<OscillatorType, const char*> kOscillatorTypes[] = {
+         { kOsc_Sin, "oscillator_sin" },
+         { kOsc_Square, "oscillator_square" },
+         { kOsc_Tri, "oscillator_tri" },
+         { kOsc_Saw, "oscillator_saw" }
+      };
+      for (const auto& oscillatorType : kOscillatorTypes)
+      {
+         for (int bufferSize : kBufferSizes)
+         {
+            Oscillator osc(oscillatorType.first);
+            float phase = 0;
+            float phaseInc = GetPhaseInc(440);
+            runner.Run(oscillatorType.second, bufferSize, 0, bufferSize, [&]
+                       {
+                          for (int i = 0; i < bufferSize; ++i)
+                          {
+                             buffer[i] = osc.Value(phase);
+                             phase += phaseInc;
+                             if (phase > FTWO_PI)
+                                phase -= FTWO_PI;
+                          }
+                          sSink = sSink + buffer[0];
+                       });
+         }
+      }
+
+      for (int bufferSize : kBufferSizes)
+      {
+         BiquadFilter filter;
+         filter.SetSampleRate(gSampleRate);
+         filter.SetFilterType(kFilterType_Lowpass);
+         filter.SetFilterParams(1000, sqrt(2) / 2);
+         for (int i = 0; i < bufferSize; ++i)
+            buffer[i] = RandomSample();
+         runner.Run("biquad_lowpass", bufferSize, 0, bufferSize, [&]
+                    {
+                       filter.Filter(buffer.data(), bufferSize);
+                       sSink = sSink + buffer[0];
+                    });
+      }
+
+      for (int fftSize : kFFTSizes)
+      {
+         FFT fft(fftSize);
+         std::vector<float> input(fftSize);
+         std::vector<float> real(fftSize / 2 + 1);
+         std::vector<float> imag(fftSize / 2 + 1);
+         for (int i = 0; i < fftSize; ++i)
+            input[i] = RandomSample();
+         runner.Run("fft_forward", fftSize, 0, fftSize, [&]
+                    {
+                       fft.Forward(input.data(), real.data(), imag.data());
+                       sSink = sSink + real[1];
+                    });
+         runner.Run("fft_inverse", fftSize, 0, fftSize, [&]
+                    {
+                       fft.Inverse(real.data(), imag.data(), input.data());
+                       sSink = sSink + input[1];
+                       Mult(input.data(), 1.0f / fftSize, fftSize); //keep the level from growing run after run
+                    });
+      }
+
+      for (int seconds : { 1, 4 })
+      {
+         //the tail partitions run on the convolver's helper thread, and the time spent waiting on it is counted here
+         std::vector<std::vector<float> > impulseResponse(1, std::vector<float>(seconds * gSampleRate));
+         for (auto& sample : impulseResponse[0])
+            sample = RandomSample() * .01f;
+         Convolver convolver(impulseResponse, 1);
+         for (int i = 0; i < kWorkBufferSize; ++i)
+            buffer[i] = RandomSample();
+         std::vector<float> output(kWorkBufferSize);
+         const float* input = buffer.data();
+         float* outputChannel = output.data();
+         for (int bufferSize : kBufferSizes)
+         {
+            runner.Run("convolver_" + ofToString(seconds) + "s", bufferSize, 0, bufferSize, [&]
+                       {
+                          convolver.Process(&input, &outputChannel, 1, bufferSize);
+                          sSink = sSink + output[0];
+                       });
+         }
+      }
+
+      for (int bufferSize : kBufferSizes)
+      {
+         ::ADSR adsr(10, 50, .5f, 100);
+         double time = 0;
+         runner.Run("adsr_value", bufferSize, 0, bufferSize, [&]
+                    {
+                       //restart every buffer so the attack and decay stages get measured, not just the sustain
+                       adsr.Start(time, 1);
+                       for (int i = 0; i < bufferSize; ++i)
+                       {
+                          buffer[i] = adsr.Value(time);
+                          time += gInvSampleRateMs * 4;
+                       }
+                       sSink = sSink + buffer[bufferSize - 1];
+                    });
+      }
+
+      std::vector<float> sampleData(gSampleRate);
+      for (size_t i = 0; i < sampleData.size(); ++i)
+         sampleData[i] = sin(i * .01f);
+      for (int bufferSize : kBufferSizes)
+      {
+         double offset = 0;
+         runner.Run("interpolated_sample", bufferSize, 0, bufferSize, [&]
+                    {
+                       for (int i = 0; i < bufferSize; ++i)
+                       {
+                          buffer[i] = GetInterpolatedSample(offset, sampleData.data(), (int)sampleData.size());
+                          offset += .7317;
+                          if (offset >= sampleData.size())
+                             offset -= sampleData.size();
+                       }
+                       sSink = sSink + buffer[0];
+                    });
+      }
+
+      //same step as above, so these compare directly with interpolated_sample
+      for (int quality = 0; quality < (int)Resampler::Quality::Count; ++quality)
+      {
+         std::string name = std::string("resampler_") + Resampler::GetQualityName((Resampler::Quality)quality);
+         ofStringReplace(name, " ", "");
+         for (int bufferSize : kBufferSizes)
+         {
+            double offset = 0;
+            const float* source = sampleData.data();
+            float* dest = buffer.data();
+            runner.Run(name, bufferSize, 0, bufferSize, [&]
+                       {
+                          offset = Resampler::Read(&source, 1, (int)sampleData.size(), offset, .7317, &dest, 1, bufferSize, (Resampler::Quality)quality);
+                          if (offset >= sampleData.size())
+                             offset -= sampleData.size();
+                          sSink = sSink + buffer[0];
+                       });
+         }
+      }
+   }
+
+   template <typename VoiceType>
+   void RunVoiceBenchmark(BenchmarkRunner& runner, const std::string& name, IVoiceParams* params)
+   {
+      for (int bufferSize : kBufferSizes)
+      {
+         //voices size their loops from gBufferSize in places, so run each buffer size the way the app would
+         SetGlobalSampleRateAndBufferSize(gSampleRate, bufferSize);
+
+         for (int numVoices : kVoiceCounts)
+         {
+            std::vector<std::unique_ptr<VoiceType> > voices;
+            for (int i = 0; i < numVoices; ++i)
+            {
+               voices.push_back(std::make_unique<VoiceType>());
+               voices.back()->SetVoiceParams(params);
+               voices.back()->SetPitch(36 + (i * 7) % 48);
+               voices.back()->SetPan(ofMap(i % 5, 0, 4, -1, 1));
+            }
+
+            ChannelBuffer out(bufferSize);
+            out.SetNumActiveChannels(2);
+            double time = 0;
+            runner.Run(name, bufferSize, numVoices, bufferSize, [&]
+                       {
+                          out.Clear();
+                          for (auto& voice : voices)
+                          {
+                             //retrigger anything that has died away, so every voice costs what a held note would
+                             if (voice->IsDone(time))
+                                voice->Start(time, 1);
+                             voice->Process(time, &out, 1);
+                          }
+                          time += bufferSize * gInvSampleRateMs;
+                          sSink = sSink + Consume(out.GetChannel(0), bufferSize);
+                       });
+         }
+      }
+   }
+
+   void RunVoiceBenchmarks(BenchmarkRunner& runner)
+   {
+      FMVoiceParams fmParams;
+      fmParams.mOscADSRParams = ::ADSR(1, 100, .7f, 100);
+      fmParams.mModIdxADSRParams = ::ADSR(1, 100, .5f, 100);
+      fmParams.mHarmRatioADSRParams = ::ADSR(1, 1, 1, 1);
+      fmParams.mModIdxADSRParams2 = ::ADSR(1, 100, .5f, 100);
+      fmParams.mHarmRatioADSRParams2 = ::ADSR(1, 1, 1, 1);
+      fmParams.mModIdx = 2;
+      fmParams.mHarmRatio = 2;
+      fmParams.mModIdx2 = 1;
+      fmParams.mHarmRatio2 = 3;
+      RunVoiceBenchmark<FMVoice>(runner, "voice_fm", &fmParams);
+
+      OscillatorVoiceParams oscParams;
+      oscParams.mOscType = kOsc_Saw;
+      RunVoiceBenchmark<SingleOscillatorVoice>(runner, "voice_oscillator", &oscParams);
+
+      OscillatorVoiceParams unisonFilterParams;
+      unisonFilterParams.mOscType = kOsc_Saw;
+      unisonFilterParams.mUnison = 4;
+      unisonFilterParams.mUnisonWidth = .2f;
+      unisonFilterParams.mFilterCutoffMax = 4000;
+      RunVoiceBenchmark<SingleOscillatorVoice>(runner, "voice_oscillator_unison4_filter", &unisonFilterParams);
+
+      KarplusStrongVoiceParams karplusParams;
+      RunVoiceBenchmark<KarplusStrongVoice>(runner, "voice_karplusstrong", &karplusParams);
+
+      std::vector<float> sampleData(gSampleRate * 2);
+      for (size_t i = 0; i < sampleData.size(); ++i)
+         sampleData[i] = sin(i * GetPhaseInc(220));
+      SampleVoiceParams sampleParams;
+      sampleParams.mSampleData = sampleData.data();
+      sampleParams.mSampleLength = (int)sampleData.size();
+      sampleParams.mDetectedFreq = 220;
+      sampleParams.mLoop = true;
+      RunVoiceBenchmark<SampleVoice>(runner, "voice_sample", &sampleParams);
+   }
+
+   bool ParseArgs(int argc, char** argv, Options& options)
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         std::string arg = argv[i];
+         bool hasValue = i + 1 < argc;
+         if (arg == "--out" && hasValue)
+            options.mOutputPath = argv[++i];
+         else if (arg == "--filter" && hasValue)
+            options.mFilter = argv[++i];
+         else if (arg == "--samplerate" && hasValue)
+            options.mSampleRate = atoi(argv[++i]);
+         else if (arg == "--seconds" && hasValue)
+            options.mSecondsPerCase = atof(argv[++i]);
+         else
+            return false;
+      }
+      return options.mSampleRate > 0 && options.mSecondsPerCase > 0;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   Options options;
+   if (!ParseArgs(argc, argv, options))
+   {
+      std::cerr << "usage: BespokeBenchmarks [--out results.json] [--filter substring] [--samplerate rate] [--seconds per case]" << std::endl;
+      return 1;
+   }
+
+   juce::ScopedJuceInitialiser_GUI juceInitialiser;
+   juce::FloatVectorOperations::disableDenormalisedNumberSupport();
+
+   //the voices reach for TheScale and friends, so bring up a synth the same way the offline renderer does,
+   //without a device, a window, or a savestate
+   juce::Component mainComponent;
+   juce::AudioDeviceManager deviceManager;
+   juce::AudioFormatManager audioFormatManager;
+   auto synth = std::make_unique<ModularSynth>();
+   UserPrefs.Init();
+   UserPrefs.audio_threads.Get() = 1;
+   UserPrefs.oversampling.Get() = 1; //measure the kernels at the rate they're asked for
+   mainComponent.setSize(UserPrefs.width.Get(), UserPrefs.height.Get());
+   SetGlobalSampleRateAndBufferSize(options.mSampleRate, 256);
+   synth->Setup(&deviceManager, &audioFormatManager, &mainComponent, nullptr);
+
+   BenchmarkRunner runner(options);
+   RunKernelBenchmarks(runner);
+   RunVoiceBenchmarks(runner);
+
+   std::string json = runner.GetJson();
+   if (options.mOutputPath.empty())
+   {
+      std::cout << json << std::endl;
+   }
+   else if (!juce::File::getCurrentWorkingDirectory().getChildFile(options.mOutputPath).replaceWithText(json))
+   {
+      std::cerr << "couldn't write " << options.mOutputPath << std::endl;
+      return 1;
+   }
+
+   return 0;
+}